@@ -0,0 +1,169 @@
+#include <tree/bignum_backend.hpp>
+#include <fmt/format.h>
+#include <chrono>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Compares the BigNum backends on the number-size profiles of different deployments:
+// many small rationals, multiplication and normalized addition of large operands, decimal output.
+
+using namespace ezmath::tree;
+
+namespace {
+
+volatile int sink = 0;
+
+// Mean time of a call in nanoseconds; calls repeat for at least MIN_TIME
+template<class F>
+double Measure(F&& f) {
+    using Clock = std::chrono::steady_clock;
+    constexpr auto MIN_TIME = std::chrono::milliseconds{200};
+    size_t runs = 0;
+    const auto start = Clock::now();
+    auto now = start;
+    do {
+        f();
+        ++runs;
+        now = Clock::now();
+    } while (now - start < MIN_TIME);
+    return std::chrono::duration<double, std::nano>(now - start).count() / static_cast<double>(runs);
+}
+
+template<class B>
+bool Fits(const unsigned bits) {
+    using Limits = std::numeric_limits<typename B::Integer>;
+    return !Limits::is_bounded || 2 * bits < static_cast<unsigned>(Limits::digits);
+}
+
+// Dense operand of the given bit length
+template<class B>
+typename B::Integer Operand(const unsigned bits, const unsigned divisor) {
+    using Integer = typename B::Integer;
+    return ((Integer{1} << bits) - 1) / divisor;
+}
+
+template<class B>
+std::optional<double> SmallRationals() {
+    using Integer = typename B::Integer;
+    using Rational = typename B::Rational;
+    constexpr int OPS = 1000;
+    return Measure([] {
+        for (int i = 0; i < OPS; ++i) {
+            const Rational x{Integer{i % 97 + 1}, Integer{i % 89 + 1}};
+            const Rational y{Integer{i % 83 + 1}, Integer{i % 79 + 1}};
+            const Rational res = x * y + x / y - y;
+            sink = sink + res.sign();
+        }
+    }) / OPS;
+}
+
+template<class B>
+std::optional<double> Multiply(const unsigned bits) {
+    if (!Fits<B>(bits)) {
+        return std::nullopt;
+    }
+    const auto a = Operand<B>(bits, 3);
+    const auto b = Operand<B>(bits, 7);
+    return Measure([&] {
+        typename B::Integer res = a * b;
+        sink = sink + res.sign();
+    });
+}
+
+template<class B>
+std::optional<double> AddFractions(const unsigned bits) {
+    if (!Fits<B>(bits)) {
+        return std::nullopt;
+    }
+    using Rational = typename B::Rational;
+    const Rational a{Operand<B>(bits, 3), Operand<B>(bits, 7) + 2};
+    const Rational b{Operand<B>(bits, 11), Operand<B>(bits, 13) + 4};
+    return Measure([&] {
+        Rational res = a + b;
+        sink = sink + res.sign();
+    });
+}
+
+template<class B>
+std::optional<double> ToDecimal(const unsigned bits) {
+    if (!Fits<B>(bits)) {
+        return std::nullopt;
+    }
+    const auto a = Operand<B>(bits, 3);
+    return Measure([&] {
+        sink = sink + static_cast<int>(a.template convert_to<std::string>().size());
+    });
+}
+
+struct Workload {
+    std::string Name;
+    std::vector<std::optional<double>> Results;
+};
+
+template<class B>
+void Run(std::vector<Workload>& workloads) {
+    size_t i = 0;
+    const auto add = [&](std::string name, std::optional<double> res) {
+        if (workloads.size() <= i) {
+            workloads.push_back({std::move(name), {}});
+        }
+        workloads[i++].Results.push_back(res);
+    };
+
+    add("small rationals, per op", SmallRationals<B>());
+    for (const unsigned bits : {60u, 4096u, 262144u}) {
+        add(fmt::format("multiply {} bits", bits), Multiply<B>(bits));
+    }
+    for (const unsigned bits : {60u, 4096u}) {
+        add(fmt::format("add fractions {} bits", bits), AddFractions<B>(bits));
+    }
+    for (const unsigned bits : {60u, 262144u}) {
+        add(fmt::format("to decimal {} bits", bits), ToDecimal<B>(bits));
+    }
+}
+
+std::string Format(const std::optional<double> ns) {
+    if (!ns) {
+        return "n/a";
+    }
+    if (*ns >= 1e6) {
+        return fmt::format("{:.2f} ms", *ns / 1e6);
+    }
+    if (*ns >= 1e3) {
+        return fmt::format("{:.2f} us", *ns / 1e3);
+    }
+    return fmt::format("{:.1f} ns", *ns);
+}
+
+} // namespace
+
+int main() {
+    std::vector<std::string_view> names;
+    std::vector<Workload> workloads;
+
+    const auto run = [&]<class B>(B) {
+        names.push_back(B::NAME);
+        Run<B>(workloads);
+    };
+    run(backend::CppRational{});
+    run(backend::Int128{});
+#ifdef EZMATH_BIGNUM_GMP
+    run(backend::Gmp{});
+#endif
+
+    fmt::print("{:<28}", "");
+    for (const auto name : names) {
+        fmt::print("{:>16}", name);
+    }
+    fmt::print("\n");
+    for (const auto& workload : workloads) {
+        fmt::print("{:<28}", workload.Name);
+        for (const auto& res : workload.Results) {
+            fmt::print("{:>16}", Format(res));
+        }
+        fmt::print("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <tree/dense_polynomial.hpp>
+#include <fmt/format.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Times the dense multiplication algorithms against each other, to place the thresholds of
+// DensePolynomial::ChooseAlgorithm, and (x+1)^n through the sparse and dense representations.
+
+using namespace ezmath::tree;
+
+namespace {
+
+using Integer = DensePolynomial::Integer;
+using Algorithm = DensePolynomial::EAlgorithm;
+
+volatile size_t sink = 0;
+
+// Mean time of a call in microseconds; calls repeat for at least MIN_TIME
+template<class F>
+double Measure(F&& f) {
+    using Clock = std::chrono::steady_clock;
+    constexpr auto MIN_TIME = std::chrono::milliseconds{200};
+    size_t runs = 0;
+    const auto start = Clock::now();
+    auto now = start;
+    do {
+        f();
+        ++runs;
+        now = Clock::now();
+    } while (now - start < MIN_TIME);
+    return std::chrono::duration<double, std::micro>(now - start).count() / static_cast<double>(runs);
+}
+
+// Coefficients with the given bit length and varying signs
+std::vector<Integer> Operand(const size_t size, const unsigned bits, const unsigned divisor) {
+    std::vector<Integer> res;
+    res.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        Integer val = ((Integer{1} << bits) - 1) / (divisor + i % 5);
+        res.emplace_back(i % 3 ? val : Integer{-val});
+    }
+    return res;
+}
+
+} // namespace
+
+int main() {
+    fmt::print("{:<24}{:>14}{:>14}{:>14}\n", "", "schoolbook", "karatsuba", "ntt");
+    for (const unsigned bits : {30u, 256u}) {
+        for (const size_t size : {16u, 32u, 64u, 128u, 256u, 1024u}) {
+            const auto lhs = Operand(size, bits, 3);
+            const auto rhs = Operand(size, bits, 7);
+            fmt::print("{:<24}", fmt::format("{} x {} bits", size, bits));
+            for (const auto algorithm : {Algorithm::Schoolbook, Algorithm::Karatsuba, Algorithm::Ntt}) {
+                const auto us = Measure([&] { sink = sink + DensePolynomial::Multiply(lhs, rhs, algorithm).size(); });
+                fmt::print("{:>14}", fmt::format("{:.1f} us", us));
+            }
+            fmt::print("\n");
+        }
+    }
+
+    fmt::print("\n{:<24}{:>14}\n", "", "dense");
+    const auto base = DensePolynomial::Variable() + DensePolynomial::Constant(1);
+    for (const uint32_t exp : {100u, 500u, 2000u}) {
+        const auto us = Measure([&] { sink = sink + base.Pow(exp).Degree(); });
+        fmt::print("{:<24}{:>14}\n", fmt::format("(x+1)^{}", exp), fmt::format("{:.1f} us", us));
+    }
+    return 0;
+}
@@ -14,7 +14,7 @@ Napi::Value Simplify(const Napi::CallbackInfo& info) {
   std::string arg = info[0].As<Napi::String>();
 
   try {
-    auto tree = ezmath::parsing::ParseTree(arg);
+    auto tree = ezmath::parsing::ParseTree(arg, {.Fold = true});
     ezmath::tree::math::simplify(tree);
     return Napi::String::New(env, tree->ToString());
   } catch(const std::exception& ex) {
@@ -0,0 +1,356 @@
+#include <codegen/codegen.hpp>
+#include <tree/evalf.hpp>
+#include <tree/exception.hpp>
+#include <tree/hash_utils.hpp>
+#include <tree/traverse.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <set>
+#include <unordered_map>
+
+namespace ezmath::codegen {
+
+namespace {
+
+using tree::BigNum;
+using tree::IExpr;
+
+// Shortest addition chains are searched up to this exponent, binary ones are used beyond it
+constexpr uint32_t MAX_SEARCHED_CHAIN = 128;
+// Larger exponents are left to std::pow
+constexpr int64_t MAX_CHAIN_EXPONENT = int64_t{1} << 20;
+// Significant digits that pin down a double
+constexpr size_t DOUBLE_DIGITS = 17;
+
+constexpr std::string_view PROLOGUE =
+    "#include <cmath>\n"
+    "#include <cstddef>\n"
+    "\n"
+    "#ifndef EZMATH_VECTORIZE\n"
+    "#if defined(__clang__)\n"
+    "#define EZMATH_VECTORIZE _Pragma(\"clang loop vectorize(enable) interleave(enable)\")\n"
+    "#elif defined(__GNUC__)\n"
+    "#define EZMATH_VECTORIZE _Pragma(\"GCC ivdep\")\n"
+    "#else\n"
+    "#define EZMATH_VECTORIZE\n"
+    "#endif\n"
+    "#endif\n";
+
+bool ExtendChain(std::vector<uint32_t>& chain, const uint32_t target, const size_t steps) {
+    const auto last = chain.back();
+    if (last == target) {
+        return true;
+    }
+    if (steps == 0 || (uint64_t{last} << steps) < target) {
+        return false;
+    }
+    // Larger sums first, they get to the target in fewer steps
+    for (size_t i = chain.size(); i-- > 0;) {
+        for (size_t j = i + 1; j-- > 0;) {
+            const auto next = chain[i] + chain[j];
+            if (next <= last) {
+                break;
+            }
+            if (next > target) {
+                continue;
+            }
+            chain.push_back(next);
+            if (ExtendChain(chain, target, steps - 1)) {
+                return true;
+            }
+            chain.pop_back();
+        }
+    }
+    return false;
+}
+
+// Shortest 1 = a_0 < a_1 < ... < a_r = target where every element is the sum of two earlier
+// ones, by iterative deepening
+std::vector<uint32_t> AdditionChain(const uint32_t target) {
+    std::vector<uint32_t> chain{1};
+    for (size_t steps = 0; !ExtendChain(chain, target, steps); ++steps) {
+        chain.resize(1);
+    }
+    return chain;
+}
+
+std::string Product(std::string_view lhs, std::string_view rhs) {
+    return fmt::format("{} * {}", lhs, rhs);
+}
+
+class Generator {
+public:
+    explicit Generator(const std::vector<std::string>& arguments) {
+        for (size_t i = 0; i < arguments.size(); ++i) {
+            m_arguments.emplace(arguments[i], i);
+        }
+    }
+
+    // Emits the statements computing root and returns the name of its value. Nodes are named
+    // children first; a node named already, as an equal subtree or a literal, is not entered.
+    std::string Run(const IExpr& root) {
+        tree::traverse::PostOrder(root,
+            [this](const IExpr& node) {
+                if (!m_names.Find(node)) {
+                    m_names.Insert(node, Emit(node));
+                }
+            },
+            [this](const IExpr& node) {
+                if (m_names.Find(node)) {
+                    return false;
+                }
+                if (node.IsConstant()) {
+                    if (auto literal = Literal(node)) {
+                        m_names.Insert(node, std::move(*literal));
+                        return false;
+                    }
+                }
+                return true;
+            });
+        return Name(root);
+    }
+
+    const std::vector<std::string>& Statements() const noexcept {
+        return m_statements;
+    }
+
+private:
+    std::string Temp(const std::string& expr) {
+        auto name = fmt::format("t{}", m_statements.size());
+        m_statements.push_back(fmt::format("const double {} = {};", name, expr));
+        return name;
+    }
+
+    // Powers with negative exponents are named empty until a node other than a product needs
+    // them, since products divide by the positive power instead
+    std::string Name(const IExpr& node) {
+        auto& name = *m_names.Find(node);
+        if (name.empty()) {
+            const auto& power = *node.As<tree::Power>();
+            name = Temp(fmt::format("1.0 / {}", PowerOf(power.GetBase(), -power.GetExp().As<tree::Number>()->Value())));
+        }
+        return name;
+    }
+
+    // Rounded from the exact value, so literals are as precise as a double gets
+    std::optional<std::string> Literal(const IExpr& node) {
+        auto res = m_evaluator.Evalf(node, DOUBLE_DIGITS);
+        if (!res) {
+            return std::nullopt;
+        }
+        if (res->find_first_of(".e") == std::string::npos) {
+            *res += ".0";
+        }
+        return res->starts_with('-') ? fmt::format("({})", *res) : *res;
+    }
+
+    std::string Literal(const BigNum& value) {
+        auto res = Literal(tree::Number{value});
+        if (!res) {
+            throw tree::exception::CalcException{fmt::format("{} is out of the range of double", value.ToString())};
+        }
+        return *res;
+    }
+
+    std::string Emit(const IExpr& node) {
+        return tree::Match(node,
+            [this](const tree::Number& number) { return Literal(number.Value()); },
+            [this](const tree::Symbol& symbol) {
+                const auto it = m_arguments.find(symbol.Name());
+                if (it == m_arguments.end()) {
+                    throw tree::exception::CalcException{fmt::format("symbol {} is not an argument", symbol.Name())};
+                }
+                return fmt::format("a{}", it->second);
+            },
+            [this](const tree::Sum& sum) {
+                std::string res;
+                if (sum.GetConstant().Sign() != 0) {
+                    res = Literal(sum.GetConstant());
+                }
+                for (const auto& term : sum.GetTerms()) {
+                    res += res.empty() ? Name(*term.Expression) : fmt::format(" + {}", Name(*term.Expression));
+                }
+                return Temp(res);
+            },
+            [this](const tree::Product& product) {
+                std::string numerator;
+                std::string denominator;
+                const auto append = [](std::string& to, const std::string& value) {
+                    to = to.empty() ? value : Product(to, value);
+                };
+                const auto& coefficient = product.GetCoefficient();
+                if (coefficient.Abs() != 1) {
+                    append(numerator, Literal(coefficient.Abs()));
+                }
+                tree::traverse::ForEachChild(product, [&](const IExpr& factor) {
+                    if (m_names.Find(factor)->empty()) {
+                        const auto& power = *factor.As<tree::Power>();
+                        append(denominator, PowerOf(power.GetBase(), -power.GetExp().As<tree::Number>()->Value()));
+                    } else {
+                        append(numerator, Name(factor));
+                    }
+                });
+                auto res = numerator.empty() ? std::string{"1.0"} : std::move(numerator);
+                if (!denominator.empty()) {
+                    const auto single = denominator.find(' ') == std::string::npos;
+                    res = single ? fmt::format("{} / {}", res, denominator) : fmt::format("{} / ({})", res, denominator);
+                }
+                return Temp(coefficient.Sign() < 0 ? fmt::format("-({})", res) : res);
+            },
+            [this](const tree::Power& power) {
+                if (!power.GetExp().Is<tree::Number>()) {
+                    return Temp(fmt::format("std::pow({}, {})", Name(power.GetBase()), Name(power.GetExp())));
+                }
+                const auto& exp = power.GetExp().As<tree::Number>()->Value();
+                return exp < 0 ? std::string{} : PowerOf(power.GetBase(), exp);
+            },
+            [this](const tree::Log& log) {
+                return Temp(fmt::format("std::log({})", Name(log.GetArgument())));
+            },
+            [](const tree::Matrix&) -> std::string {
+                throw tree::exception::CalcException{"code generation does not support matrices"};
+            });
+    }
+
+    // base^exp for exp > 0, from the powers of the base computed so far
+    std::string PowerOf(const IExpr& base, const BigNum& exp) {
+        auto& powers = m_powers.Insert(base, {}).first;
+        if (powers.empty()) {
+            powers.emplace(BigNum{1}, Name(base));
+        }
+        if (const auto it = powers.find(exp); it != powers.end()) {
+            return it->second;
+        }
+
+        const auto [num, den] = exp.Decompose();
+        std::string res;
+        if (den == 1 && num <= MAX_CHAIN_EXPONENT) {
+            return IntegerPower(powers, static_cast<uint32_t>(num));
+        } else if ((den == 2 || den == 3) && num <= MAX_CHAIN_EXPONENT) {
+            // x^{n/d} = x^{[n/d]} * (x^{1/d})^{n mod d}
+            const auto whole = static_cast<uint32_t>(num / den);
+            const auto rest = static_cast<int64_t>(num % den);
+            const auto root = PowerOf(powers, BigNum{tree::BigNum::Backend::Fraction(1, den)}, [&] {
+                return Temp(fmt::format("{}({})", den == 2 ? "std::sqrt" : "std::cbrt", powers.at(1)));
+            });
+            res = rest == 1 ? root : PowerOf(powers, BigNum{tree::BigNum::Backend::Fraction(2, 3)}, [&] {
+                return Temp(Product(root, root));
+            });
+            if (whole) {
+                res = Temp(Product(IntegerPower(powers, whole), res));
+            }
+        } else {
+            res = Temp(fmt::format("std::pow({}, {})", powers.at(1), Literal(exp)));
+        }
+        powers.emplace(exp, res);
+        return res;
+    }
+
+    template<class F>
+    static std::string PowerOf(std::map<BigNum, std::string>& powers, const BigNum& exp, F&& compute) {
+        if (const auto it = powers.find(exp); it != powers.end()) {
+            return it->second;
+        }
+        return powers.emplace(exp, compute()).first->second;
+    }
+
+    std::string IntegerPower(std::map<BigNum, std::string>& powers, const uint32_t exp) {
+        if (const auto it = powers.find(exp); it != powers.end()) {
+            return it->second;
+        }
+        // One multiplication if two powers computed so far add up to exp
+        for (const auto& [lhs, name] : powers) {
+            if (lhs.IsInteger() && lhs * 2 <= BigNum{exp}) {
+                if (const auto it = powers.find(BigNum{exp} - lhs); it != powers.end()) {
+                    return powers.emplace(exp, Temp(Product(name, it->second))).first->second;
+                }
+            }
+        }
+        if (exp > MAX_SEARCHED_CHAIN) {
+            const auto half = IntegerPower(powers, exp / 2);
+            auto res = exp % 2 ? Product(Temp(Product(half, half)), powers.at(1)) : Product(half, half);
+            return powers.emplace(exp, Temp(res)).first->second;
+        }
+        const auto chain = AdditionChain(exp);
+        for (size_t k = 1; k < chain.size(); ++k) {
+            if (powers.contains(chain[k])) {
+                continue;
+            }
+            for (size_t i = 0; i < k; ++i) {
+                if (const auto j = std::ranges::find(chain.begin(), chain.begin() + k, chain[k] - chain[i]); j != chain.begin() + k) {
+                    powers.emplace(chain[k], Temp(Product(powers.at(chain[i]), powers.at(*j))));
+                    break;
+                }
+            }
+        }
+        return powers.at(exp);
+    }
+
+private:
+    std::unordered_map<std::string_view, size_t> m_arguments;
+    tree::hash::FingerprintIndex<std::string> m_names;
+    // Powers of a base computed so far by exponent, starting with the base itself as power 1
+    tree::hash::FingerprintIndex<std::map<BigNum, std::string>> m_powers;
+    tree::Evaluator m_evaluator;
+    std::vector<std::string> m_statements;
+};
+
+std::vector<std::string> SymbolsOf(const IExpr& expr) {
+    std::set<std::string, std::less<>> symbols;
+    tree::traverse::PreOrder(expr, [&symbols](const IExpr& node) {
+        if (node.Is<tree::Symbol>()) {
+            symbols.emplace(node.As<tree::Symbol>()->Name());
+        }
+        return !node.IsConstant();
+    });
+    return {symbols.begin(), symbols.end()};
+}
+
+}
+
+Code Generate(const IExpr& expr, const Options& options) {
+    Code res{options.Name, options.Batch ? options.Name + "_batch" : std::string{}, options.Arguments, {}};
+    if (res.Arguments.empty()) {
+        res.Arguments = SymbolsOf(expr);
+    }
+
+    Generator generator{res.Arguments};
+    const auto value = generator.Run(expr);
+
+    auto& out = res.Source;
+    out = fmt::format("// Generated by ezmath from {}\n", expr.ToString());
+    out += PROLOGUE;
+    out += "\nextern \"C\" {\n";
+
+    out += fmt::format("\ndouble {}(const double* args) {{\n", res.Scalar);
+    for (size_t i = 0; i < res.Arguments.size(); ++i) {
+        out += fmt::format("    const double a{} = args[{}]; // {}\n", i, i, res.Arguments[i]);
+    }
+    for (const auto& statement : generator.Statements()) {
+        out += fmt::format("    {}\n", statement);
+    }
+    out += fmt::format("    return {};\n}}\n", value);
+
+    if (options.Batch) {
+        out += fmt::format("\nvoid {}(size_t count, const double* const* args, double* __restrict out) {{\n", res.Batch);
+        for (size_t i = 0; i < res.Arguments.size(); ++i) {
+            out += fmt::format("    const double* __restrict in{} = args[{}]; // {}\n", i, i, res.Arguments[i]);
+        }
+        out += "    EZMATH_VECTORIZE\n";
+        out += "    for (size_t i = 0; i < count; ++i) {\n";
+        for (size_t i = 0; i < res.Arguments.size(); ++i) {
+            out += fmt::format("        const double a{} = in{}[i];\n", i, i);
+        }
+        for (const auto& statement : generator.Statements()) {
+            out += fmt::format("        {}\n", statement);
+        }
+        out += fmt::format("        out[i] = {};\n    }}\n}}\n", value);
+    }
+
+    out += "\n}\n";
+    return res;
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <string>
+#include <vector>
+
+namespace ezmath::codegen {
+
+struct Options {
+    // Name of the scalar function; the loop is named <Name>_batch
+    std::string Name = "ezmath_eval";
+    // Symbols in the order the functions take their values; empty for the symbols of the tree
+    // sorted by name
+    std::vector<std::string> Arguments;
+    // Also emit the loop over arrays of arguments
+    bool Batch = true;
+};
+
+// Self-contained C++ source of extern "C" functions of doubles, which needs only <cmath>:
+//   double <Scalar>(const double* args);
+//   void <Batch>(size_t count, const double* const* args, double* out);
+// args holds the values of Arguments in order; for the loop, one array of count values per
+// argument, and out receives count results.
+struct Code {
+    std::string Scalar;
+    // Empty unless Options::Batch
+    std::string Batch;
+    std::vector<std::string> Arguments;
+    std::string Source;
+};
+
+// Emits straight-line code for expr, best simplified first:
+//  - equal subtrees, found by fingerprint, are computed once into a local;
+//  - constant subtrees become literals, rounded from an exact evaluation;
+//  - integer powers are computed by shortest addition chains, sharing the intermediate powers
+//    of a base across the whole tree, and x^{n/2}, x^{n/3} use sqrt and cbrt;
+//  - factors with negative integer exponents go to one division per product.
+// The loop is a plain pass over restrict-qualified arrays that compilers vectorize; sqrt needs
+// -fno-math-errno for that, and pow and log vectorize only where the math library has vector
+// variants, e.g. with -ffast-math and glibc. Throws CalcException for matrices and for symbols
+// missing from Arguments.
+Code Generate(const tree::IExpr& expr, const Options& options = {});
+
+}
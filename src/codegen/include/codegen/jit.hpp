@@ -0,0 +1,51 @@
+#pragma once
+
+#include <codegen/codegen.hpp>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace ezmath::codegen {
+
+struct CompileOptions {
+    // Empty for $CXX, or c++ if that is unset
+    std::string Compiler;
+    // The generated code never reads errno, so the math calls need not set it
+    std::vector<std::string> Flags = {"-O3", "-march=native", "-fno-math-errno"};
+};
+
+// Generated code compiled by the system compiler into a shared library and loaded into the
+// process; the library is unloaded with the last owner
+class CompiledFunction {
+public:
+    using Scalar = double (*)(const double*);
+    using Batch = void (*)(size_t, const double* const*, double*);
+
+    // Throws std::runtime_error with the compiler's output if the source does not build
+    static CompiledFunction Compile(const Code& code, const CompileOptions& options = {});
+
+    CompiledFunction(CompiledFunction&& other) noexcept;
+    CompiledFunction& operator=(CompiledFunction&& other) noexcept;
+    ~CompiledFunction();
+
+    // Checks the number of arguments and throws std::invalid_argument if it differs
+    double operator()(std::span<const double> args) const;
+    // args holds one span per argument, all of out.size() values
+    void operator()(std::span<const std::span<const double>> args, std::span<double> out) const;
+
+    Scalar GetScalar() const noexcept { return m_scalar; }
+    // Null unless the code has a loop
+    Batch GetBatch() const noexcept { return m_batch; }
+    size_t Arity() const noexcept { return m_arity; }
+
+private:
+    CompiledFunction(void* handle, Scalar scalar, Batch batch, size_t arity) noexcept;
+
+    void* m_handle;
+    Scalar m_scalar;
+    Batch m_batch;
+    size_t m_arity;
+};
+
+}
@@ -0,0 +1,184 @@
+#include <codegen/jit.hpp>
+#include <fmt/format.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+extern char** environ;
+
+namespace ezmath::codegen {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// Removes the build directory however compilation ends
+class TempDir {
+public:
+    TempDir() {
+        auto pattern = (fs::temp_directory_path() / "ezmath-jit-XXXXXX").string();
+        if (!mkdtemp(pattern.data())) {
+            throw std::runtime_error{fmt::format("cannot create a directory from {}", pattern)};
+        }
+        m_path = pattern;
+    }
+
+    ~TempDir() {
+        std::error_code ignored;
+        fs::remove_all(m_path, ignored);
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    const fs::path& Path() const noexcept {
+        return m_path;
+    }
+
+private:
+    fs::path m_path;
+};
+
+std::string ReadFile(const fs::path& path) {
+    std::ifstream in{path};
+    std::stringstream res;
+    res << in.rdbuf();
+    return res.str();
+}
+
+// Runs the command with its output going to log; returns the exit status or -1
+int Run(std::vector<std::string> command, const fs::path& log) {
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+
+    std::vector<char*> argv;
+    for (auto& arg : command) {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    const auto error = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (error) {
+        return -1;
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return -1;
+        }
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+std::string CompilerOf(const CompileOptions& options) {
+    if (!options.Compiler.empty()) {
+        return options.Compiler;
+    }
+    const auto* cxx = std::getenv("CXX");
+    return cxx && *cxx ? cxx : "c++";
+}
+
+}
+
+CompiledFunction CompiledFunction::Compile(const Code& code, const CompileOptions& options) {
+    TempDir dir;
+    const auto source = dir.Path() / "function.cpp";
+    const auto library = dir.Path() / "function.so";
+    const auto log = dir.Path() / "compiler.log";
+    std::ofstream{source} << code.Source;
+
+    std::vector<std::string> command{CompilerOf(options)};
+    command.insert(command.end(), options.Flags.begin(), options.Flags.end());
+    command.insert(command.end(), {"-shared", "-fPIC", "-o", library.string(), source.string()});
+    if (const auto status = Run(command, log); status != 0) {
+        throw std::runtime_error{status < 0
+            ? fmt::format("cannot run {}", command.front())
+            : fmt::format("{} failed:\n{}", command.front(), ReadFile(log))};
+    }
+
+    // The library stays mapped after its file is removed
+    auto* handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        throw std::runtime_error{fmt::format("cannot load the compiled code: {}", dlerror())};
+    }
+    const auto scalar = reinterpret_cast<Scalar>(dlsym(handle, code.Scalar.c_str()));
+    const auto batch = code.Batch.empty() ? nullptr : reinterpret_cast<Batch>(dlsym(handle, code.Batch.c_str()));
+    if (!scalar || (!code.Batch.empty() && !batch)) {
+        dlclose(handle);
+        throw std::runtime_error{fmt::format("the compiled code lacks {}", code.Scalar)};
+    }
+    return CompiledFunction{handle, scalar, batch, code.Arguments.size()};
+}
+
+CompiledFunction::CompiledFunction(void* handle, Scalar scalar, Batch batch, size_t arity) noexcept
+    : m_handle(handle)
+    , m_scalar(scalar)
+    , m_batch(batch)
+    , m_arity(arity)
+{}
+
+CompiledFunction::CompiledFunction(CompiledFunction&& other) noexcept
+    : m_handle(std::exchange(other.m_handle, nullptr))
+    , m_scalar(std::exchange(other.m_scalar, nullptr))
+    , m_batch(std::exchange(other.m_batch, nullptr))
+    , m_arity(other.m_arity)
+{}
+
+CompiledFunction& CompiledFunction::operator=(CompiledFunction&& other) noexcept {
+    if (this != &other) {
+        if (m_handle) {
+            dlclose(m_handle);
+        }
+        m_handle = std::exchange(other.m_handle, nullptr);
+        m_scalar = std::exchange(other.m_scalar, nullptr);
+        m_batch = std::exchange(other.m_batch, nullptr);
+        m_arity = other.m_arity;
+    }
+    return *this;
+}
+
+CompiledFunction::~CompiledFunction() {
+    if (m_handle) {
+        dlclose(m_handle);
+    }
+}
+
+double CompiledFunction::operator()(std::span<const double> args) const {
+    if (args.size() != m_arity) {
+        throw std::invalid_argument{fmt::format("expected {} arguments, got {}", m_arity, args.size())};
+    }
+    return m_scalar(args.data());
+}
+
+void CompiledFunction::operator()(std::span<const std::span<const double>> args, std::span<double> out) const {
+    if (!m_batch) {
+        throw std::logic_error{"the function was generated without a loop"};
+    }
+    if (args.size() != m_arity) {
+        throw std::invalid_argument{fmt::format("expected {} arguments, got {}", m_arity, args.size())};
+    }
+    std::vector<const double*> columns;
+    columns.reserve(args.size());
+    for (const auto& column : args) {
+        if (column.size() != out.size()) {
+            throw std::invalid_argument{fmt::format("expected {} values per argument, got {}", out.size(), column.size())};
+        }
+        columns.push_back(column.data());
+    }
+    m_batch(out.size(), columns.data(), out.data());
+}
+
+}
@@ -0,0 +1,86 @@
+#include "cache.hpp"
+#include <parsing/parser.hpp>
+#include <tree/math.hpp>
+
+namespace ezmath::driver {
+
+ResultCache::ResultCache(const size_t capacity)
+    : m_capacity{capacity}
+{}
+
+std::optional<ResultCache::Result> ResultCache::Find(const std::string_view text) {
+    std::lock_guard lock{m_mutex};
+    const auto it = m_byText.find(text);
+    if (it == m_byText.end()) {
+        return std::nullopt;
+    }
+    Touch(it->second);
+    return it->second->Value;
+}
+
+std::optional<ResultCache::Result> ResultCache::Find(const tree::IExpr& structure) {
+    const auto fingerprint = structure.Fingerprint();
+    std::lock_guard lock{m_mutex};
+    const auto it = m_byStructure.find(fingerprint);
+    // Equal fingerprints are likely but not certain to be equal trees
+    if (it == m_byStructure.end() || !it->second->Structure->IsEqualTo(structure)) {
+        return std::nullopt;
+    }
+    Touch(it->second);
+    return it->second->Value;
+}
+
+void ResultCache::Insert(const std::string_view text, const bool parses, Result result) {
+    // Built aside and spliced in, so that the text the structure views into never moves
+    Entries node;
+    node.push_front({std::string{text}, nullptr, std::move(result), 0});
+    auto& added = node.front();
+    if (parses) {
+        added.Structure = tree::math::freeze(parsing::ParseTree(added.Text, {.Fold = true}));
+    }
+    const auto bytes = text.size() + added.Value.Text.size() + ENTRY_OVERHEAD + (added.Structure ? added.Structure->Meta().Size * NODE_BYTES : 0);
+    if (bytes > m_capacity) {
+        return;
+    }
+    added.Bytes = bytes;
+    std::lock_guard lock{m_mutex};
+    if (const auto it = m_byText.find(text); it != m_byText.end()) {
+        Erase(it->second);
+    }
+    m_entries.splice(m_entries.begin(), node);
+    const auto entry = m_entries.begin();
+    m_byText.emplace(entry->Text, entry);
+    if (entry->Structure) {
+        m_byStructure.insert_or_assign(entry->Structure->Fingerprint(), entry);
+    }
+    ++m_counters.Entries;
+    m_counters.Bytes += bytes;
+    while (m_counters.Bytes > m_capacity) {
+        Erase(std::prev(m_entries.end()));
+        ++m_counters.Evictions;
+    }
+}
+
+ResultCache::Counters ResultCache::GetCounters() const {
+    std::lock_guard lock{m_mutex};
+    return m_counters;
+}
+
+void ResultCache::Touch(const Entries::iterator it) {
+    m_entries.splice(m_entries.begin(), m_entries, it);
+}
+
+void ResultCache::Erase(const Entries::iterator it) {
+    m_byText.erase(it->Text);
+    if (it->Structure) {
+        // Another text of the same structure may have taken the key over
+        if (const auto fnd = m_byStructure.find(it->Structure->Fingerprint()); fnd != m_byStructure.end() && fnd->second == it) {
+            m_byStructure.erase(fnd);
+        }
+    }
+    --m_counters.Entries;
+    m_counters.Bytes -= it->Bytes;
+    m_entries.erase(it);
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <tree/fingerprint.hpp>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ezmath::driver {
+
+// Results shared by all clients of the server, least recently used evicted first once the
+// entries take more than the capacity in bytes. Entries are found by input text, or by the
+// parsed input, so that spellings of the same tree share a result: the tree is looked up by
+// its fingerprint and compared with the one kept in the entry.
+class ResultCache {
+public:
+    struct Result {
+        std::string Text;
+        bool Failed = false;
+    };
+
+    struct Counters {
+        size_t Entries = 0;
+        size_t Bytes = 0;
+        size_t Evictions = 0;
+    };
+
+    explicit ResultCache(size_t capacity);
+
+    std::optional<Result> Find(std::string_view text);
+    std::optional<Result> Find(const tree::IExpr& structure);
+    // A result stored under the text replaces an older one; if the text parses, the tree is
+    // kept to confirm lookups by structure. It is parsed again from the copy of the text the
+    // entry owns, since its symbols view into the text they were parsed from
+    void Insert(std::string_view text, bool parses, Result result);
+
+    Counters GetCounters() const;
+
+private:
+    struct Entry {
+        std::string Text;
+        tree::SharedExpr Structure;
+        Result Value;
+        size_t Bytes;
+    };
+    using Entries = std::list<Entry>;
+
+    void Touch(Entries::iterator it);
+    void Erase(Entries::iterator it);
+
+private:
+    // Bookkeeping of an entry besides its strings: list and table nodes
+    static constexpr size_t ENTRY_OVERHEAD = 160;
+    // Estimate per node of a kept tree
+    static constexpr size_t NODE_BYTES = 128;
+
+    mutable std::mutex m_mutex;
+    size_t m_capacity;
+    Counters m_counters;
+    // Most recently used first
+    Entries m_entries;
+    std::unordered_map<std::string_view, Entries::iterator> m_byText;
+    std::unordered_map<tree::hash::Fingerprint, Entries::iterator, tree::hash::FingerprintHash> m_byStructure;
+};
+
+}
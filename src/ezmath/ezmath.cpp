@@ -1,3 +1,135 @@
-int main() {
+#include "pipeline.hpp"
+#include "server.hpp"
+#include <fmt/format.h>
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace {
+
+constexpr std::string_view USAGE =
+    "Usage: ezmath [options] [file]\n"
+    "       ezmath --serve [--socket PATH] [options]\n"
+    "Simplifies one LaTeX formula per line of file (stdin if absent or -) and prints the\n"
+    "results to stdout in input order. Failed lines print \"error: <reason>\".\n"
+    "\n"
+    "With --serve, answers JSON requests, one per line, on stdin/stdout or on a Unix domain\n"
+    "socket: {\"id\":1,\"expr\":\"...\"} gets {\"id\":1,\"result\":\"...\"} or {\"id\":1,\"error\":\"...\"},\n"
+    "and {\"op\":\"stats\"} gets throughput, cache and latency counters.\n"
+    "\n"
+    "  -j, --threads N   worker threads, default: all cores\n"
+    "  -b, --batch N     lines (requests with --serve) handed to a worker at once,\n"
+    "                    default: 64 (32)\n"
+    "  -q, --quiet       do not print the summary to stderr\n"
+    "      --serve       run as a server until input ends or, with --socket, forever\n"
+    "      --socket PATH listen on a Unix domain socket at PATH instead of stdin/stdout\n"
+    "      --cache-mb N  memory of cached results with --serve, default: 64\n"
+    "  -h, --help        print this message\n";
+
+std::optional<size_t> ParseCount(const std::string_view str) {
+    size_t res = 0;
+    const auto [end, error] = std::from_chars(str.data(), str.data() + str.size(), res);
+    if (error != std::errc{} || end != str.data() + str.size() || res == 0) {
+        return std::nullopt;
+    }
+    return res;
+}
+
+int Usage(std::FILE* out, const int code) {
+    fmt::print(out, "{}", USAGE);
+    return code;
+}
+
+}
+
+int main(int argc, char** argv) {
+    using namespace ezmath::driver;
+
+    Options options;
+    ServerOptions serverOptions;
+    std::string path = "-";
+    std::optional<std::string> socket;
+    bool serve = false;
+    bool quiet = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            return Usage(stdout, 0);
+        }
+        if (arg == "-q" || arg == "--quiet") {
+            quiet = true;
+        } else if (arg == "--serve") {
+            serve = true;
+        } else if (arg == "--socket") {
+            if (i + 1 == argc) {
+                fmt::print(stderr, "ezmath: {} expects a path\n", arg);
+                return Usage(stderr, 2);
+            }
+            socket = argv[++i];
+        } else if (arg == "-j" || arg == "--threads" || arg == "-b" || arg == "--batch" || arg == "--cache-mb") {
+            const auto value = i + 1 < argc ? ParseCount(argv[++i]) : std::nullopt;
+            if (!value) {
+                fmt::print(stderr, "ezmath: {} expects a positive number\n", arg);
+                return Usage(stderr, 2);
+            }
+            if (arg == "-j" || arg == "--threads") {
+                options.Threads = serverOptions.Threads = *value;
+            } else if (arg == "--cache-mb") {
+                serverOptions.CacheBytes = *value << 20;
+            } else {
+                options.BatchLines = serverOptions.MaxBatch = *value;
+            }
+        } else if (arg.starts_with('-') && arg != "-") {
+            fmt::print(stderr, "ezmath: unknown option {}\n", arg);
+            return Usage(stderr, 2);
+        } else {
+            path = arg;
+        }
+    }
+
+    if (socket && !serve) {
+        fmt::print(stderr, "ezmath: --socket requires --serve\n");
+        return Usage(stderr, 2);
+    }
+    if (serve && path != "-") {
+        fmt::print(stderr, "ezmath: --serve reads no file\n");
+        return Usage(stderr, 2);
+    }
+
+    if (serve) {
+        // Clients that hang up must not take the server down with them
+        std::signal(SIGPIPE, SIG_IGN);
+        try {
+            Server server{serverOptions};
+            if (socket) {
+                server.ServeSocket(*socket);
+            }
+            server.ServeStream(0, 1);
+        } catch (const std::exception& ex) {
+            fmt::print(stderr, "ezmath: {}\n", ex.what());
+            return 1;
+        }
+        return 0;
+    }
+
+    try {
+        const auto input = LineReader::Open(path);
+        std::setvbuf(stdout, nullptr, _IOFBF, 1 << 16);
+        const auto summary = Run(*input, stdout, options);
+        if (std::fflush(stdout) != 0 || std::ferror(stdout)) {
+            fmt::print(stderr, "ezmath: failed to write the results\n");
+            return 1;
+        }
+        if (!quiet) {
+            PrintSummary(summary, stderr);
+        }
+    } catch (const std::exception& ex) {
+        fmt::print(stderr, "ezmath: {}\n", ex.what());
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace ezmath::driver {
+
+// Latencies in nanoseconds on log-linear buckets: SUB_BUCKETS linear buckets per power of two,
+// so a percentile is within 1/SUB_BUCKETS of the true value and the memory is fixed however
+// many samples arrive. Not thread-safe: every worker fills its own, and they are merged.
+class Histogram {
+public:
+    void Add(const uint64_t ns) noexcept {
+        ++m_buckets[Bucket(ns)];
+        ++m_count;
+        m_max = ns > m_max ? ns : m_max;
+    }
+
+    void Merge(const Histogram& other) noexcept {
+        for (size_t i = 0; i < m_buckets.size(); ++i) {
+            m_buckets[i] += other.m_buckets[i];
+        }
+        m_count += other.m_count;
+        m_max = other.m_max > m_max ? other.m_max : m_max;
+    }
+
+    uint64_t Count() const noexcept { return m_count; }
+    uint64_t Max() const noexcept { return m_max; }
+
+    // Upper bound of the bucket holding the sample of rank p * Count(), p in [0, 1]
+    uint64_t Percentile(const double p) const noexcept {
+        if (m_count == 0) {
+            return 0;
+        }
+        const auto rank = static_cast<uint64_t>(p * static_cast<double>(m_count - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_buckets.size(); ++i) {
+            seen += m_buckets[i];
+            if (seen >= rank) {
+                return UpperBound(i) < m_max ? UpperBound(i) : m_max;
+            }
+        }
+        return m_max;
+    }
+
+private:
+    static constexpr unsigned SUB_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BITS;
+
+    static size_t Bucket(const uint64_t ns) noexcept {
+        if (ns < SUB_BUCKETS) {
+            return ns;
+        }
+        const unsigned shift = std::bit_width(ns) - 1 - SUB_BITS;
+        return (shift + 1) * SUB_BUCKETS + ((ns >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    static uint64_t UpperBound(const size_t bucket) noexcept {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        const auto shift = bucket / SUB_BUCKETS - 1;
+        return ((SUB_BUCKETS + bucket % SUB_BUCKETS + 1) << shift) - 1;
+    }
+
+    std::array<uint64_t, (64 - SUB_BITS + 1) * SUB_BUCKETS> m_buckets{};
+    uint64_t m_count = 0;
+    uint64_t m_max = 0;
+};
+
+}
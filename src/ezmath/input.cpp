@@ -0,0 +1,159 @@
+#include "input.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ezmath::driver {
+
+namespace {
+
+std::string_view TrimLine(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return line;
+}
+
+}
+
+std::unique_ptr<LineReader> LineReader::Open(const std::string& path) {
+    if (path == "-") {
+        return std::make_unique<StreamReader>(stdin);
+    }
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error{errno, std::generic_category(), path};
+    }
+    if (auto mapped = MappedReader::Map(fd)) {
+        ::close(fd);
+        return mapped;
+    }
+    auto* file = ::fdopen(fd, "r");
+    if (!file) {
+        const auto error = errno;
+        ::close(fd);
+        throw std::system_error{error, std::generic_category(), path};
+    }
+    return std::make_unique<StreamReader>(file);
+}
+
+MappedReader::MappedReader(const char* data, const size_t size) noexcept
+    : m_data{data}
+    , m_size{size}
+{}
+
+std::unique_ptr<MappedReader> MappedReader::Map(const int fd) {
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)) {
+        return nullptr;
+    }
+    const auto size = static_cast<size_t>(info.st_size);
+    if (size == 0) {
+        return std::unique_ptr<MappedReader>{new MappedReader{nullptr, 0}};
+    }
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    ::madvise(data, size, MADV_SEQUENTIAL);
+    return std::unique_ptr<MappedReader>{new MappedReader{static_cast<const char*>(data), size}};
+}
+
+MappedReader::~MappedReader() {
+    if (m_data) {
+        ::munmap(const_cast<char*>(m_data), m_size);
+    }
+}
+
+bool MappedReader::Read(Batch& batch, const size_t maxLines) {
+    batch.Lines.clear();
+    while (batch.Lines.size() < maxLines && m_offset < m_size) {
+        const auto* begin = m_data + m_offset;
+        const auto* newline = static_cast<const char*>(std::memchr(begin, '\n', m_size - m_offset));
+        const auto* end = newline ? newline : m_data + m_size;
+        batch.Lines.push_back(TrimLine({begin, static_cast<size_t>(end - begin)}));
+        m_offset = static_cast<size_t>(end - m_data) + (newline ? 1 : 0);
+    }
+    return !batch.Lines.empty();
+}
+
+size_t MappedReader::Consumed() const noexcept {
+    return m_offset;
+}
+
+StreamReader::StreamReader(std::FILE* file, const size_t blockSize) noexcept
+    : m_file{file}
+    , m_blockSize{std::max<size_t>(blockSize, 1)}
+{}
+
+StreamReader::~StreamReader() {
+    if (m_file != stdin) {
+        std::fclose(m_file);
+    }
+}
+
+bool StreamReader::Read(Batch& batch, const size_t maxLines) {
+    batch.Lines.clear();
+    batch.Blocks.clear();
+    while (batch.Lines.size() < maxLines) {
+        if (!m_block || m_offset == m_block->size()) {
+            if (m_eof) {
+                break;
+            }
+            Refill();
+            continue;
+        }
+        const std::string_view rest = std::string_view{*m_block}.substr(m_offset);
+        auto length = rest.find('\n');
+        if (length == std::string_view::npos) {
+            // The last line of the input may have no newline
+            if (!m_eof) {
+                Refill();
+                continue;
+            }
+            length = rest.size();
+        }
+        if (batch.Blocks.empty() || batch.Blocks.back() != m_block) {
+            batch.Blocks.push_back(m_block);
+        }
+        batch.Lines.push_back(TrimLine(rest.substr(0, length)));
+        const auto consumed = std::min(length + 1, rest.size());
+        m_offset += consumed;
+        m_consumed += consumed;
+    }
+    return !batch.Lines.empty();
+}
+
+void StreamReader::Refill() {
+    const auto rest = m_block ? m_block->size() - m_offset : 0;
+    // A line longer than a block doubles the read, so that it is not copied once per block
+    const auto size = std::max(m_blockSize, rest);
+    if (!m_block || m_block.use_count() > 1) {
+        auto block = std::make_shared<std::string>();
+        block->reserve(rest + size);
+        if (m_block) {
+            block->append(*m_block, m_offset);
+        }
+        m_block = std::move(block);
+    } else {
+        m_block->erase(0, m_offset);
+    }
+    m_offset = 0;
+    m_block->resize(rest + size);
+    const auto read = std::fread(m_block->data() + rest, 1, size, m_file);
+    m_block->resize(rest + read);
+    if (read < size) {
+        m_eof = true;
+    }
+}
+
+size_t StreamReader::Consumed() const noexcept {
+    return m_consumed;
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ezmath::driver {
+
+// Lines of input handed to a worker at once. Lines point into the mapped file or into Blocks,
+// which the batch keeps alive until it is refilled.
+struct Batch {
+    std::vector<std::shared_ptr<const std::string>> Blocks;
+    std::vector<std::string_view> Lines;
+    std::vector<std::string> Results;
+};
+
+// Newline-delimited formulas; a trailing '\r' is not part of a line
+class LineReader {
+public:
+    virtual ~LineReader() = default;
+
+    // Maps regular files and streams anything else; "-" is stdin. Throws std::system_error.
+    static std::unique_ptr<LineReader> Open(const std::string& path);
+
+    // Replaces the lines of batch with up to maxLines next lines, false once the input is over
+    virtual bool Read(Batch& batch, size_t maxLines) = 0;
+    // Bytes consumed so far
+    virtual size_t Consumed() const noexcept = 0;
+};
+
+// Reads the whole file through mmap; lines are views of the mapping and nothing is copied
+class MappedReader : public LineReader {
+public:
+    // Returns nullptr if the file cannot be mapped, e.g. it is a pipe
+    static std::unique_ptr<MappedReader> Map(int fd);
+    ~MappedReader() override;
+
+    bool Read(Batch& batch, size_t maxLines) override;
+    size_t Consumed() const noexcept override;
+
+private:
+    MappedReader(const char* data, size_t size) noexcept;
+
+private:
+    const char* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+};
+
+// Reads a stream in blocks and hands out views of them; a block is freed, or reused, once no
+// batch points into it. Only a line cut by the end of a block is copied, to the next block.
+class StreamReader : public LineReader {
+public:
+    // Owns file unless it is stdin
+    explicit StreamReader(std::FILE* file, size_t blockSize = BLOCK_SIZE) noexcept;
+    ~StreamReader() override;
+
+    bool Read(Batch& batch, size_t maxLines) override;
+    size_t Consumed() const noexcept override;
+
+private:
+    static constexpr size_t BLOCK_SIZE = 1 << 16;
+
+    // Moves the unread rest of the block to a block of its own and reads after it
+    void Refill();
+
+    std::FILE* m_file;
+    size_t m_blockSize;
+    std::shared_ptr<std::string> m_block;
+    size_t m_offset = 0;
+    size_t m_consumed = 0;
+    bool m_eof = false;
+};
+
+}
@@ -0,0 +1,249 @@
+#include "json.hpp"
+#include <fmt/format.h>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+
+namespace ezmath::driver::json {
+
+namespace {
+
+class Reader {
+public:
+    explicit Reader(const std::string_view str) noexcept
+        : m_str{str}
+    {}
+
+    void SkipSpaces() noexcept {
+        while (m_pos < m_str.size() && std::isspace(static_cast<unsigned char>(m_str[m_pos]))) {
+            ++m_pos;
+        }
+    }
+
+    bool Consume(const char c) noexcept {
+        SkipSpaces();
+        if (m_pos < m_str.size() && m_str[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool AtEnd() noexcept {
+        SkipSpaces();
+        return m_pos == m_str.size();
+    }
+
+    std::optional<std::string> String() {
+        if (!Consume('"')) {
+            return std::nullopt;
+        }
+        std::string res;
+        while (m_pos < m_str.size()) {
+            const char c = m_str[m_pos++];
+            if (c == '"') {
+                return res;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                return std::nullopt;
+            }
+            if (c != '\\') {
+                res.push_back(c);
+                continue;
+            }
+            if (m_pos == m_str.size()) {
+                return std::nullopt;
+            }
+            switch (const char escaped = m_str[m_pos++]) {
+            case '"': case '\\': case '/': res.push_back(escaped); break;
+            case 'b': res.push_back('\b'); break;
+            case 'f': res.push_back('\f'); break;
+            case 'n': res.push_back('\n'); break;
+            case 'r': res.push_back('\r'); break;
+            case 't': res.push_back('\t'); break;
+            case 'u': {
+                auto code = CodeUnit();
+                if (!code) {
+                    return std::nullopt;
+                }
+                if (*code >= 0xD800 && *code < 0xDC00) {
+                    if (!Follows("\\u")) {
+                        return std::nullopt;
+                    }
+                    const auto low = CodeUnit();
+                    if (!low || *low < 0xDC00 || *low >= 0xE000) {
+                        return std::nullopt;
+                    }
+                    code = 0x10000 + ((*code - 0xD800) << 10) + (*low - 0xDC00);
+                }
+                AppendUtf8(res, *code);
+                break;
+            }
+            default:
+                return std::nullopt;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Number, true, false or null, kept as text
+    std::optional<std::string> Literal() {
+        SkipSpaces();
+        const auto start = m_pos;
+        while (m_pos < m_str.size() && (std::isalnum(static_cast<unsigned char>(m_str[m_pos])) || std::string_view{"+-."}.contains(m_str[m_pos]))) {
+            ++m_pos;
+        }
+        const auto text = m_str.substr(start, m_pos - start);
+        if (text == "true" || text == "false" || text == "null") {
+            return std::string{text};
+        }
+        if (!IsNumber(text)) {
+            return std::nullopt;
+        }
+        return std::string{text};
+    }
+
+private:
+    // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?, so no nan, inf, hex or leading zeros
+    static bool IsNumber(std::string_view text) noexcept {
+        const auto digits = [&text] {
+            const auto count = std::min(text.find_first_not_of("0123456789"), text.size());
+            text.remove_prefix(count);
+            return count;
+        };
+        const auto skip = [&text](const std::string_view chars) {
+            if (!text.empty() && chars.contains(text.front())) {
+                text.remove_prefix(1);
+                return true;
+            }
+            return false;
+        };
+        skip("-");
+        if (text.starts_with('0')) {
+            text.remove_prefix(1);
+        } else if (!digits()) {
+            return false;
+        }
+        if (skip(".") && !digits()) {
+            return false;
+        }
+        if (skip("eE")) {
+            skip("+-");
+            if (!digits()) {
+                return false;
+            }
+        }
+        return text.empty();
+    }
+
+    // The next characters, without skipping spaces
+    bool Follows(const std::string_view str) noexcept {
+        if (!m_str.substr(m_pos).starts_with(str)) {
+            return false;
+        }
+        m_pos += str.size();
+        return true;
+    }
+
+    std::optional<uint32_t> CodeUnit() noexcept {
+        if (m_str.size() - m_pos < 4) {
+            return std::nullopt;
+        }
+        uint32_t res = 0;
+        const auto* begin = m_str.data() + m_pos;
+        const auto [end, error] = std::from_chars(begin, begin + 4, res, 16);
+        if (error != std::errc{} || end != begin + 4) {
+            return std::nullopt;
+        }
+        m_pos += 4;
+        return res;
+    }
+
+    static void AppendUtf8(std::string& out, const uint32_t code) {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+private:
+    std::string_view m_str;
+    size_t m_pos = 0;
+};
+
+}
+
+std::optional<Object> ParseObject(const std::string_view line) {
+    Reader reader{line};
+    if (!reader.Consume('{')) {
+        return std::nullopt;
+    }
+    Object res;
+    if (!reader.Consume('}')) {
+        do {
+            auto key = reader.String();
+            if (!key || !reader.Consume(':')) {
+                return std::nullopt;
+            }
+            reader.SkipSpaces();
+            Value value;
+            if (auto str = reader.String()) {
+                value = {std::move(*str), true};
+            } else if (auto literal = reader.Literal()) {
+                value = {std::move(*literal), false};
+            } else {
+                return std::nullopt;
+            }
+            res.insert_or_assign(std::move(*key), std::move(value));
+        } while (reader.Consume(','));
+        if (!reader.Consume('}')) {
+            return std::nullopt;
+        }
+    }
+    if (!reader.AtEnd()) {
+        return std::nullopt;
+    }
+    return res;
+}
+
+void AppendString(std::string& out, const std::string_view str) {
+    out.push_back('"');
+    for (const char c : str) {
+        switch (c) {
+        case '"': out.append("\\\""); break;
+        case '\\': out.append("\\\\"); break;
+        case '\n': out.append("\\n"); break;
+        case '\r': out.append("\\r"); break;
+        case '\t': out.append("\\t"); break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out.append(fmt::format("\\u{:04x}", static_cast<unsigned>(c)));
+            } else {
+                out.push_back(c);
+            }
+        }
+    }
+    out.push_back('"');
+}
+
+void AppendValue(std::string& out, const Value& value) {
+    if (value.IsString) {
+        AppendString(out, value.Text);
+    } else {
+        out.append(value.Text);
+    }
+}
+
+}
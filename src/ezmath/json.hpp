@@ -0,0 +1,29 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Just enough JSON for the server protocol: one flat object per line
+namespace ezmath::driver::json {
+
+// Member of a flat object. Strings are unescaped; numbers, booleans and null keep their text.
+struct Value {
+    std::string Text;
+    bool IsString = false;
+};
+
+using Object = std::unordered_map<std::string, Value>;
+
+// Parses a line holding one object whose members are strings, numbers, booleans or null;
+// nullopt for anything else, nested objects and arrays included
+std::optional<Object> ParseObject(std::string_view line);
+
+// Appends str as a quoted JSON string
+void AppendString(std::string& out, std::string_view str);
+
+// Appends value as it was received
+void AppendValue(std::string& out, const Value& value);
+
+}
@@ -0,0 +1,255 @@
+#include "pipeline.hpp"
+#include <parsing/exception.hpp>
+#include <parsing/parser.hpp>
+#include <tree/exception.hpp>
+#include <tree/math.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace ezmath::driver {
+
+namespace {
+
+std::string FormatDuration(const uint64_t ns) {
+    if (ns < 1'000) {
+        return fmt::format("{} ns", ns);
+    }
+    if (ns < 1'000'000) {
+        return fmt::format("{:.1f} us", static_cast<double>(ns) / 1e3);
+    }
+    if (ns < 1'000'000'000) {
+        return fmt::format("{:.2f} ms", static_cast<double>(ns) / 1e6);
+    }
+    return fmt::format("{:.2f} s", static_cast<double>(ns) / 1e9);
+}
+
+class Pipeline {
+public:
+    Pipeline(LineReader& input, std::FILE* output, const Options& options)
+        : m_input{input}
+        , m_output{output}
+        , m_batchLines{std::max<size_t>(options.BatchLines, 1)}
+        , m_threads{std::max<size_t>(options.Threads, 1)}
+        , m_slots(options.MaxBatches ? options.MaxBatches : 4 * m_threads)
+    {}
+
+    Summary Run() {
+        const auto start = Clock::now();
+        std::vector<Summary> summaries(m_threads);
+        {
+            std::vector<std::jthread> workers;
+            workers.reserve(m_threads);
+            for (auto& summary : summaries) {
+                workers.emplace_back([this, &summary] { Work(summary); });
+            }
+            std::jthread writer{[this] { Write(); }};
+            Read();
+        }
+
+        Summary res;
+        for (const auto& summary : summaries) {
+            res.Merge(summary);
+        }
+        res.Bytes = m_input.Consumed();
+        res.Elapsed = Clock::now() - start;
+        return res;
+    }
+
+private:
+    struct Slot {
+        Batch Data;
+        bool Ready = false;
+    };
+
+    // A batch is read into the slot of its index once the batch that used the slot is written
+    void Read() {
+        while (true) {
+            {
+                std::unique_lock lock{m_mutex};
+                m_slotFree.wait(lock, [this] { return m_read - m_written < m_slots.size(); });
+            }
+            auto& batch = m_slots[m_read % m_slots.size()].Data;
+            if (!m_input.Read(batch, m_batchLines)) {
+                break;
+            }
+            {
+                std::lock_guard lock{m_mutex};
+                m_work.push_back(m_read);
+                ++m_read;
+            }
+            m_workReady.notify_one();
+        }
+        {
+            std::lock_guard lock{m_mutex};
+            m_inputDone = true;
+        }
+        m_workReady.notify_all();
+        m_resultReady.notify_all();
+    }
+
+    void Work(Summary& summary) {
+        while (true) {
+            size_t index = 0;
+            {
+                std::unique_lock lock{m_mutex};
+                m_workReady.wait(lock, [this] { return m_inputDone || !m_work.empty(); });
+                if (m_work.empty()) {
+                    return;
+                }
+                index = m_work.front();
+                m_work.pop_front();
+            }
+            auto& slot = m_slots[index % m_slots.size()];
+            auto& batch = slot.Data;
+            batch.Results.clear();
+            for (const auto line : batch.Lines) {
+                batch.Results.push_back(ProcessLine(line, summary));
+            }
+            {
+                std::lock_guard lock{m_mutex};
+                slot.Ready = true;
+            }
+            m_resultReady.notify_all();
+        }
+    }
+
+    void Write() {
+        while (true) {
+            Slot* slot = nullptr;
+            {
+                std::unique_lock lock{m_mutex};
+                m_resultReady.wait(lock, [this] {
+                    return (m_written < m_read && m_slots[m_written % m_slots.size()].Ready)
+                        || (m_inputDone && m_written == m_read);
+                });
+                if (m_written == m_read) {
+                    return;
+                }
+                slot = &m_slots[m_written % m_slots.size()];
+            }
+            for (const auto& result : slot->Data.Results) {
+                std::fwrite(result.data(), 1, result.size(), m_output);
+                std::fputc('\n', m_output);
+            }
+            {
+                std::lock_guard lock{m_mutex};
+                slot->Ready = false;
+                ++m_written;
+            }
+            m_slotFree.notify_one();
+        }
+    }
+
+private:
+    LineReader& m_input;
+    std::FILE* m_output;
+    size_t m_batchLines;
+    size_t m_threads;
+    std::vector<Slot> m_slots;
+
+    std::mutex m_mutex;
+    std::condition_variable m_workReady;
+    std::condition_variable m_resultReady;
+    std::condition_variable m_slotFree;
+    std::deque<size_t> m_work;
+    size_t m_read = 0;
+    size_t m_written = 0;
+    bool m_inputDone = false;
+};
+
+}
+
+uint64_t Nanoseconds(const Clock::time_point from, const Clock::time_point to) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+
+void Summary::Merge(const Summary& other) {
+    Lines += other.Lines;
+    Bytes += other.Bytes;
+    ParseErrors += other.ParseErrors;
+    MathErrors += other.MathErrors;
+    OtherErrors += other.OtherErrors;
+    Elapsed = std::max(Elapsed, other.Elapsed);
+    Parse.Merge(other.Parse);
+    Simplify.Merge(other.Simplify);
+    Print.Merge(other.Print);
+    Total.Merge(other.Total);
+}
+
+std::string ProcessLine(const std::string_view line, Summary& summary) {
+    ++summary.Lines;
+    if (line.find_first_not_of(" \t") == std::string_view::npos) {
+        return {};
+    }
+    const auto start = Clock::now();
+    try {
+        // The tree is simplified right away, so it may as well be built folded
+        auto tree = parsing::ParseTree(line, {.Fold = true});
+        const auto parsed = Clock::now();
+        summary.Parse.Add(Nanoseconds(start, parsed));
+
+        tree::math::simplify(tree);
+        const auto simplified = Clock::now();
+        summary.Simplify.Add(Nanoseconds(parsed, simplified));
+
+        auto res = tree->ToString();
+        const auto printed = Clock::now();
+        summary.Print.Add(Nanoseconds(simplified, printed));
+        summary.Total.Add(Nanoseconds(start, printed));
+        return res;
+    } catch (...) {
+        summary.Total.Add(Nanoseconds(start, Clock::now()));
+        return fmt::format("error: {}", CountError(summary));
+    }
+}
+
+std::string CountError(Summary& summary) {
+    try {
+        throw;
+    } catch (const parsing::exception::LexerException& ex) {
+        ++summary.ParseErrors;
+        return ex.what();
+    } catch (const parsing::exception::ParserException& ex) {
+        ++summary.ParseErrors;
+        return ex.what();
+    } catch (const tree::exception::CalcException& ex) {
+        ++summary.MathErrors;
+        return ex.what();
+    } catch (const std::exception& ex) {
+        ++summary.OtherErrors;
+        return ex.what();
+    } catch (...) {
+        ++summary.OtherErrors;
+        return "unknown error";
+    }
+}
+
+Summary Run(LineReader& input, std::FILE* output, const Options& options) {
+    return Pipeline{input, output, options}.Run();
+}
+
+void PrintSummary(const Summary& summary, std::FILE* out) {
+    const auto seconds = std::chrono::duration<double>(summary.Elapsed).count();
+    const auto rate = [seconds](const double value) { return seconds > 0 ? value / seconds : 0.0; };
+    fmt::print(out, "lines   {} in {:.3f} s: {:.0f} lines/s, {:.2f} MB/s\n",
+        summary.Lines, seconds, rate(static_cast<double>(summary.Lines)), rate(static_cast<double>(summary.Bytes) / 1e6));
+    fmt::print(out, "errors  {} parse, {} math, {} other\n", summary.ParseErrors, summary.MathErrors, summary.OtherErrors);
+    fmt::print(out, "{:<10}{:>12}{:>12}{:>12}{:>12}{:>12}\n", "stage", "count", "p50", "p90", "p99", "max");
+    const std::pair<std::string_view, const Histogram*> stages[] = {
+        {"parse", &summary.Parse},
+        {"simplify", &summary.Simplify},
+        {"print", &summary.Print},
+        {"total", &summary.Total}
+    };
+    for (const auto& [name, histogram] : stages) {
+        fmt::print(out, "{:<10}{:>12}{:>12}{:>12}{:>12}{:>12}\n", name, histogram->Count(),
+            FormatDuration(histogram->Percentile(0.5)), FormatDuration(histogram->Percentile(0.9)),
+            FormatDuration(histogram->Percentile(0.99)), FormatDuration(histogram->Max()));
+    }
+}
+
+}
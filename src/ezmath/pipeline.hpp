@@ -0,0 +1,56 @@
+#pragma once
+
+#include "histogram.hpp"
+#include "input.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace ezmath::driver {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t Nanoseconds(Clock::time_point from, Clock::time_point to);
+
+struct Options {
+    size_t Threads = std::thread::hardware_concurrency();
+    size_t BatchLines = 64;
+    // Batches read but not written yet, which bounds the memory of a run; 0 is 4 per thread
+    size_t MaxBatches = 0;
+};
+
+// Counters of a run; stages are timed per formula
+struct Summary {
+    size_t Lines = 0;
+    size_t Bytes = 0;
+    size_t ParseErrors = 0;
+    size_t MathErrors = 0;
+    size_t OtherErrors = 0;
+    std::chrono::nanoseconds Elapsed{};
+    Histogram Parse;
+    Histogram Simplify;
+    Histogram Print;
+    Histogram Total;
+
+    size_t Errors() const noexcept { return ParseErrors + MathErrors + OtherErrors; }
+    void Merge(const Summary& other);
+};
+
+// Parses, simplifies and prints one formula. Errors are counted and returned as "error: ..."
+// instead of thrown, so that one bad line does not stop a run; empty lines stay empty.
+std::string ProcessLine(std::string_view line, Summary& summary);
+
+// Counts the exception being handled in summary by kind and returns its message; call it
+// from a catch block
+std::string CountError(Summary& summary);
+
+// Reads batches of lines on the calling thread, processes them on Options::Threads workers and
+// writes the results in input order, one per line, from a writer thread
+Summary Run(LineReader& input, std::FILE* output, const Options& options);
+
+// Throughput, error counts and latency percentiles per stage
+void PrintSummary(const Summary& summary, std::FILE* out);
+
+}
@@ -0,0 +1,376 @@
+#include "server.hpp"
+#include <parsing/parser.hpp>
+#include <tree/math.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <system_error>
+#include <unordered_map>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ezmath::driver {
+
+namespace {
+
+void AppendAnswer(std::string& out, const std::optional<json::Value>& id, const std::string_view key, const std::string_view value, const bool isObject = false) {
+    out.push_back('{');
+    if (id) {
+        out.append("\"id\":");
+        json::AppendValue(out, *id);
+        out.push_back(',');
+    }
+    json::AppendString(out, key);
+    out.push_back(':');
+    if (isObject) {
+        out.append(value);
+    } else {
+        json::AppendString(out, value);
+    }
+    out.append("}\n");
+}
+
+double Microseconds(const uint64_t ns) {
+    return static_cast<double>(ns) / 1e3;
+}
+
+std::string FormatPercentiles(const Histogram& histogram) {
+    return fmt::format(R"({{"count":{},"p50":{:.1f},"p90":{:.1f},"p99":{:.1f},"max":{:.1f}}})",
+        histogram.Count(), Microseconds(histogram.Percentile(0.5)), Microseconds(histogram.Percentile(0.9)),
+        Microseconds(histogram.Percentile(0.99)), Microseconds(histogram.Max()));
+}
+
+}
+
+struct Server::Connection {
+    Connection(const int in, const int out, const bool owned) noexcept
+        : In{in}
+        , Out{out}
+        , Owned{owned}
+    {}
+
+    ~Connection() {
+        if (Owned) {
+            ::close(In);
+            if (Out != In) {
+                ::close(Out);
+            }
+        }
+    }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    // A client that went away loses its answers, nothing else
+    void Send(std::string_view data) {
+        std::lock_guard lock{WriteMutex};
+        while (!data.empty()) {
+            const auto written = ::write(Out, data.data(), data.size());
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            data.remove_prefix(static_cast<size_t>(written));
+        }
+    }
+
+    int In;
+    int Out;
+    bool Owned;
+    std::mutex WriteMutex;
+    // Requests in the queue or in a batch; guarded by Server::m_mutex
+    size_t Pending = 0;
+    std::atomic<bool> ReadDone = false;
+};
+
+void Server::Stats::Merge(const Stats& other) {
+    Requests += other.Requests;
+    Batches += other.Batches;
+    TextHits += other.TextHits;
+    StructureHits += other.StructureHits;
+    Misses += other.Misses;
+    Stages.Merge(other.Stages);
+    Latency.Merge(other.Latency);
+}
+
+Server::Server(const ServerOptions& options)
+    : m_maxBatch{std::max<size_t>(options.MaxBatch, 1)}
+    , m_maxQueue{std::max<size_t>(options.MaxQueue, 1)}
+    , m_cache{options.CacheBytes}
+{
+    const auto threads = std::max<size_t>(options.Threads, 1);
+    m_workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        m_workers.emplace_back([this] { Work(); });
+    }
+}
+
+Server::~Server() {
+    {
+        std::lock_guard lock{m_mutex};
+        m_stopped = true;
+    }
+    m_requestReady.notify_all();
+    m_queueSpace.notify_all();
+    {
+        std::lock_guard lock{m_readersMutex};
+        for (const auto& [connection, reader] : m_readers) {
+            // Ends a read the reader is blocked in
+            if (const auto client = connection.lock()) {
+                ::shutdown(client->In, SHUT_RD);
+            }
+        }
+    }
+    m_readers.clear();
+    m_workers.clear();
+}
+
+void Server::ServeStream(const int in, const int out) {
+    const auto client = std::make_shared<Connection>(in, out, false);
+    Read(client);
+    std::unique_lock lock{m_mutex};
+    m_answered.wait(lock, [&client] { return client->Pending == 0; });
+}
+
+void Server::ServeSocket(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::system_error{ENAMETOOLONG, std::generic_category(), path};
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw std::system_error{errno, std::generic_category(), "socket"};
+    }
+    ::unlink(path.c_str());
+    if (::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, SOMAXCONN) != 0) {
+        const auto error = errno;
+        ::close(listener);
+        throw std::system_error{error, std::generic_category(), path};
+    }
+
+    while (true) {
+        const int fd = ::accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            const auto error = errno;
+            ::close(listener);
+            throw std::system_error{error, std::generic_category(), "accept"};
+        }
+        // Requests keep their connection alive after the reader is done
+        const auto client = std::make_shared<Connection>(fd, fd, true);
+        std::lock_guard lock{m_readersMutex};
+        std::erase_if(m_readers, [](const auto& reader) {
+            const auto connection = reader.first.lock();
+            return !connection || connection->ReadDone;
+        });
+        m_readers.emplace_back(client, std::jthread{[this, client] {
+            Read(client);
+            client->ReadDone = true;
+        }});
+    }
+}
+
+void Server::Read(const std::shared_ptr<Connection>& client) {
+    std::string buffer;
+    std::vector<char> chunk(1 << 16);
+    bool done = false;
+    while (!done) {
+        const auto read = ::read(client->In, chunk.data(), chunk.size());
+        if (read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read <= 0) {
+            done = true;
+            buffer.push_back('\n');
+        } else {
+            buffer.append(chunk.data(), static_cast<size_t>(read));
+        }
+
+        std::vector<Request> requests;
+        std::string errors;
+        size_t offset = 0;
+        for (auto newline = buffer.find('\n'); newline != std::string::npos; newline = buffer.find('\n', offset)) {
+            auto line = std::string_view{buffer}.substr(offset, newline - offset);
+            offset = newline + 1;
+            if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+                continue;
+            }
+
+            auto object = json::ParseObject(line);
+            if (!object) {
+                AppendAnswer(errors, std::nullopt, "error", "invalid request: expected a JSON object per line");
+                continue;
+            }
+            Request request{client, std::nullopt, EOp::Simplify, {}, Clock::now()};
+            if (const auto id = object->find("id"); id != object->end()) {
+                request.Id = id->second;
+            }
+            if (const auto op = object->find("op"); op != object->end()) {
+                if (op->second.IsString && op->second.Text == "stats") {
+                    request.Op = EOp::Stats;
+                } else if (!op->second.IsString || op->second.Text != "simplify") {
+                    AppendAnswer(errors, request.Id, "error", fmt::format("unknown op: {}", op->second.Text));
+                    continue;
+                }
+            }
+            if (request.Op == EOp::Simplify) {
+                const auto expr = object->find("expr");
+                if (expr == object->end() || !expr->second.IsString) {
+                    AppendAnswer(errors, request.Id, "error", "expr must be a string");
+                    continue;
+                }
+                request.Expr = std::move(expr->second.Text);
+            }
+            requests.push_back(std::move(request));
+        }
+        buffer.erase(0, offset);
+        if (buffer.size() > MAX_REQUEST_SIZE) {
+            AppendAnswer(errors, std::nullopt, "error", "request too long");
+            done = true;
+        }
+
+        if (!errors.empty()) {
+            client->Send(errors);
+        }
+        if (!requests.empty()) {
+            {
+                std::unique_lock lock{m_mutex};
+                m_queueSpace.wait(lock, [this] { return m_stopped || m_queue.size() < m_maxQueue; });
+                if (m_stopped) {
+                    return;
+                }
+                client->Pending += requests.size();
+                std::ranges::move(requests, std::back_inserter(m_queue));
+            }
+            m_requestReady.notify_all();
+        }
+    }
+}
+
+void Server::Work() {
+    while (true) {
+        std::vector<Request> batch;
+        {
+            std::unique_lock lock{m_mutex};
+            m_requestReady.wait(lock, [this] { return m_stopped || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            const auto size = static_cast<ptrdiff_t>(std::min(m_maxBatch, m_queue.size()));
+            batch.assign(std::make_move_iterator(m_queue.begin()), std::make_move_iterator(m_queue.begin() + size));
+            m_queue.erase(m_queue.begin(), m_queue.begin() + size);
+        }
+        m_queueSpace.notify_all();
+
+        Stats stats;
+        Process(batch, stats);
+        {
+            std::lock_guard lock{m_statsMutex};
+            m_stats.Merge(stats);
+        }
+
+        {
+            std::lock_guard lock{m_mutex};
+            for (const auto& request : batch) {
+                --request.Client->Pending;
+            }
+        }
+        m_answered.notify_all();
+    }
+}
+
+void Server::Process(std::vector<Request>& batch, Stats& stats) {
+    ++stats.Batches;
+    std::unordered_map<std::string_view, ResultCache::Result> results;
+    std::unordered_map<Connection*, std::string> answers;
+    for (const auto& request : batch) {
+        ++stats.Requests;
+        auto& out = answers[request.Client.get()];
+        if (request.Op == EOp::Stats) {
+            AppendAnswer(out, request.Id, "stats", FormatStats(), true);
+            continue;
+        }
+        auto it = results.find(request.Expr);
+        if (it == results.end()) {
+            it = results.emplace(request.Expr, Evaluate(request.Expr, stats)).first;
+        }
+        const auto& [text, failed] = it->second;
+        AppendAnswer(out, request.Id, failed ? "error" : "result", text);
+    }
+
+    for (auto& [client, out] : answers) {
+        client->Send(out);
+    }
+    const auto now = Clock::now();
+    for (const auto& request : batch) {
+        stats.Latency.Add(Nanoseconds(request.Received, now));
+    }
+}
+
+ResultCache::Result Server::Evaluate(const std::string& expr, Stats& stats) {
+    if (auto res = m_cache.Find(expr)) {
+        ++stats.TextHits;
+        return std::move(*res);
+    }
+
+    auto& summary = stats.Stages;
+    ++summary.Lines;
+    bool parses = false;
+    ResultCache::Result res;
+    const auto start = Clock::now();
+    try {
+        auto tree = parsing::ParseTree(expr, {.Fold = true});
+        const auto parsed = Clock::now();
+        summary.Parse.Add(Nanoseconds(start, parsed));
+
+        if (auto cached = m_cache.Find(*tree)) {
+            ++stats.StructureHits;
+            m_cache.Insert(expr, true, *cached);
+            return std::move(*cached);
+        }
+        parses = true;
+
+        tree::math::simplify(tree);
+        const auto simplified = Clock::now();
+        summary.Simplify.Add(Nanoseconds(parsed, simplified));
+
+        res.Text = tree->ToString();
+        summary.Print.Add(Nanoseconds(simplified, Clock::now()));
+    } catch (...) {
+        res = {CountError(summary), true};
+    }
+    summary.Total.Add(Nanoseconds(start, Clock::now()));
+    ++stats.Misses;
+    m_cache.Insert(expr, parses, res);
+    return res;
+}
+
+std::string Server::FormatStats() const {
+    const auto cache = m_cache.GetCounters();
+    std::lock_guard lock{m_statsMutex};
+    const auto& stages = m_stats.Stages;
+    const auto uptime = std::chrono::duration<double>(Clock::now() - m_started).count();
+    return fmt::format(
+        R"({{"uptime_s":{:.3f},"requests":{},"requests_per_s":{:.1f},"batches":{},"mean_batch":{:.2f},)"
+        R"("cache":{{"entries":{},"bytes":{},"evictions":{},"text_hits":{},"structure_hits":{},"misses":{}}},)"
+        R"("errors":{{"parse":{},"math":{},"other":{}}},"latency_us":{},)"
+        R"("stages_us":{{"parse":{},"simplify":{},"print":{}}}}})",
+        uptime, m_stats.Requests, uptime > 0 ? static_cast<double>(m_stats.Requests) / uptime : 0.0,
+        m_stats.Batches, m_stats.Batches ? static_cast<double>(m_stats.Requests) / static_cast<double>(m_stats.Batches) : 0.0,
+        cache.Entries, cache.Bytes, cache.Evictions, m_stats.TextHits, m_stats.StructureHits, m_stats.Misses,
+        stages.ParseErrors, stages.MathErrors, stages.OtherErrors, FormatPercentiles(m_stats.Latency),
+        FormatPercentiles(stages.Parse), FormatPercentiles(stages.Simplify), FormatPercentiles(stages.Print));
+}
+
+}
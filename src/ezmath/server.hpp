@@ -0,0 +1,113 @@
+#pragma once
+
+#include "cache.hpp"
+#include "json.hpp"
+#include "pipeline.hpp"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ezmath::driver {
+
+struct ServerOptions {
+    size_t Threads = std::thread::hardware_concurrency();
+    // Requests a worker takes off the queue at once
+    size_t MaxBatch = 32;
+    size_t CacheBytes = size_t{64} << 20;
+    // Requests waiting for a worker; while the queue is full, clients are not read and their
+    // writes block
+    size_t MaxQueue = 4096;
+};
+
+// Answers requests of the JSON-lines protocol, one object per line:
+//   {"id": 1, "expr": "\\frac{2}{4}x"}  ->  {"id":1,"result":"\\frac{1}{2}x"}
+//   {"id": 2, "op": "stats"}            ->  {"id":2,"stats":{...}}
+// "op" is "simplify" by default, and failed requests answer {"id":...,"error":"..."}. Answers
+// to a client may come out of order; ids, echoed as they were sent, tell them apart.
+//
+// Requests of all clients share one queue, which workers drain in batches: equal formulas of a
+// batch are computed once, and the answers to a client are written together. Results are kept
+// in a ResultCache shared by all clients.
+class Server {
+public:
+    explicit Server(const ServerOptions& options);
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Serves one client on the descriptors until its input ends and every request is answered
+    void ServeStream(int in, int out);
+    // Serves the clients of a Unix domain socket created at path, replacing a stale one.
+    // Returns only by throwing std::system_error; the destructor then disconnects the clients
+    // and joins their readers.
+    [[noreturn]] void ServeSocket(const std::string& path);
+
+private:
+    struct Connection;
+
+    enum class EOp : uint8_t {
+        Simplify,
+        Stats
+    };
+
+    struct Request {
+        std::shared_ptr<Connection> Client;
+        std::optional<json::Value> Id;
+        EOp Op;
+        std::string Expr;
+        Clock::time_point Received;
+    };
+
+    // Counters since start; workers add theirs after every batch
+    struct Stats {
+        size_t Requests = 0;
+        size_t Batches = 0;
+        size_t TextHits = 0;
+        size_t StructureHits = 0;
+        size_t Misses = 0;
+        Summary Stages;
+        Histogram Latency;
+
+        void Merge(const Stats& other);
+    };
+
+    void Read(const std::shared_ptr<Connection>& client);
+    void Work();
+    void Process(std::vector<Request>& batch, Stats& stats);
+    ResultCache::Result Evaluate(const std::string& expr, Stats& stats);
+    std::string FormatStats() const;
+
+private:
+    static constexpr size_t MAX_REQUEST_SIZE = 1 << 20;
+
+    size_t m_maxBatch;
+    size_t m_maxQueue;
+    ResultCache m_cache;
+    Clock::time_point m_started = Clock::now();
+
+    std::mutex m_mutex;
+    std::condition_variable m_requestReady;
+    std::condition_variable m_answered;
+    std::condition_variable m_queueSpace;
+    std::deque<Request> m_queue;
+    bool m_stopped = false;
+
+    mutable std::mutex m_statsMutex;
+    Stats m_stats;
+
+    // A reader thread per socket client; finished ones are joined when the next client connects.
+    // The connection is only observed, since it closes once its last request is answered.
+    std::mutex m_readersMutex;
+    std::vector<std::pair<std::weak_ptr<Connection>, std::jthread>> m_readers;
+
+    std::vector<std::jthread> m_workers;
+};
+
+}
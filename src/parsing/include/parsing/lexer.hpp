@@ -17,7 +17,7 @@ public:
     const char* GetChar();
     void NextChar();
 
-    static constexpr std::string_view OPERATORS = "!+-^_&<>";
+    static constexpr std::string_view OPERATORS = "!+-^_&<>=";
     static constexpr std::string_view BRACKETS = "{}[]()";
 
 private:
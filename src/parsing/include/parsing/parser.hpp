@@ -2,29 +2,58 @@
 
 #include <parsing/lexer.hpp>
 #include <tree/expression.hpp>
+#include <tree/linear.hpp>
 #include <tree/math.hpp>
 #include <functional>
 
 namespace ezmath::parsing {
 
+struct ParserOptions {
+    // Builds the tree in the form the first simplify pass would give it: numeric subexpressions
+    // are folded into numbers, and sums and products of a single operand are the operand itself.
+    // The simplified result is the same either way, but far fewer nodes are allocated; off by
+    // default, so the tree mirrors the input. A division by zero that folding would hide throws
+    // the CalcException of simplify while parsing.
+    bool Fold = false;
+};
+
 class Parser {
 public:
-    Parser(std::string_view text);
+    Parser(std::string_view text, ParserOptions options = {});
     Parser(Parser&&) = default;
     Parser(const Parser&) = delete;
 
     std::unique_ptr<tree::IExpr> BuildTree();
+    // Equations separated by \\; '&' around '=' is allowed for alignment
+    std::vector<tree::Equation> BuildSystem();
 
 private:
     using math = tree::math;
 
+    // Brackets, arguments and commands nested deeper than this are rejected: the parser and
+    // simplify recurse once per level, and a deeper input would overflow the stack
+    static constexpr size_t MAX_NESTING = 1000;
+
+    struct Nesting {
+        explicit Nesting(Parser& parser);
+        ~Nesting() { --m_parser.m_nesting; }
+        Nesting(const Nesting&) = delete;
+        Nesting& operator=(const Nesting&) = delete;
+
+        Parser& m_parser;
+    };
+
     std::unique_ptr<tree::IExpr> ParseExpression();
+    tree::Equation ParseEquation();
+    bool SkipToken(Token token);
 
     int ReadSumOperator();
     std::unique_ptr<tree::IExpr> ParseSum();
     
     int ReadProdOperator();
     std::unique_ptr<tree::IExpr> ParseProduct();
+    void AddFactor(std::vector<std::unique_ptr<tree::IExpr>>& values, std::unique_ptr<tree::Matrix>& matrix,
+                   std::unique_ptr<tree::IExpr>&& factor, bool inverse);
     
     std::unique_ptr<tree::IExpr> ParsePower();
     std::unique_ptr<tree::IExpr> ParseObject();
@@ -35,14 +64,34 @@ private:
     std::unique_ptr<tree::IExpr> ReadArgument();
 
     std::unique_ptr<tree::IExpr> ParseFrac();
+    // The argument is a single object, so \ln x^2 and \ln(x)^2 both mean (\ln x)^2
+    std::unique_ptr<tree::IExpr> ParseLog();
+    // \begin{matrix}, pmatrix and bmatrix give a matrix, vmatrix its determinant
+    std::unique_ptr<tree::IExpr> ParseEnvironment();
+    std::string_view ReadEnvironmentName();
+
+    // The math:: constructors, folded under ParserOptions::Fold
+    std::unique_ptr<tree::IExpr> MakeSum(std::vector<std::unique_ptr<tree::IExpr>>&& values) const;
+    std::unique_ptr<tree::IExpr> MakeProduct(std::vector<std::unique_ptr<tree::IExpr>>&& values) const;
+    std::unique_ptr<tree::IExpr> MakePower(std::unique_ptr<tree::IExpr>&& base, std::unique_ptr<tree::IExpr>&& exp);
+    std::unique_ptr<tree::IExpr> MakeNegation(std::unique_ptr<tree::IExpr>&& value) const;
+    std::unique_ptr<tree::IExpr> MakeInverse(std::unique_ptr<tree::IExpr>&& value);
+    bool HasZeroDenominator(const tree::IExpr& expr) const;
 
     Lexer m_lexer;
+    ParserOptions m_options;
+    size_t m_nesting = 0;
+    // Powers of zero with negative exponents left in the tree, which folding must not hide
+    size_t m_zeroDenominators = 0;
 
     std::unordered_multimap<std::string, std::function<std::unique_ptr<tree::IExpr>(Parser*)>> s_commandParsers {
-        {"\\frac", &Parser::ParseFrac}
+        {"\\frac", &Parser::ParseFrac},
+        {"\\ln", &Parser::ParseLog},
+        {"\\begin", &Parser::ParseEnvironment}
     };
 };
 
-std::unique_ptr<tree::IExpr> ParseTree(const std::string_view str);
+std::unique_ptr<tree::IExpr> ParseTree(const std::string_view str, const ParserOptions& options = {});
+std::vector<tree::Equation> ParseSystem(const std::string_view str, const ParserOptions& options = {});
 
 }
\ No newline at end of file
@@ -39,14 +39,17 @@ namespace ezmath::parsing {
             static constexpr auto factorial = Token{Token::EType::Operator, "!"};
             static constexpr auto less = Token{Token::EType::Operator, "<"};
             static constexpr auto more = Token{Token::EType::Operator, ">"};
+            static constexpr auto equal = Token{Token::EType::Operator, "="};
         }
         namespace command {
             static constexpr auto div = Token{Token::EType::Command, "\\div"};
             static constexpr auto cdot = Token{Token::EType::Command, "\\cdot"};
+            static constexpr auto begin = Token{Token::EType::Command, "\\begin"};
+            static constexpr auto end = Token{Token::EType::Command, "\\end"};
         }
         namespace matrix {
             namespace operation {
-                static constexpr auto new_row = Token{Token::EType::Operator, "\\"};
+                static constexpr auto new_row = Token{Token::EType::Operator, "\\\\"};
                 static constexpr auto new_col = Token{Token::EType::Operator, "&"};
             }
         }
@@ -1,6 +1,8 @@
 #include <parsing/parser.hpp>
 #include <parsing/exception.hpp>
 #include <parsing/token_utils.hpp>
+#include <tree/exception.hpp>
+#include <tree/traverse.hpp>
 
 #include <fmt/format.h>
 
@@ -8,10 +10,40 @@
 
 namespace ezmath::parsing {
 
-Parser::Parser(const std::string_view text)
+namespace {
+
+// Integer powers of numbers are folded up to this exponent; larger ones are left to simplify
+constexpr uint32_t MAX_FOLDED_EXPONENT = 64;
+
+const tree::BigNum* NumberValue(const std::unique_ptr<tree::IExpr>& expr) {
+    return expr->Is<tree::Number>() ? &expr->As<tree::Number>()->Value() : nullptr;
+}
+
+bool HasMatrix(const tree::IExpr& expr) {
+    bool found = false;
+    tree::traverse::PreOrder(expr, [&found](const tree::IExpr& node) {
+        found |= node.Is<tree::Matrix>();
+        return !found;
+    });
+    return found;
+}
+
+}
+
+Parser::Parser(const std::string_view text, ParserOptions options)
     : m_lexer{text}
+    , m_options{options}
 {}  
 
+Parser::Nesting::Nesting(Parser& parser)
+    : m_parser{parser}
+{
+    if (m_parser.m_nesting == MAX_NESTING) {
+        throw exception::ParserException{fmt::format("expression is nested deeper than {} levels", MAX_NESTING)};
+    }
+    ++m_parser.m_nesting;
+}
+
 std::unique_ptr<tree::IExpr> Parser::BuildTree() {
     if (!m_lexer.GetToken()) {
         throw exception::ParserException{"empty input"};
@@ -23,10 +55,48 @@ std::unique_ptr<tree::IExpr> Parser::BuildTree() {
     return tree;
 }
 
+std::vector<tree::Equation> Parser::BuildSystem() {
+    if (!m_lexer.GetToken()) {
+        throw exception::ParserException{"empty input"};
+    }
+    std::vector<tree::Equation> equations;
+    do {
+        // a trailing \\ is allowed
+        if (!m_lexer.GetToken()) {
+            break;
+        }
+        equations.emplace_back(ParseEquation());
+    } while (SkipToken(token::matrix::operation::new_row));
+
+    if (m_lexer.GetToken()) {
+        throw exception::ParserException{"found extra characters at the end of the system"};
+    }
+    return equations;
+}
+
 std::unique_ptr<tree::IExpr> Parser::ParseExpression() {
+    const Nesting nesting{*this};
     return ParseSum();
 }
 
+tree::Equation Parser::ParseEquation() {
+    auto lhs = ParseExpression();
+    SkipToken(token::matrix::operation::new_col);
+    if (!SkipToken(token::operation::equal)) {
+        throw exception::ParserException{"expected '=' in equation"};
+    }
+    SkipToken(token::matrix::operation::new_col);
+    return {std::move(lhs), ParseExpression()};
+}
+
+bool Parser::SkipToken(const Token token) {
+    if (m_lexer.GetToken() == token) {
+        m_lexer.NextToken();
+        return true;
+    }
+    return false;
+}
+
 int Parser::ReadSumOperator() {
     const auto token = m_lexer.GetToken();
     if (token == token::operation::plus) {
@@ -48,12 +118,12 @@ std::unique_ptr<tree::IExpr> Parser::ParseSum() {
     do {
         auto next = ParseProduct();
         if (sign == -1) {
-            next = math::negate(std::move(next));
+            next = MakeNegation(std::move(next));
         }
         values.emplace_back(std::move(next));
     } while((sign = ReadSumOperator()));
 
-    return math::add(std::move(values));
+    return MakeSum(std::move(values));
 }
 
 int Parser::ReadProdOperator() {
@@ -70,6 +140,7 @@ int Parser::ReadProdOperator() {
     }
 
     return token.Type == Token::EType::Operator
+        || token == token::command::end
         || token == token::bracket::right
         || token::bracket::IsClosing(token)
         ? 0 : 1;
@@ -77,14 +148,32 @@ int Parser::ReadProdOperator() {
 
 std::unique_ptr<tree::IExpr> Parser::ParseProduct() {
     std::vector<std::unique_ptr<tree::IExpr>> values;
+    std::unique_ptr<tree::Matrix> matrix;
     while (const auto power = ReadProdOperator()) {
-        auto next = ParsePower();
-        if (power == -1) {
-            next = math::inverse(std::move(next));
-        }
-        values.emplace_back(std::move(next));
+        AddFactor(values, matrix, ParsePower(), power == -1);
     }
-    return math::multiply(std::move(values));
+    if (matrix) {
+        values.emplace_back(std::move(matrix));
+    }
+    return MakeProduct(std::move(values));
+}
+
+// Matrices do not commute, so a factor with a matrix in it, such as (A+B) or A^{-1}, is simplified
+// and multiplied in order here; the product keeps only the result
+void Parser::AddFactor(std::vector<std::unique_ptr<tree::IExpr>>& values, std::unique_ptr<tree::Matrix>& matrix,
+                       std::unique_ptr<tree::IExpr>&& factor, const bool inverse) {
+    if (HasMatrix(*factor)) {
+        math::simplify(factor);
+    }
+    if (!factor->Is<tree::Matrix>()) {
+        values.emplace_back(inverse ? MakeInverse(std::move(factor)) : std::move(factor));
+        return;
+    }
+    std::unique_ptr<tree::Matrix> next{factor.release()->As<tree::Matrix>()};
+    if (inverse) {
+        next = next->Inverse();
+    }
+    matrix = matrix ? matrix->Multiply(*next) : std::move(next);
 }
 
 
@@ -92,7 +181,7 @@ std::unique_ptr<tree::IExpr> Parser::ParsePower() {
     auto base = ParseObject();
     if (m_lexer.GetToken() == token::operation::pow) {
         m_lexer.NextToken();
-        return math::exp(std::move(base), ReadArgument());
+        return MakePower(std::move(base), ReadArgument());
     }
     return base;
 }
@@ -188,6 +277,7 @@ std::unique_ptr<tree::IExpr> Parser::ParseObject() {
 }
 
 std::unique_ptr<tree::IExpr> Parser::ParseCommand() {
+    const Nesting nesting{*this};
     if (auto it = s_commandParsers.find(std::string{m_lexer.GetToken()->Value}); it != s_commandParsers.end()) {
         return it->second(this);
     }
@@ -227,15 +317,208 @@ std::unique_ptr<tree::IExpr> Parser::ReadArgument() {
     throw exception::ParserException{"expected argument"};
 }
 
-std::unique_ptr<tree::IExpr> ParseTree(const std::string_view str) {
-    return Parser{str}.BuildTree();
+std::unique_ptr<tree::IExpr> ParseTree(const std::string_view str, const ParserOptions& options) {
+    return Parser{str, options}.BuildTree();
+}
+
+std::vector<tree::Equation> ParseSystem(const std::string_view str, const ParserOptions& options) {
+    return Parser{str, options}.BuildSystem();
 }
 
 std::unique_ptr<tree::IExpr> Parser::ParseFrac() {
     m_lexer.NextToken(); // Skip \\frac
-    auto arg1 = ReadArgument();
-    auto arg2 = ReadArgument();
-    return math::multiply(std::move(arg1), math::inverse(std::move(arg2)));
+    std::vector<std::unique_ptr<tree::IExpr>> values;
+    std::unique_ptr<tree::Matrix> matrix;
+    AddFactor(values, matrix, ReadArgument(), false);
+    AddFactor(values, matrix, ReadArgument(), true);
+    if (matrix) {
+        values.emplace_back(std::move(matrix));
+    }
+    return MakeProduct(std::move(values));
+}
+
+std::unique_ptr<tree::IExpr> Parser::ParseLog() {
+    m_lexer.NextToken(); // Skip \\ln
+    return math::log(ParseObject());
+}
+
+std::string_view Parser::ReadEnvironmentName() {
+    if (!SkipToken(token::bracket::curly::opening)) {
+        throw exception::ParserException{"expected '{' before environment name"};
+    }
+    const auto first = m_lexer.GetToken();
+    auto last = first;
+    while (m_lexer.GetToken() && m_lexer.GetToken()->Type == Token::EType::Symbol) {
+        last = m_lexer.GetToken();
+        m_lexer.NextToken();
+    }
+    if (!SkipToken(token::bracket::curly::closing) || last->Type != Token::EType::Symbol) {
+        throw exception::ParserException{"expected environment name in '{}'"};
+    }
+    return {first->Value.begin(), last->Value.end()};
+}
+
+std::unique_ptr<tree::IExpr> Parser::ParseEnvironment() {
+    m_lexer.NextToken(); // Skip \\begin
+    const auto name = ReadEnvironmentName();
+    if (name != "matrix" && name != "pmatrix" && name != "bmatrix" && name != "vmatrix") {
+        throw exception::ParserException{fmt::format("environment {} is not supported currently", name)};
+    }
+
+    tree::Matrix::Entries entries;
+    size_t rows = 0, cols = 0, col = 0;
+    while (!SkipToken(token::command::end)) {
+        if (!m_lexer.GetToken()) {
+            throw exception::ParserException{fmt::format("\\end{{{}}} not found", name)};
+        }
+        entries.emplace_back(ParseExpression());
+        ++col;
+        if (SkipToken(token::matrix::operation::new_col)) {
+            continue;
+        }
+        // a trailing \\ before \end is allowed
+        if (!SkipToken(token::matrix::operation::new_row) && m_lexer.GetToken() != token::command::end) {
+            throw exception::ParserException{"expected '&', '\\\\' or \\end in matrix"};
+        }
+        if (rows > 0 && col != cols) {
+            throw exception::ParserException{"matrix rows have different lengths"};
+        }
+        cols = col;
+        col = 0;
+        ++rows;
+    }
+    if (ReadEnvironmentName() != name) {
+        throw exception::ParserException{fmt::format("expected \\end{{{}}}", name)};
+    }
+    if (col != 0) {
+        throw exception::ParserException{"expected matrix entry after '&'"};
+    }
+    if (entries.empty()) {
+        throw exception::ParserException{"empty matrix"};
+    }
+
+    auto matrix = math::matrix(rows, cols, std::move(entries));
+    if (name == "vmatrix") {
+        return matrix->Determinant();
+    }
+    return matrix;
+}
+
+// The constructors already add up numbers and merge nested sums, so folding only needs to drop a
+// sum of one operand
+std::unique_ptr<tree::IExpr> Parser::MakeSum(std::vector<std::unique_ptr<tree::IExpr>>&& values) const {
+    if (!m_options.Fold) {
+        return math::add(std::move(values));
+    }
+    tree::BigNum constant{0};
+    std::unique_ptr<tree::IExpr>* operand = nullptr;
+    size_t operands = 0;
+    for (auto& value : values) {
+        if (const auto* number = NumberValue(value)) {
+            constant += *number;
+        } else {
+            operand = &value;
+            ++operands;
+        }
+    }
+    if (operands == 0) {
+        return math::number(std::move(constant));
+    }
+    if (operands == 1 && constant.Sign() == 0) {
+        return std::move(*operand);
+    }
+    return math::add(std::move(values));
+}
+
+// Factors are passed on in order even when folding, since a zero coefficient drops only the
+// factors before it. A number is not folded with a factor that divides by zero: a folded zero
+// would drop it, and simplify would not see it
+std::unique_ptr<tree::IExpr> Parser::MakeProduct(std::vector<std::unique_ptr<tree::IExpr>>&& values) const {
+    if (!m_options.Fold) {
+        return math::multiply(std::move(values));
+    }
+    tree::BigNum coefficient{1};
+    std::unique_ptr<tree::IExpr>* operand = nullptr;
+    size_t operands = 0;
+    for (auto& value : values) {
+        if (const auto* number = NumberValue(value)) {
+            coefficient *= *number;
+        } else {
+            operand = &value;
+            ++operands;
+        }
+    }
+    if (operands == 0) {
+        return math::number(std::move(coefficient));
+    }
+    if (operands < values.size()) {
+        for (const auto& value : values) {
+            if (HasZeroDenominator(*value)) {
+                throw tree::exception::CalcException{"division by zero"};
+            }
+        }
+    }
+    if (operands == 1 && coefficient == 1) {
+        return std::move(*operand);
+    }
+    return math::multiply(std::move(values));
+}
+
+// 0^0 and 0^{-n} are left to simplify, which decides what they mean
+std::unique_ptr<tree::IExpr> Parser::MakePower(std::unique_ptr<tree::IExpr>&& base, std::unique_ptr<tree::IExpr>&& exp) {
+    const auto* baseValue = NumberValue(base);
+    const auto* expValue = NumberValue(exp);
+    if (m_options.Fold && baseValue && expValue && expValue->IsInteger() && expValue->Abs() <= MAX_FOLDED_EXPONENT
+        && (baseValue->Sign() != 0 || expValue->Sign() > 0)) {
+        auto res = baseValue->Pow(expValue->Abs().Decompose().first.convert_to<uint32_t>());
+        return math::number(expValue->Sign() < 0 ? tree::BigNum{1} / res : std::move(res));
+    }
+    if (baseValue && baseValue->Sign() == 0 && expValue && expValue->Sign() < 0) {
+        ++m_zeroDenominators;
+    }
+    // Unfolded, the base or exponent would be simplified first and divide by zero; folded, a
+    // power of a power may be rewritten without looking at them
+    if (m_options.Fold && (baseValue || expValue) && HasZeroDenominator(baseValue ? *exp : *base)) {
+        throw tree::exception::CalcException{"division by zero"};
+    }
+    return math::exp(std::move(base), std::move(exp));
+}
+
+std::unique_ptr<tree::IExpr> Parser::MakeNegation(std::unique_ptr<tree::IExpr>&& value) const {
+    if (m_options.Fold) {
+        if (const auto* number = NumberValue(value)) {
+            return math::number(-*number);
+        }
+    }
+    return math::negate(std::move(value));
+}
+
+std::unique_ptr<tree::IExpr> Parser::MakeInverse(std::unique_ptr<tree::IExpr>&& value) {
+    if (const auto* number = NumberValue(value)) {
+        if (number->Sign() == 0) {
+            ++m_zeroDenominators;
+        } else if (m_options.Fold) {
+            return math::number(tree::BigNum{1} / *number);
+        }
+    }
+    return math::inverse(std::move(value));
+}
+
+bool Parser::HasZeroDenominator(const tree::IExpr& expr) const {
+    if (m_zeroDenominators == 0) {
+        return false;
+    }
+    bool found = false;
+    tree::traverse::PreOrder(expr, [&found](const tree::IExpr& node) {
+        if (node.Is<tree::Power>()) {
+            const auto* power = node.As<tree::Power>();
+            const auto* base = power->GetBase().Is<tree::Number>() ? power->GetBase().As<tree::Number>() : nullptr;
+            const auto* exp = power->GetExp().Is<tree::Number>() ? power->GetExp().As<tree::Number>() : nullptr;
+            found |= base && exp && base->Value() == 0 && exp->Value().Sign() < 0;
+        }
+        return !found;
+    });
+    return found;
 }
 
 } // namespace ezmath::parsing
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <tree/async.hpp>
+#include <tree/math.hpp>
+#include <tree/yield.hpp>
+
+namespace ezmath::tree {
+
+void QueueExecutor::Post(const std::coroutine_handle<> coroutine) {
+    std::lock_guard lock{m_mutex};
+    m_queue.emplace_back(coroutine);
+}
+
+bool QueueExecutor::RunOne() {
+    std::coroutine_handle<> coroutine;
+    {
+        std::lock_guard lock{m_mutex};
+        if (m_queue.empty()) {
+            return false;
+        }
+        coroutine = m_queue.front();
+        m_queue.pop_front();
+    }
+    coroutine.resume();
+    return true;
+}
+
+size_t QueueExecutor::RunPending() {
+    size_t pending;
+    {
+        std::lock_guard lock{m_mutex};
+        pending = m_queue.size();
+    }
+    for (size_t i = 0; i < pending; ++i) {
+        RunOne();
+    }
+    return pending;
+}
+
+ThreadPoolExecutor::ThreadPoolExecutor(const size_t threads) {
+    m_threads.reserve(std::max<size_t>(threads, 1));
+    for (size_t i = 0; i < std::max<size_t>(threads, 1); ++i) {
+        m_threads.emplace_back([this] { Work(); });
+    }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+    {
+        std::lock_guard lock{m_mutex};
+        m_stopped = true;
+    }
+    m_ready.notify_all();
+    m_threads.clear();
+}
+
+void ThreadPoolExecutor::Post(const std::coroutine_handle<> coroutine) {
+    {
+        std::lock_guard lock{m_mutex};
+        m_queue.emplace_back(coroutine);
+    }
+    m_ready.notify_one();
+}
+
+void ThreadPoolExecutor::Work() {
+    while (true) {
+        std::coroutine_handle<> coroutine;
+        {
+            std::unique_lock lock{m_mutex};
+            m_ready.wait(lock, [this] { return m_stopped || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            coroutine = m_queue.front();
+            m_queue.pop_front();
+        }
+        coroutine.resume();
+    }
+}
+
+bool SimplifyStep(std::unique_ptr<IExpr>& val, const size_t quantum) {
+    yield::Quantum limit{quantum};
+    math::simplify(val);
+    return !limit.Exhausted();
+}
+
+Task<std::unique_ptr<IExpr>> SimplifyAsync(std::unique_ptr<IExpr> val, Executor& executor, const size_t quantum) {
+    co_await Schedule{executor};
+    while (!SimplifyStep(val, quantum)) {
+        co_await Schedule{executor};
+    }
+    co_return val;
+}
+
+}
@@ -2,9 +2,211 @@
 #include <tree/bigint.hpp>
 #include <tree/hash_utils.hpp>
 #include <fmt/format.h>
+#include <cctype>
+#include <charconv>
+#include <span>
 
 namespace ezmath::tree {
 
+namespace {
+
+using Integer = BigNum::Integer;
+
+// Longer decimal strings are converted by halves; shorter ones go through boost directly
+constexpr size_t BASE_DIGITS = 1152;
+// Reciprocals of shorter divisors are computed by plain division
+constexpr size_t RECIPROCAL_BASE_BITS = 4096;
+
+thread_local NumberFormat currentFormat;
+
+size_t BitLength(const Integer& val) {
+    return val == 0 ? 0 : boost::multiprecision::msb(boost::multiprecision::abs(val)) + 1;
+}
+
+// floor(4^n / d) for d of n bits, refined by a Newton step from the reciprocal of the upper half of d
+Integer Reciprocal(const Integer& d, const size_t n) {
+    if (n <= RECIPROCAL_BASE_BITS) {
+        return (Integer{1} << (2 * n)) / d;
+    }
+    const auto half = (n + 1) / 2;
+    const auto shift = n - half;
+    Integer res = Reciprocal(d >> shift, half) << shift;
+    res = (res << 1) - ((d * res * res) >> (2 * n));
+
+    Integer rem = (Integer{1} << (2 * n)) - d * res;
+    while (rem < 0) {
+        --res;
+        rem += d;
+    }
+    while (rem >= d) {
+        ++res;
+        rem -= d;
+    }
+    return res;
+}
+
+// Division by multiplication with a precomputed reciprocal (Barrett reduction);
+// boost divides in quadratic time, while its multiplication is subquadratic
+class Divisor {
+public:
+    explicit Divisor(Integer value)
+        : m_value{std::move(value)}
+        , m_bits{BitLength(m_value)}
+        , m_reciprocal{Reciprocal(m_value, m_bits)}
+    {}
+
+    // Requires 0 <= x < value^2
+    std::pair<Integer, Integer> DivMod(const Integer& x) const {
+        Integer quotient = ((x >> (m_bits - 1)) * m_reciprocal) >> (m_bits + 1);
+        Integer remainder = x - quotient * m_value;
+        while (remainder >= m_value) {
+            ++quotient;
+            remainder -= m_value;
+        }
+        return {std::move(quotient), std::move(remainder)};
+    }
+
+    const Integer& Value() const noexcept { return m_value; }
+
+private:
+    Integer m_value;
+    size_t m_bits;
+    Integer m_reciprocal;
+};
+
+// 10^(BASE_DIGITS * 2^i) for i = 0, 1, ... while the previous one is not greater than bound
+std::vector<Integer> PowersOfTen(const Integer& bound) {
+    std::vector<Integer> res{boost::multiprecision::pow(Integer{10}, BASE_DIGITS)};
+    while (res.back() <= bound) {
+        res.emplace_back(res.back() * res.back());
+    }
+    return res;
+}
+
+void AppendDecimal(std::string& out, const Integer& val, const std::span<const Divisor> powers, const size_t width) {
+    auto level = powers.size();
+    while (level > 0 && powers[level - 1].Value() > val) {
+        --level;
+    }
+    if (level == 0) {
+        const auto digits = val.convert_to<std::string>();
+        out.append(digits.size() < width ? width - digits.size() : 0, '0');
+        out += digits;
+        return;
+    }
+
+    // val < powers[level - 1]^2, since the next power is greater than val
+    const auto lowDigits = BASE_DIGITS << (level - 1);
+    const auto [high, low] = powers[level - 1].DivMod(val);
+    AppendDecimal(out, high, powers.first(level - 1), width > lowDigits ? width - lowDigits : 0);
+    AppendDecimal(out, low, powers.first(level - 1), lowDigits);
+}
+
+std::string ToDecimal(const Integer& val) {
+    // fewer than BASE_DIGITS decimal digits
+    if (BigNum::Backend::FAST_DECIMAL || BitLength(val) < BASE_DIGITS * 3) {
+        return val.convert_to<std::string>();
+    }
+
+    const Integer abs = boost::multiprecision::abs(val);
+    auto powers = PowersOfTen(abs);
+    std::vector<Divisor> divisors;
+    divisors.reserve(powers.size() - 1);
+    for (size_t i = 0; i + 1 < powers.size(); ++i) {
+        divisors.emplace_back(std::move(powers[i]));
+    }
+
+    std::string res = val < 0 ? "-" : "";
+    AppendDecimal(res, abs, divisors, 0);
+    return res;
+}
+
+Integer FromDecimal(const std::string_view digits, const std::span<const Integer> powers) {
+    if (digits.size() <= BASE_DIGITS || powers.empty()) {
+        // boost reads a leading zero as the octal prefix
+        const auto start = digits.find_first_not_of('0');
+        return start == std::string_view::npos ? Integer{0} : Integer{std::string{digits.substr(start)}};
+    }
+    size_t level = 0;
+    while ((BASE_DIGITS << (level + 1)) < digits.size()) {
+        ++level;
+    }
+    const auto split = digits.size() - (BASE_DIGITS << level);
+    return FromDecimal(digits.substr(0, split), powers) * powers[level] + FromDecimal(digits.substr(split), powers);
+}
+
+Integer FromDecimal(const std::string_view digits) {
+    if (digits.starts_with('-')) {
+        return -FromDecimal(digits.substr(1));
+    }
+    if (!std::ranges::all_of(digits, [](char c) { return '0' <= c && c <= '9'; })) {
+        // boost reports malformed input
+        return Integer{std::string{digits}};
+    }
+    std::vector<Integer> powers;
+    if (!BigNum::Backend::FAST_DECIMAL && digits.size() > BASE_DIGITS) {
+        powers.emplace_back(boost::multiprecision::pow(Integer{10}, BASE_DIGITS));
+    }
+    while (!powers.empty() && (BASE_DIGITS << powers.size()) < digits.size()) {
+        powers.emplace_back(powers.back() * powers.back());
+    }
+    return FromDecimal(digits, powers);
+}
+
+std::optional<int64_t> FromShortDecimal(const std::string_view digits) {
+    constexpr size_t MAX_SHORT_DIGITS = 18;
+    int64_t res = 0;
+    if (digits.empty()) {
+        return res;
+    }
+    if (digits.size() > MAX_SHORT_DIGITS || !std::isdigit(static_cast<unsigned char>(digits.front()))) {
+        return std::nullopt;
+    }
+    const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), res);
+    if (error != std::errc{} || end != digits.data() + digits.size()) {
+        return std::nullopt;
+    }
+    return res;
+}
+
+Integer FromInteger(const std::string_view digits) {
+    if (const auto val = FromShortDecimal(digits)) {
+        return Integer{*val};
+    }
+    return FromDecimal(digits);
+}
+
+std::string Shorten(std::string digits, const NumberFormat& format) {
+    const bool negative = !digits.empty() && digits.front() == '-';
+    const auto count = digits.size() - negative;
+    if (format.Style == NumberFormat::EStyle::Exact || count <= std::max<size_t>(format.MaxDigits, 2)) {
+        return digits;
+    }
+
+    const auto sign = negative ? "-" : "";
+    const std::string_view abs = std::string_view{digits}.substr(negative);
+    // At least the leading digit is kept
+    const auto maxDigits = std::max<size_t>(format.MaxDigits, 1);
+    if (format.Style == NumberFormat::EStyle::Scientific) {
+        // digits are cut, not rounded
+        const auto fraction = abs.substr(1, maxDigits - 1);
+        return fmt::format("{}{}{}{}\\cdot10^{{{}}}", sign, abs.front(), fraction.empty() ? "" : ".", fraction, count - 1);
+    }
+    const auto head = (maxDigits + 1) / 2;
+    const auto tail = std::max<size_t>(maxDigits / 2, 1);
+    return fmt::format("{}{}\\ldots{}", sign, abs.substr(0, head), abs.substr(abs.size() - tail));
+}
+
+} // namespace
+
+NumberFormatScope::NumberFormatScope(const NumberFormat format) noexcept
+    : m_previous{std::exchange(currentFormat, format)}
+{}
+
+NumberFormatScope::~NumberFormatScope() {
+    currentFormat = m_previous;
+}
+
 BigNum::BigNum()
     : BigNum{0} 
 {}
@@ -14,24 +216,58 @@ BigNum::BigNum(int64_t val)
 {}
 
 BigNum::BigNum(const std::string_view str) {
+    if (const auto slash = str.find('/'); slash != std::string_view::npos) {
+        auto divisor = FromInteger(str.substr(slash + 1));
+        if (divisor == 0) {
+            throw exception::CalcException{"division by zero"};
+        }
+        m_value = Backend::Fraction(FromInteger(str.substr(0, slash)), std::move(divisor));
+        return;
+    }
+
     const auto point = str.find('.');
+    const auto whole = str.substr(0, point);
     if (point == std::string::npos) {
-        m_value = Rational{str};
+        if (const auto val = FromShortDecimal(whole)) {
+            m_value = *val;
+        } else {
+            m_value = Rational{FromDecimal(whole)};
+        }
         return;
     }
 
-    std::string dividend = fmt::format("{}{}", str.substr(0, point), str.substr(point + 1));
-    const auto zeros = str.size() - point - 1;
-    std::string divisor(1, '1');
-    divisor.resize(1 + zeros, '0');
+    const auto fraction = str.substr(point + 1);
+    const auto wholeVal = FromShortDecimal(whole);
+    const auto fractionVal = FromShortDecimal(fraction);
+    if (wholeVal && fractionVal && whole.size() + fraction.size() <= 18) {
+        const auto scale = static_cast<int64_t>(boost::multiprecision::pow(Integer{10}, static_cast<unsigned>(fraction.size())));
+        m_value = Backend::Fraction(Integer{*wholeVal * scale + *fractionVal}, Integer{scale});
+        return;
+    }
 
-    m_value = Rational{dividend, divisor};
+    auto dividend = FromDecimal(fmt::format("{}{}", whole, fraction));
+    Integer divisor = boost::multiprecision::pow(Integer{10}, static_cast<unsigned>(fraction.size()));
+    m_value = Backend::Fraction(std::move(dividend), std::move(divisor));
 }
 
 BigNum::BigNum(Rational val) 
     : m_value{std::move(val)}
 {}
 
+hash::Fingerprint BigNum::Fingerprint() const {
+    constexpr uint64_t RANDOM_BASE = 6104214307871493911u;
+    const auto absorbInteger = [](hash::Fingerprint fp, const Integer& value) {
+        const auto limbs = backend::Limbs(value);
+        for (size_t i = 0; i < limbs.size(); i += 2) {
+            fp = hash::absorb(fp, limbs[i], i + 1 < limbs.size() ? limbs[i + 1] : 0);
+        }
+        return hash::absorb(fp, limbs.size(), static_cast<uint64_t>(value.sign()));
+    };
+
+    const auto [num, den] = Decompose();
+    return hash::finalize(absorbInteger(absorbInteger({RANDOM_BASE, ~RANDOM_BASE}, num), den));
+}
+
 size_t BigNum::Hash() const {
     return boost::multiprecision::hash_value(m_value);
 }
@@ -45,13 +281,72 @@ int BigNum::Sign() const {
 }
 
 std::string BigNum::ToString() const {
-    auto numerator = boost::multiprecision::numerator(m_value);
-    auto denominator = boost::multiprecision::denominator(m_value);
+    return ToString(currentFormat);
+}
 
+std::string BigNum::ToString(const NumberFormat& format) const {
+    const auto [numerator, denominator] = Decompose();
     if (denominator == 1) {
-        return numerator.convert_to<std::string>();
+        return Shorten(ToDecimal(numerator), format);
+    }
+    return fmt::format("\\frac{{{}}}{{{}}}", Shorten(ToDecimal(numerator), format), Shorten(ToDecimal(denominator), format));
+}
+
+BigNum BigNum::Numerator() const {
+    return Rational{boost::multiprecision::numerator(m_value)};
+}
+
+BigNum BigNum::Denominator() const {
+    return Rational{boost::multiprecision::denominator(m_value)};
+}
+
+BigNum BigNum::Abs() const {
+    return Rational{boost::multiprecision::abs(m_value)};
+}
+
+BigNum BigNum::Pow(const uint32_t exp) const {
+    // the powers are evaluated as integers: an expression template converted to Rational would be
+    // evaluated in rational arithmetic, reducing every intermediate product by a gcd
+    auto [num, den] = Decompose();
+    Integer numPow = boost::multiprecision::pow(num, exp);
+    if (den == 1) {
+        return Rational{std::move(numPow)};
+    }
+    Integer denPow = boost::multiprecision::pow(den, exp);
+    return Rational{std::move(numPow), std::move(denPow)};
+}
+
+std::pair<BigNum, BigNum> BigNum::DivMod(const BigNum& divisor) const {
+    if (!IsInteger() || !divisor.IsInteger()) {
+        throw exception::CalcException{"integer division of non-integer numbers"};
+    }
+    if (divisor == 0) {
+        throw exception::CalcException{"division by zero"};
+    }
+
+    const auto num = boost::multiprecision::numerator(m_value);
+    const auto den = boost::multiprecision::numerator(divisor.m_value);
+
+    Integer quotient = num / den;
+    Integer remainder = num % den;
+    if (remainder != 0 && (remainder < 0) != (den < 0)) {
+        --quotient;
+        remainder += den;
     }
-    return fmt::format("\\frac{{{}}}{{{}}}", numerator.convert_to<std::string>(), denominator.convert_to<std::string>());
+    return {Rational{std::move(quotient)}, Rational{std::move(remainder)}};
+}
+
+BigNum BigNum::Sqrt() const {
+    if (!IsInteger() || Sign() < 0) {
+        throw exception::CalcException{"square root of non-natural number"};
+    }
+    return Rational{boost::multiprecision::sqrt(boost::multiprecision::numerator(m_value))};
+}
+
+BigNum BigNum::Gcd(const BigNum& lhs, const BigNum& rhs) {
+    auto [lnum, lden] = lhs.Decompose();
+    auto [rnum, rden] = rhs.Decompose();
+    return Rational{boost::multiprecision::gcd(lnum, rnum), boost::multiprecision::lcm(lden, rden)};
 }
 
 BigNum BigNum::operator-() const {
@@ -0,0 +1,165 @@
+#include <tree/calculus.hpp>
+#include <tree/math.hpp>
+#include <tree/visit.hpp>
+#include <unordered_map>
+
+namespace ezmath::tree {
+
+namespace {
+
+struct ExprHash {
+    size_t operator()(const IExpr* expr) const { return expr->Hash(); }
+};
+
+struct ExprEqual {
+    bool operator()(const IExpr* lhs, const IExpr* rhs) const { return lhs->IsEqualTo(*rhs); }
+};
+
+class Differentiator {
+public:
+    explicit Differentiator(const std::string_view var)
+        : m_var{var}
+        , m_varBit{Symbol::MaskBit(var)}
+    {}
+
+    // nullptr if expr does not depend on the variable
+    const IExpr* Derivative(const IExpr& expr) {
+        if (auto it = m_derivatives.find(&expr); it != m_derivatives.end()) {
+            return it->second.get();
+        }
+        auto res = expr.Meta().Symbols & m_varBit ? Visit(*this, expr) : nullptr;
+        return m_derivatives.emplace(&expr, std::move(res)).first->second.get();
+    }
+
+    std::unique_ptr<IExpr> operator()(const Number&) { return nullptr; }
+
+    std::unique_ptr<IExpr> operator()(const Symbol& symbol) {
+        return symbol.Name() == m_var ? math::number(1) : nullptr;
+    }
+
+    std::unique_ptr<IExpr> operator()(const Sum& sum) {
+        std::vector<std::unique_ptr<IExpr>> terms;
+        for (const auto& term : sum.GetTerms()) {
+            if (const auto derivative = Derivative(*term.Expression)) {
+                terms.emplace_back(derivative->Copy());
+            }
+        }
+        return terms.empty() ? nullptr : math::add(std::move(terms));
+    }
+
+    std::unique_ptr<IExpr> operator()(const Product& product) {
+        // The coefficient and constant factors do not depend on any symbol
+        std::vector<const IExpr*> factors;
+        std::vector<const IExpr*> derivatives;
+        for (const auto& mul : product.GetVariables()) {
+            factors.push_back(mul.Expression.get());
+            derivatives.push_back(Derivative(*mul.Expression));
+        }
+        const auto dependent = std::ranges::count_if(derivatives, [](const auto* val) { return val != nullptr; });
+        if (dependent == 0) {
+            return nullptr;
+        }
+
+        if (dependent >= LOG_DIFFERENTIATION_FACTORS) {
+            std::vector<std::unique_ptr<IExpr>> terms;
+            for (size_t i = 0; i < factors.size(); ++i) {
+                if (derivatives[i]) {
+                    terms.emplace_back(LogDerivative(*factors[i], *derivatives[i]));
+                }
+            }
+            return math::multiply(product.Copy(), math::add(std::move(terms)));
+        }
+
+        // Product rule: the derivative of one factor times copies of the others
+        std::vector<std::unique_ptr<IExpr>> terms;
+        for (size_t i = 0; i < factors.size(); ++i) {
+            if (!derivatives[i]) {
+                continue;
+            }
+            std::vector<std::unique_ptr<IExpr>> muls;
+            muls.emplace_back(math::number(product.GetCoefficient()));
+            for (const auto& mul : product.GetConstants()) {
+                muls.emplace_back(mul.Expression->Copy());
+            }
+            for (size_t j = 0; j < factors.size(); ++j) {
+                muls.emplace_back(j == i ? derivatives[i]->Copy() : factors[j]->Copy());
+            }
+            terms.emplace_back(math::multiply(std::move(muls)));
+        }
+        return terms.size() == 1 ? std::move(terms.front()) : math::add(std::move(terms));
+    }
+
+    std::unique_ptr<IExpr> operator()(const Power& power) {
+        const auto& base = power.GetBase();
+        const auto& exp = power.GetExp();
+        const auto baseDerivative = Derivative(base);
+        const auto expDerivative = Derivative(exp);
+
+        // (b^e)' = e * b^(e-1) * b' for e independent of the variable
+        if (!expDerivative) {
+            return baseDerivative ? math::multiply(
+                exp.Copy(),
+                math::exp(base.Copy(), math::add(exp.Copy(), math::number(-1))),
+                baseDerivative->Copy()) : nullptr;
+        }
+        return math::multiply(power.Copy(), LogDerivative(power, *expDerivative, baseDerivative));
+    }
+
+    std::unique_ptr<IExpr> operator()(const Log& log) {
+        const auto derivative = Derivative(log.GetArgument());
+        return derivative ? math::multiply(derivative->Copy(), math::inverse(log.GetArgument().Copy())) : nullptr;
+    }
+
+    // Entries are copies, so each of them gets its own memo
+    std::unique_ptr<IExpr> operator()(const Matrix& matrix) {
+        Matrix::Entries entries;
+        entries.reserve(matrix.Rows() * matrix.Cols());
+        for (size_t row = 0; row < matrix.Rows(); ++row) {
+            for (size_t col = 0; col < matrix.Cols(); ++col) {
+                entries.emplace_back(Differentiate(*matrix.Entry(row, col), m_var));
+            }
+        }
+        return math::matrix(matrix.Rows(), matrix.Cols(), std::move(entries));
+    }
+
+private:
+    static constexpr ptrdiff_t LOG_DIFFERENTIATION_FACTORS = 4;
+
+    // f'/f given f'; powers use (b^e)'/b^e = e' * ln(b) + e * b'/b without dividing by b^e
+    std::unique_ptr<IExpr> LogDerivative(const IExpr& factor, const IExpr& derivative) {
+        if (!factor.Is<Power>()) {
+            return math::multiply(derivative.Copy(), math::inverse(factor.Copy()));
+        }
+        const auto& power = *factor.As<Power>();
+        const auto expDerivative = Derivative(power.GetExp());
+        const auto baseDerivative = Derivative(power.GetBase());
+        if (!expDerivative) {
+            return math::multiply(power.GetExp().Copy(), baseDerivative->Copy(), math::inverse(power.GetBase().Copy()));
+        }
+        return LogDerivative(power, *expDerivative, baseDerivative);
+    }
+
+    static std::unique_ptr<IExpr> LogDerivative(const Power& power, const IExpr& expDerivative, const IExpr* baseDerivative) {
+        auto res = math::multiply(expDerivative.Copy(), math::log(power.GetBase().Copy()));
+        if (!baseDerivative) {
+            return res;
+        }
+        return math::add(std::move(res), math::multiply(
+            power.GetExp().Copy(), baseDerivative->Copy(), math::inverse(power.GetBase().Copy())));
+    }
+
+private:
+    std::string_view m_var;
+    uint64_t m_varBit;
+    std::unordered_map<const IExpr*, std::unique_ptr<IExpr>, ExprHash, ExprEqual> m_derivatives;
+};
+
+}
+
+std::unique_ptr<IExpr> Differentiate(const IExpr& expr, const std::string_view var) {
+    Differentiator differentiator{var};
+    const auto res = differentiator.Derivative(expr);
+    return res ? res->Copy() : math::number(0);
+}
+
+}
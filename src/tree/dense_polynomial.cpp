@@ -0,0 +1,511 @@
+#include <tree/dense_polynomial.hpp>
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace ezmath::tree {
+
+namespace {
+
+using Integer = DensePolynomial::Integer;
+
+constexpr size_t KARATSUBA_THRESHOLD = 32;
+constexpr size_t NTT_THRESHOLD = 128;
+constexpr size_t NTT_TERMS_PER_PRIME = 24;
+
+size_t Bits(const Integer& value) {
+    return value == 0 ? 0 : boost::multiprecision::msb(boost::multiprecision::abs(value)) + 1;
+}
+
+size_t MaxBits(const std::span<const Integer> values) {
+    size_t res = 0;
+    for (const auto& val : values) {
+        res = std::max(res, Bits(val));
+    }
+    return res;
+}
+
+// res[shift + i] += values[i]
+void AddShifted(std::vector<Integer>& res, const std::span<const Integer> values, const size_t shift) {
+    for (size_t i = 0; i < values.size(); ++i) {
+        res[shift + i] += values[i];
+    }
+}
+
+std::vector<Integer> Schoolbook(const std::span<const Integer> lhs, const std::span<const Integer> rhs) {
+    std::vector<Integer> res(lhs.size() + rhs.size() - 1);
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i] == 0) {
+            continue;
+        }
+        for (size_t j = 0; j < rhs.size(); ++j) {
+            res[i + j] += lhs[i] * rhs[j];
+        }
+    }
+    return res;
+}
+
+std::vector<Integer> Karatsuba(std::span<const Integer> lhs, std::span<const Integer> rhs) {
+    if (lhs.size() < rhs.size()) {
+        std::swap(lhs, rhs);
+    }
+    if (rhs.size() < KARATSUBA_THRESHOLD) {
+        return Schoolbook(lhs, rhs);
+    }
+
+    std::vector<Integer> res(lhs.size() + rhs.size() - 1);
+    // Unbalanced factors: the longer one is cut into pieces as long as the shorter one
+    if (2 * rhs.size() <= lhs.size()) {
+        for (size_t shift = 0; shift < lhs.size(); shift += rhs.size()) {
+            AddShifted(res, Karatsuba(lhs.subspan(shift, std::min(rhs.size(), lhs.size() - shift)), rhs), shift);
+        }
+        return res;
+    }
+
+    // (a0 + a1 t)(b0 + b1 t) = z0 + ((a0 + a1)(b0 + b1) - z0 - z2) t + z2 t^2 with t = x^half
+    const auto half = lhs.size() / 2;
+    const auto sumHalves = [half](const std::span<const Integer> values) {
+        std::vector<Integer> res(std::max(half, values.size() - half));
+        std::copy_n(values.begin(), half, res.begin());
+        AddShifted(res, values.subspan(half), 0);
+        return res;
+    };
+    const auto z0 = Karatsuba(lhs.first(half), rhs.first(half));
+    const auto z2 = Karatsuba(lhs.subspan(half), rhs.subspan(half));
+    auto z1 = Karatsuba(sumHalves(lhs), sumHalves(rhs));
+    for (size_t i = 0; i < z0.size(); ++i) {
+        z1[i] -= z0[i];
+    }
+    for (size_t i = 0; i < z2.size(); ++i) {
+        z1[i] -= z2[i];
+    }
+
+    AddShifted(res, z0, 0);
+    AddShifted(res, z1, half);
+    AddShifted(res, z2, 2 * half);
+    return res;
+}
+
+// Primes p = c * 2^NTT_LOG + 1 between 2^30 and 2^31: residues multiply in 64-bit words,
+// and every prime has roots of unity for transforms up to 2^NTT_LOG points
+constexpr uint32_t NTT_LOG = 20;
+constexpr size_t NTT_PRIME_BITS = 30;
+
+struct NttPrime {
+    uint32_t Modulus;
+    // Primitive 2^NTT_LOG-th root of unity
+    uint32_t Root;
+};
+
+uint32_t PowMod(uint64_t base, uint64_t exp, const uint32_t mod) {
+    uint64_t res = 1;
+    base %= mod;
+    for (; exp; exp >>= 1) {
+        if (exp & 1) {
+            res = res * base % mod;
+        }
+        base = base * base % mod;
+    }
+    return static_cast<uint32_t>(res);
+}
+
+uint32_t InverseMod(const uint32_t value, const uint32_t mod) {
+    return PowMod(value, mod - 2, mod);
+}
+
+// Miller-Rabin with bases that are exact below 2^32
+bool IsPrime(const uint32_t n) {
+    if (n < 2 || n % 2 == 0) {
+        return n == 2;
+    }
+    const auto odd = (n - 1) >> std::countr_zero(n - 1);
+    for (const uint32_t base : {2u, 7u, 61u}) {
+        if (base % n == 0) {
+            continue;
+        }
+        uint64_t x = PowMod(base, odd, n);
+        if (x == 1 || x == n - 1) {
+            continue;
+        }
+        bool composite = true;
+        for (auto d = odd; d < n - 1 && composite; d <<= 1) {
+            x = x * x % n;
+            composite = x != n - 1;
+        }
+        if (composite) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Largest primes first, so that few of them cover the coefficients
+const std::vector<NttPrime>& NttPrimes() {
+    static const auto primes = [] {
+        std::vector<NttPrime> res;
+        for (uint32_t c = (1u << (31 - NTT_LOG)) - 1; c >= (1u << (30 - NTT_LOG)); --c) {
+            const uint32_t p = (c << NTT_LOG) + 1;
+            if (!IsPrime(p)) {
+                continue;
+            }
+            std::vector<uint32_t> factors{2};
+            auto rest = c;
+            for (uint32_t q = 2; q * q <= rest; ++q) {
+                if (rest % q == 0) {
+                    factors.push_back(q);
+                    while (rest % q == 0) {
+                        rest /= q;
+                    }
+                }
+            }
+            if (rest > 1) {
+                factors.push_back(rest);
+            }
+            for (uint32_t g = 2;; ++g) {
+                if (std::ranges::all_of(factors, [&](const auto q) { return PowMod(g, (p - 1) / q, p) != 1; })) {
+                    res.push_back({p, PowMod(g, c, p)});
+                    break;
+                }
+            }
+        }
+        return res;
+    }();
+    return primes;
+}
+
+void Ntt(std::vector<uint32_t>& values, const NttPrime& prime, const bool inverse) {
+    const auto n = values.size();
+    const auto mod = prime.Modulus;
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        auto bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(values[i], values[j]);
+        }
+    }
+
+    std::vector<uint32_t> twiddles(n / 2);
+    for (size_t len = 2; len <= n; len <<= 1) {
+        auto step = PowMod(prime.Root, (size_t{1} << NTT_LOG) / len, mod);
+        if (inverse) {
+            step = InverseMod(step, mod);
+        }
+        const auto half = len / 2;
+        twiddles[0] = 1;
+        for (size_t j = 1; j < half; ++j) {
+            twiddles[j] = static_cast<uint32_t>(uint64_t{twiddles[j - 1]} * step % mod);
+        }
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t j = 0; j < half; ++j) {
+                const auto u = values[i + j];
+                const auto v = static_cast<uint32_t>(uint64_t{values[i + j + half]} * twiddles[j] % mod);
+                values[i + j] = u + v >= mod ? u + v - mod : u + v;
+                values[i + j + half] = u >= v ? u - v : u + mod - v;
+            }
+        }
+    }
+
+    if (inverse) {
+        const uint64_t scale = InverseMod(static_cast<uint32_t>(n % mod), mod);
+        for (auto& val : values) {
+            val = static_cast<uint32_t>(val * scale % mod);
+        }
+    }
+}
+
+// Integer split into 32-bit words once, then reduced modulo each prime
+struct Words {
+    std::vector<uint32_t> Magnitude;   // most significant first
+    bool Negative = false;
+
+    explicit Words(const Integer& value)
+        : Negative{value < 0}
+    {
+        for (const auto limb : backend::Limbs(value)) {
+            Magnitude.push_back(static_cast<uint32_t>(limb >> 32));
+            Magnitude.push_back(static_cast<uint32_t>(limb));
+        }
+    }
+
+    uint32_t Residue(const uint32_t mod) const {
+        uint64_t res = 0;
+        for (const auto word : Magnitude) {
+            res = ((res << 32) | word) % mod;
+        }
+        return Negative && res ? static_cast<uint32_t>(mod - res) : static_cast<uint32_t>(res);
+    }
+};
+
+// Multiplies modulo enough primes to determine the coefficients and lifts them by Garner's
+// algorithm: the mixed-radix digits come out of word arithmetic, and only the final
+// Horner step uses big integers. nullopt if the product is beyond the available primes.
+std::optional<std::vector<Integer>> NttMultiply(const std::span<const Integer> lhs, const std::span<const Integer> rhs) {
+    const auto size = lhs.size() + rhs.size() - 1;
+    const auto length = std::bit_ceil(size);
+    const auto& primes = NttPrimes();
+    // |c| < 2^bits, and the residues must determine c in [-P/2, P/2)
+    const auto bits = MaxBits(lhs) + MaxBits(rhs) + std::bit_width(std::min(lhs.size(), rhs.size())) + 1;
+    const auto count = (bits + NTT_PRIME_BITS - 1) / NTT_PRIME_BITS;
+    if (length > (size_t{1} << NTT_LOG) || count > primes.size()) {
+        return std::nullopt;
+    }
+
+    const auto split = [](const std::span<const Integer> values) {
+        std::vector<Words> res;
+        res.reserve(values.size());
+        for (const auto& val : values) {
+            res.emplace_back(val);
+        }
+        return res;
+    };
+    const auto lhsWords = split(lhs);
+    const auto rhsWords = split(rhs);
+
+    // residues[i * count + k]: coefficient i modulo prime k
+    std::vector<uint32_t> residues(size * count);
+    std::vector<uint32_t> a(length), b(length);
+    for (size_t k = 0; k < count; ++k) {
+        const auto& prime = primes[k];
+        std::ranges::fill(a, 0);
+        std::ranges::fill(b, 0);
+        std::ranges::transform(lhsWords, a.begin(), [&](const auto& words) { return words.Residue(prime.Modulus); });
+        std::ranges::transform(rhsWords, b.begin(), [&](const auto& words) { return words.Residue(prime.Modulus); });
+        Ntt(a, prime, false);
+        Ntt(b, prime, false);
+        for (size_t i = 0; i < length; ++i) {
+            a[i] = static_cast<uint32_t>(uint64_t{a[i]} * b[i] % prime.Modulus);
+        }
+        Ntt(a, prime, true);
+        for (size_t i = 0; i < size; ++i) {
+            residues[i * count + k] = a[i];
+        }
+    }
+
+    // inverses[k * count + j] = p_j^-1 mod p_k for j < k
+    std::vector<uint32_t> inverses(count * count);
+    Integer modulus = 1;
+    for (size_t k = 0; k < count; ++k) {
+        for (size_t j = 0; j < k; ++j) {
+            inverses[k * count + j] = InverseMod(primes[j].Modulus % primes[k].Modulus, primes[k].Modulus);
+        }
+        modulus *= primes[k].Modulus;
+    }
+    const Integer halfModulus = modulus / 2;
+
+    std::vector<Integer> res(size);
+    std::vector<uint32_t> digits(count);
+    for (size_t i = 0; i < size; ++i) {
+        for (size_t k = 0; k < count; ++k) {
+            const auto mod = primes[k].Modulus;
+            uint64_t digit = residues[i * count + k];
+            for (size_t j = 0; j < k; ++j) {
+                digit = (digit + mod - digits[j] % mod) * inverses[k * count + j] % mod;
+            }
+            digits[k] = static_cast<uint32_t>(digit);
+        }
+        Integer value = digits[count - 1];
+        for (size_t k = count - 1; k-- > 0;) {
+            value = value * primes[k].Modulus + digits[k];
+        }
+        res[i] = value > halfModulus ? Integer{value - modulus} : value;
+    }
+    return res;
+}
+
+}
+
+DensePolynomial::DensePolynomial(std::vector<Integer> coefs, BigNum scale)
+    : m_coefficients{std::move(coefs)}
+    , m_scale{std::move(scale)}
+{
+    Normalize();
+}
+
+DensePolynomial DensePolynomial::Constant(BigNum value) {
+    return DensePolynomial{{1}, std::move(value)};
+}
+
+DensePolynomial DensePolynomial::Variable(const size_t exp) {
+    std::vector<Integer> coefs(exp + 1);
+    coefs[exp] = 1;
+    return DensePolynomial{std::move(coefs)};
+}
+
+std::optional<DensePolynomial> DensePolynomial::FromSparse(const Polynomial& poly) {
+    if (poly.Variables() > 1) {
+        return std::nullopt;
+    }
+    if (poly.IsZero()) {
+        return DensePolynomial{};
+    }
+
+    Integer denominators = 1;
+    for (size_t term = 0; term < poly.Size(); ++term) {
+        denominators = boost::multiprecision::lcm(denominators, poly.Coefficient(term).Decompose().second);
+    }
+    const auto exp = [&poly](const size_t term) -> size_t {
+        return poly.Variables() == 0 ? 0 : poly.Exponents(term)[0];
+    };
+
+    std::vector<Integer> coefs(exp(0) + 1);
+    for (size_t term = 0; term < poly.Size(); ++term) {
+        auto [num, den] = poly.Coefficient(term).Decompose();
+        coefs[exp(term)] = num * (denominators / den);
+    }
+    return DensePolynomial{std::move(coefs), BigNum::Backend::Fraction(1, std::move(denominators))};
+}
+
+Polynomial DensePolynomial::ToSparse() const {
+    Polynomial res{1};
+    for (size_t exp = m_coefficients.size(); exp-- > 0;) {
+        if (m_coefficients[exp] != 0) {
+            const Polynomial::Exponent exps[] = {static_cast<Polynomial::Exponent>(exp)};
+            res.PushTerm(exps, Coefficient(exp));
+        }
+    }
+    return res;
+}
+
+bool DensePolynomial::IsZero() const noexcept { return m_coefficients.empty(); }
+
+size_t DensePolynomial::Degree() const noexcept { return IsZero() ? 0 : m_coefficients.size() - 1; }
+
+BigNum DensePolynomial::Coefficient(const size_t exp) const {
+    if (exp >= m_coefficients.size()) {
+        return 0;
+    }
+    return m_scale * BigNum{BigNum::Rational{m_coefficients[exp]}};
+}
+
+std::span<const Integer> DensePolynomial::Integers() const noexcept { return m_coefficients; }
+
+const BigNum& DensePolynomial::Scale() const noexcept { return m_scale; }
+
+void DensePolynomial::Normalize() {
+    while (!m_coefficients.empty() && m_coefficients.back() == 0) {
+        m_coefficients.pop_back();
+    }
+    if (m_coefficients.empty() || m_scale == 0) {
+        m_coefficients.clear();
+        m_scale = 1;
+        return;
+    }
+
+    Integer content = 0;
+    for (const auto& coef : m_coefficients) {
+        content = boost::multiprecision::gcd(content, coef);
+        if (content == 1) {
+            break;
+        }
+    }
+    if (m_coefficients.back() < 0) {
+        content = -content;
+    }
+    if (content != 1) {
+        for (auto& coef : m_coefficients) {
+            coef /= content;
+        }
+        m_scale *= BigNum{BigNum::Rational{content}};
+    }
+}
+
+DensePolynomial DensePolynomial::Pow(uint32_t exp) const {
+    auto res = Constant(1);
+    auto base = *this;
+    while (exp) {
+        if (exp & 1) {
+            res = res * base;
+        }
+        exp >>= 1;
+        if (exp) {
+            base = base * base;
+        }
+    }
+    return res;
+}
+
+DensePolynomial DensePolynomial::operator-() const {
+    auto res = *this;
+    res.m_scale = -res.m_scale;
+    return res;
+}
+
+// Both sides are brought to the gcd of the scales, which leaves integer factors
+DensePolynomial DensePolynomial::operator+(const DensePolynomial& other) const {
+    if (IsZero()) {
+        return other;
+    }
+    if (other.IsZero()) {
+        return *this;
+    }
+    const auto scale = BigNum::Gcd(m_scale, other.m_scale);
+    const auto lhsFactor = (m_scale / scale).Decompose().first;
+    const auto rhsFactor = (other.m_scale / scale).Decompose().first;
+
+    std::vector<Integer> coefs(std::max(m_coefficients.size(), other.m_coefficients.size()));
+    for (size_t i = 0; i < m_coefficients.size(); ++i) {
+        coefs[i] = m_coefficients[i] * lhsFactor;
+    }
+    for (size_t i = 0; i < other.m_coefficients.size(); ++i) {
+        coefs[i] += other.m_coefficients[i] * rhsFactor;
+    }
+    return DensePolynomial{std::move(coefs), scale};
+}
+
+DensePolynomial DensePolynomial::operator-(const DensePolynomial& other) const {
+    return *this + -other;
+}
+
+// By Gauss's lemma the product of primitive polynomials is primitive, so it is not normalized again
+DensePolynomial DensePolynomial::operator*(const DensePolynomial& other) const {
+    if (IsZero() || other.IsZero()) {
+        return {};
+    }
+    DensePolynomial res;
+    res.m_coefficients = Multiply(m_coefficients, other.m_coefficients);
+    res.m_scale = m_scale * other.m_scale;
+    return res;
+}
+
+bool DensePolynomial::operator==(const DensePolynomial& other) const {
+    return m_scale == other.m_scale && m_coefficients == other.m_coefficients;
+}
+
+// The transforms are cheap, but lifting every coefficient costs about the square of the number
+// of primes, so wide coefficients need longer factors before NTT pays off
+DensePolynomial::EAlgorithm DensePolynomial::ChooseAlgorithm(const size_t lhsSize, const size_t rhsSize, const size_t bits) noexcept {
+    const auto shorter = std::min(lhsSize, rhsSize);
+    if (shorter < KARATSUBA_THRESHOLD) {
+        return EAlgorithm::Schoolbook;
+    }
+    const auto primes = (2 * bits + std::bit_width(shorter)) / NTT_PRIME_BITS + 1;
+    return shorter < std::max(NTT_THRESHOLD, NTT_TERMS_PER_PRIME * primes) ? EAlgorithm::Karatsuba : EAlgorithm::Ntt;
+}
+
+std::vector<Integer> DensePolynomial::Multiply(const std::span<const Integer> lhs, const std::span<const Integer> rhs) {
+    return Multiply(lhs, rhs, ChooseAlgorithm(lhs.size(), rhs.size(), std::max(MaxBits(lhs), MaxBits(rhs))));
+}
+
+std::vector<Integer> DensePolynomial::Multiply(const std::span<const Integer> lhs, const std::span<const Integer> rhs,
+                                               const EAlgorithm algorithm) {
+    if (lhs.empty() || rhs.empty()) {
+        return {};
+    }
+    switch (algorithm) {
+    case EAlgorithm::Schoolbook:
+        return Schoolbook(lhs, rhs);
+    case EAlgorithm::Karatsuba:
+        return Karatsuba(lhs, rhs);
+    case EAlgorithm::Ntt:
+        if (auto res = NttMultiply(lhs, rhs)) {
+            return std::move(*res);
+        }
+        return Karatsuba(lhs, rhs);
+    }
+    std::unreachable();
+}
+
+}
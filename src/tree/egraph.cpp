@@ -0,0 +1,355 @@
+#include <tree/egraph.hpp>
+#include <tree/exception.hpp>
+#include <tree/fingerprint.hpp>
+#include <tree/hash_utils.hpp>
+#include <tree/math.hpp>
+#include <algorithm>
+#include <numeric>
+#include <string_view>
+#include <unordered_set>
+
+namespace ezmath::tree::egraph {
+
+namespace {
+
+bool IsCommutative(const IExpr::EKind kind) {
+    return kind == IExpr::EKind::Sum || kind == IExpr::EKind::Product;
+}
+
+ENode LeafNode(const IExpr& expr) {
+    return {expr.Kind(), std::shared_ptr<const IExpr>{expr.Copy()}, {}};
+}
+
+// One rewriter per simplification rule of T, applied to a copy of the node alone. The rule that
+// simplifies children is left out, that is what the greedy simplifier does.
+template<class T>
+void AddNodeRewriters(std::vector<Rewriter>& rewriters) {
+    std::unordered_set<std::string_view> names;
+    for (const auto& rule : T::Rules()) {
+        if (rule.Interruptible || !names.insert(rule.Name).second) {
+            continue;
+        }
+        rewriters.emplace_back([rule](const IExpr& expr) -> std::unique_ptr<IExpr> {
+            if (!expr.Is<T>()) {
+                return nullptr;
+            }
+            auto res = expr.Copy();
+            // Rules either return a replacement or change the node in place
+            if (auto replacement = RunRule(*res->As<T>(), rule)) {
+                return replacement;
+            }
+            return res;
+        });
+    }
+}
+
+} // namespace
+
+bool ENode::operator==(const ENode& other) const {
+    if (Kind != other.Kind || Children != other.Children || !Leaf != !other.Leaf) {
+        return false;
+    }
+    return !Leaf || Leaf->IsEqualTo(*other.Leaf);
+}
+
+size_t ENodeHash::operator()(const ENode& node) const {
+    auto res = hash::combine(static_cast<size_t>(node.Kind), node.Leaf ? node.Leaf->Hash() : 0);
+    for (const auto child : node.Children) {
+        res = hash::combine(res, child);
+    }
+    return res;
+}
+
+size_t NodeCount::Cost(const ENode&, const std::span<const size_t> children) const {
+    return std::accumulate(children.begin(), children.end(), size_t{1});
+}
+
+size_t PrintLength::Cost(const ENode& node, const std::span<const size_t> children) const {
+    if (node.Leaf) {
+        return node.Leaf->ToString().size();
+    }
+    const auto total = std::accumulate(children.begin(), children.end(), size_t{0});
+    switch (node.Kind) {
+    case IExpr::EKind::Power:
+        return total + 3;   // ^{}
+    case IExpr::EKind::Log:
+        return total + 5;   // \ln()
+    case IExpr::EKind::Sum:
+        return total + children.size();   // signs and brackets
+    default:
+        return total + 1;
+    }
+}
+
+std::vector<Rewriter> NodeRewriters() {
+    std::vector<Rewriter> rewriters;
+    AddNodeRewriters<Sum>(rewriters);
+    AddNodeRewriters<Product>(rewriters);
+    AddNodeRewriters<Power>(rewriters);
+    AddNodeRewriters<Log>(rewriters);
+    return rewriters;
+}
+
+std::vector<Rewriter> DefaultRewriters() {
+    std::vector<Rewriter> rewriters = {
+        [](const IExpr& expr) {
+            auto res = expr.Copy();
+            math::simplify(res);
+            return res;
+        },
+        [](const IExpr& expr) -> std::unique_ptr<IExpr> {
+            constexpr size_t MAX_EXPANDED_TERMS = 256;
+            PolynomialRing ring;
+            auto poly = ring.FromExpr(expr, MAX_EXPANDED_TERMS);
+            return poly ? ring.ToExpr(*poly) : nullptr;
+        },
+        [](const IExpr& expr) {
+            auto res = expr.Copy();
+            math::cancel(res);
+            return res;
+        }
+    };
+    for (auto& rewriter : NodeRewriters()) {
+        rewriters.push_back(std::move(rewriter));
+    }
+    return rewriters;
+}
+
+ClassId EGraph::Add(const IExpr& expr) {
+    std::vector<ClassId> children;
+    switch (expr.Kind()) {
+    case IExpr::EKind::Number:
+    case IExpr::EKind::Symbol:
+    case IExpr::EKind::Matrix:
+        return Add(LeafNode(expr));
+
+    case IExpr::EKind::Sum: {
+        const auto sum = expr.As<Sum>();
+        if (sum->GetConstant() != 0 || sum->GetTerms().empty()) {
+            children.emplace_back(Add(Number{sum->GetConstant()}));
+        }
+        for (const auto& term : sum->GetTerms()) {
+            children.emplace_back(Add(*term.Expression));
+        }
+        break;
+    }
+
+    case IExpr::EKind::Product: {
+        const auto product = expr.As<Product>();
+        if (product->GetCoefficient() != 1 || (product->GetConstants().empty() && product->GetVariables().empty())) {
+            children.emplace_back(Add(Number{product->GetCoefficient()}));
+        }
+        for (const auto* part : {&product->GetConstants(), &product->GetVariables()}) {
+            for (const auto& mul : *part) {
+                children.emplace_back(Add(*mul.Expression));
+            }
+        }
+        break;
+    }
+
+    case IExpr::EKind::Power: {
+        const auto power = expr.As<Power>();
+        children = {Add(power->GetBase()), Add(power->GetExp())};
+        break;
+    }
+
+    case IExpr::EKind::Log:
+        return Add(ENode{expr.Kind(), nullptr, {Add(expr.As<Log>()->GetArgument())}});
+    }
+
+    if (children.size() == 1) {
+        return children.front();
+    }
+    return Add(ENode{expr.Kind(), nullptr, std::move(children)});
+}
+
+ClassId EGraph::Add(ENode node) {
+    node = Canonicalize(std::move(node));
+    if (auto it = m_hashcons.find(node); it != m_hashcons.end()) {
+        return Find(it->second);
+    }
+
+    const auto id = static_cast<ClassId>(m_classes.size());
+    m_parents.emplace_back(id);
+    m_classes.emplace_back().emplace_back(node);
+    m_hashcons.emplace(std::move(node), id);
+    ++m_nodes;
+    return id;
+}
+
+ClassId EGraph::Find(ClassId id) const {
+    while (m_parents[id] != id) {
+        m_parents[id] = m_parents[m_parents[id]];
+        id = m_parents[id];
+    }
+    return id;
+}
+
+bool EGraph::Merge(ClassId lhs, ClassId rhs) {
+    lhs = Find(lhs);
+    rhs = Find(rhs);
+    if (lhs == rhs) {
+        return false;
+    }
+    if (m_classes[lhs].size() < m_classes[rhs].size()) {
+        std::swap(lhs, rhs);
+    }
+    m_parents[rhs] = lhs;
+    auto& nodes = m_classes[lhs];
+    nodes.insert(nodes.end(), std::make_move_iterator(m_classes[rhs].begin()), std::make_move_iterator(m_classes[rhs].end()));
+    m_classes[rhs].clear();
+    return true;
+}
+
+void EGraph::Rebuild() {
+    for (bool changed = true; changed;) {
+        changed = false;
+        m_hashcons.clear();
+        m_nodes = 0;
+        // Merging changes the node lists being walked, so it waits for the end of the pass
+        std::vector<std::pair<ClassId, ClassId>> pending;
+        for (ClassId id = 0; id < m_classes.size(); ++id) {
+            if (Find(id) != id) {
+                continue;
+            }
+            auto& nodes = m_classes[id];
+            std::vector<ENode> unique;
+            unique.reserve(nodes.size());
+            for (auto& node : nodes) {
+                node = Canonicalize(std::move(node));
+                const auto [it, inserted] = m_hashcons.try_emplace(node, id);
+                if (inserted) {
+                    unique.emplace_back(std::move(node));
+                } else if (it->second != id) {
+                    // the node is kept in the other class, which this one is merged into
+                    pending.emplace_back(it->second, id);
+                }
+            }
+            nodes = std::move(unique);
+            m_nodes += nodes.size();
+        }
+        for (const auto& [lhs, rhs] : pending) {
+            changed |= Merge(lhs, rhs);
+        }
+    }
+}
+
+size_t EGraph::Classes() const noexcept {
+    return m_classes.size() - std::ranges::count_if(m_classes, [](const auto& nodes) { return nodes.empty(); });
+}
+
+size_t EGraph::Nodes() const noexcept {
+    return m_nodes;
+}
+
+ENode EGraph::Canonicalize(ENode node) const {
+    for (auto& child : node.Children) {
+        child = Find(child);
+    }
+    if (IsCommutative(node.Kind)) {
+        std::ranges::sort(node.Children);
+    }
+    return node;
+}
+
+EGraph::CostTable EGraph::ComputeCosts(const CostModel& cost) const {
+    CostTable table(m_classes.size());
+    std::vector<size_t> children;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (ClassId id = 0; id < m_classes.size(); ++id) {
+            for (const auto& node : m_classes[id]) {
+                children.clear();
+                bool known = true;
+                for (const auto child : node.Children) {
+                    const auto& choice = table[Find(child)];
+                    if (!choice) {
+                        known = false;
+                        break;
+                    }
+                    children.emplace_back(choice->Cost);
+                }
+                if (!known) {
+                    continue;
+                }
+                const auto nodeCost = cost.Cost(node, children);
+                if (!table[id] || nodeCost < table[id]->Cost) {
+                    table[id] = Choice{nodeCost, Canonicalize(node)};
+                    changed = true;
+                }
+            }
+        }
+    }
+    return table;
+}
+
+std::unique_ptr<IExpr> EGraph::Extract(const ClassId id, const CostTable& table) const {
+    const auto& node = table[id]->Node;
+    if (node.Leaf) {
+        return node.Leaf->Copy();
+    }
+
+    std::vector<std::unique_ptr<IExpr>> children;
+    children.reserve(node.Children.size());
+    for (const auto child : node.Children) {
+        children.emplace_back(Extract(child, table));
+    }
+
+    switch (node.Kind) {
+    case IExpr::EKind::Sum:
+        return math::add(std::move(children));
+    case IExpr::EKind::Product:
+        return math::multiply(std::move(children));
+    case IExpr::EKind::Log:
+        return math::log(std::move(children[0]));
+    default:
+        return math::exp(std::move(children[0]), std::move(children[1]));
+    }
+}
+
+std::unique_ptr<IExpr> Saturate(const IExpr& expr, const Options& options) {
+    static const NodeCount defaultCost;
+    const auto& cost = options.Cost ? *options.Cost : defaultCost;
+    const auto deadline = std::chrono::steady_clock::now() + options.TimeLimit;
+    const auto withinLimits = [&](const EGraph& graph) {
+        return graph.Nodes() < options.MaxNodes && std::chrono::steady_clock::now() < deadline;
+    };
+
+    EGraph graph;
+    const auto root = graph.Add(expr);
+    std::unordered_set<hash::Fingerprint, hash::FingerprintHash> rewritten;
+
+    for (size_t iteration = 0; iteration < options.MaxIterations && withinLimits(graph); ++iteration) {
+        const auto table = graph.ComputeCosts(cost);
+        const auto classes = static_cast<ClassId>(table.size());
+        bool changed = false;
+
+        for (ClassId id = 0; id < classes && withinLimits(graph); ++id) {
+            if (!table[id] || table[id]->Node.Leaf) {
+                continue;
+            }
+            const auto term = graph.Extract(id, table);
+            if (!rewritten.insert(term->Fingerprint()).second) {
+                continue;
+            }
+            for (const auto& rewriter : options.Rewriters) {
+                try {
+                    if (auto res = rewriter(*term)) {
+                        changed |= graph.Merge(id, graph.Add(*res));
+                    }
+                } catch (const exception::CalcException&) {
+                    // the rewrite is not applicable to this form
+                }
+            }
+        }
+
+        graph.Rebuild();
+        if (!changed) {
+            break;
+        }
+    }
+
+    return graph.Extract(graph.Find(root), graph.ComputeCosts(cost));
+}
+
+}
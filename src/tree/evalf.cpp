@@ -0,0 +1,457 @@
+#include <tree/evalf.hpp>
+#include <tree/hash_utils.hpp>
+#include <tree/traverse.hpp>
+#include <boost/multiprecision/cpp_bin_float.hpp>
+#include <array>
+#include <expected>
+#include <limits>
+#include <utility>
+#include <variant>
+
+namespace ezmath::tree {
+
+namespace {
+
+namespace mp = boost::multiprecision;
+
+// Bits of the mantissa at each level of refinement
+constexpr std::array<unsigned, 4> PRECISIONS{128, 512, 2048, 8192};
+constexpr size_t LEVELS = PRECISIONS.size();
+
+template<size_t Level>
+using Float = mp::number<mp::cpp_bin_float<PRECISIONS[Level], mp::digit_base_2>, mp::et_off>;
+
+// Units in the last place a bound moves outwards: arithmetic is off by half of one per rounding,
+// exp and log of the float library by a few
+constexpr int ARITHMETIC_ULPS = 4;
+constexpr int FUNCTION_ULPS = 64;
+
+// Larger integer exponents are raised through exp and log
+constexpr uint64_t MAX_SQUARING_EXPONENT = std::numeric_limits<uint32_t>::max();
+
+template<size_t Level>
+struct Interval {
+    Float<Level> Lower;
+    Float<Level> Upper;
+
+    bool IsZero() const { return Lower == 0 && Upper == 0; }
+    bool IsPoint() const { return Lower == Upper; }
+};
+
+enum class EFailure : uint8_t {
+    // Too wide at this precision, e.g. a divisor whose enclosure contains 0
+    Uncertain,
+    // Not a real number, or not a number at all
+    Undefined
+};
+
+template<size_t Level>
+using Enclosure = std::expected<Interval<Level>, EFailure>;
+
+constexpr std::unexpected<EFailure> UNCERTAIN{EFailure::Uncertain};
+constexpr std::unexpected<EFailure> UNDEFINED{EFailure::Undefined};
+
+template<size_t Level>
+Float<Level> Ulps(const Float<Level>& value, const int ulps) {
+    return abs(value) * ldexp(Float<Level>{1}, ulps - static_cast<int>(PRECISIONS[Level]));
+}
+
+// Enclosure of values computed with rounding to nearest. Overflows are uncertain: no precision
+// of the mantissa fixes them, but the caller gives up after the last level all the same.
+template<size_t Level>
+Enclosure<Level> Widen(const Float<Level>& lower, const Float<Level>& upper, const int ulps) {
+    if (!isfinite(lower) || !isfinite(upper)) {
+        return UNCERTAIN;
+    }
+    Interval<Level> res{lower, upper};
+    // Zeros are exact, and cpp_bin_float would turn 0 - 0 into -0
+    if (lower != 0) {
+        res.Lower -= Ulps<Level>(lower, ulps);
+    }
+    if (upper != 0) {
+        res.Upper += Ulps<Level>(upper, ulps);
+    }
+    return res;
+}
+
+// Function values are widened absolutely too: log(1 + x) may be off by more than its own ulps,
+// and exp may underflow to 0
+template<size_t Level>
+Enclosure<Level> WidenFunction(const Float<Level>& lower, const Float<Level>& upper) {
+    const auto tiny = std::numeric_limits<Float<Level>>::min();
+    auto res = Widen<Level>(lower, upper, FUNCTION_ULPS);
+    if (res) {
+        res->Lower -= tiny;
+        res->Upper += tiny;
+    }
+    return res;
+}
+
+// Failure of an operation with a failed operand; undefined wins, since no precision fixes it
+template<size_t Level>
+std::unexpected<EFailure> Failure(const Enclosure<Level>& lhs, const Enclosure<Level>& rhs) {
+    const bool undefined = (!lhs && lhs.error() == EFailure::Undefined) || (!rhs && rhs.error() == EFailure::Undefined);
+    return undefined ? UNDEFINED : UNCERTAIN;
+}
+
+template<size_t Level, class Op>
+Enclosure<Level> Apply(const Enclosure<Level>& lhs, const Enclosure<Level>& rhs, Op&& op) {
+    if (lhs && rhs) {
+        return op(*lhs, *rhs);
+    }
+    return Failure(lhs, rhs);
+}
+
+// Applies op to an enclosure, or passes its failure on
+template<size_t Level, class Op>
+Enclosure<Level> Then(const Enclosure<Level>& value, Op&& op) {
+    return value ? op(*value) : value;
+}
+
+// Integers that fit the mantissa, and sums and products of points that are exact, stay points:
+// integer exponents are then known, and 1-1 is exactly 0
+template<size_t Level>
+Enclosure<Level> FromNumber(const BigNum& value) {
+    const auto [num, den] = value.Decompose();
+    const auto res = den == 1 ? Float<Level>{num} : Float<Level>{num} / Float<Level>{den};
+    if (den == 1 && res.template convert_to<BigNum::Integer>() == num) {
+        return Interval<Level>{res, res};
+    }
+    return Widen<Level>(res, res, ARITHMETIC_ULPS);
+}
+
+template<size_t Level>
+Enclosure<Level> Add(const Interval<Level>& lhs, const Interval<Level>& rhs) {
+    if (lhs.IsPoint() && rhs.IsPoint()) {
+        // The rounding error of the sum, computed exactly (TwoSum)
+        const auto sum = lhs.Lower + rhs.Lower;
+        const auto rhsPart = sum - lhs.Lower;
+        if (isfinite(sum) && (lhs.Lower - (sum - rhsPart)) + (rhs.Lower - rhsPart) == 0) {
+            return Interval<Level>{sum, sum};
+        }
+    }
+    return Widen<Level>(lhs.Lower + rhs.Lower, lhs.Upper + rhs.Upper, ARITHMETIC_ULPS);
+}
+
+template<size_t Level>
+Enclosure<Level> Multiply(const Interval<Level>& lhs, const Interval<Level>& rhs) {
+    if (lhs.IsPoint() && rhs.IsPoint()) {
+        // Twice the bits hold the product exactly
+        using Wide = mp::number<mp::cpp_bin_float<2 * PRECISIONS[Level], mp::digit_base_2>, mp::et_off>;
+        const auto product = lhs.Lower * rhs.Lower;
+        if (isfinite(product) && Wide{product} == Wide{lhs.Lower} * Wide{rhs.Lower}) {
+            return Interval<Level>{product, product};
+        }
+    }
+    const std::array products{lhs.Lower * rhs.Lower, lhs.Lower * rhs.Upper, lhs.Upper * rhs.Lower, lhs.Upper * rhs.Upper};
+    const auto [lower, upper] = std::ranges::minmax(products);
+    return Widen<Level>(lower, upper, ARITHMETIC_ULPS);
+}
+
+template<size_t Level>
+Interval<Level> Negate(const Interval<Level>& value) {
+    return {-value.Upper, -value.Lower};
+}
+
+template<size_t Level>
+Enclosure<Level> Inverse(const Interval<Level>& value) {
+    if (value.IsZero()) {
+        return UNDEFINED;
+    }
+    if (value.Lower <= 0 && value.Upper >= 0) {
+        return UNCERTAIN;
+    }
+    return Widen<Level>(1 / value.Upper, 1 / value.Lower, ARITHMETIC_ULPS);
+}
+
+template<size_t Level>
+Enclosure<Level> Exponential(const Interval<Level>& value) {
+    auto res = WidenFunction<Level>(exp(value.Lower), exp(value.Upper));
+    if (res && res->Lower < 0) {
+        res->Lower = 0;
+    }
+    return res;
+}
+
+template<size_t Level>
+Enclosure<Level> Logarithm(const Interval<Level>& value) {
+    if (value.Upper <= 0) {
+        return UNDEFINED;
+    }
+    if (value.Lower <= 0) {
+        return UNCERTAIN;
+    }
+    return WidenFunction<Level>(log(value.Lower), log(value.Upper));
+}
+
+// x^n of an exact x >= 0 by repeated squaring
+template<size_t Level>
+Enclosure<Level> PowPoint(const Float<Level>& value, uint64_t exp) {
+    Enclosure<Level> res = Interval<Level>{1, 1};
+    Enclosure<Level> square = Interval<Level>{value, value};
+    while (exp) {
+        if (exp & 1) {
+            res = Apply(res, square, Multiply<Level>);
+        }
+        exp >>= 1;
+        if (exp) {
+            square = Apply(square, square, Multiply<Level>);
+        }
+    }
+    return res;
+}
+
+template<size_t Level>
+Enclosure<Level> Pow(const Interval<Level>& value, const uint64_t exp) {
+    if (exp == 0) {
+        return Interval<Level>{1, 1};
+    }
+    const auto lower = PowPoint<Level>(abs(value.Lower), exp);
+    const auto upper = PowPoint<Level>(abs(value.Upper), exp);
+    if (!lower || !upper) {
+        return UNCERTAIN;
+    }
+    if (value.Lower >= 0) {
+        return Interval<Level>{lower->Lower, upper->Upper};
+    }
+    if (exp % 2) {
+        return Interval<Level>{-lower->Upper, value.Upper >= 0 ? upper->Upper : -upper->Lower};
+    }
+    if (value.Upper <= 0) {
+        return Interval<Level>{upper->Lower, lower->Upper};
+    }
+    return Interval<Level>{0, std::max(lower->Upper, upper->Upper)};
+}
+
+// base^exp = e^{exp \ln base} for base > 0
+template<size_t Level>
+Enclosure<Level> PowPositive(const Interval<Level>& base, const Enclosure<Level>& exp) {
+    return Then(Apply(exp, Logarithm(base), Multiply<Level>), Exponential<Level>);
+}
+
+// Integer powers of any base and odd roots of negative ones are real; other powers need a
+// positive base, or a zero one and a positive exponent
+template<size_t Level>
+Enclosure<Level> RaisePower(const Enclosure<Level>& base, const IExpr& expNode, const Enclosure<Level>& exp) {
+    if (!base) {
+        return base;
+    }
+    if (expNode.Is<Number>()) {
+        const auto& value = expNode.As<Number>()->Value();
+        const auto [num, den] = value.Decompose();
+        if (den == 1 && abs(num) <= MAX_SQUARING_EXPONENT) {
+            const auto res = Pow(*base, static_cast<uint64_t>(abs(num)));
+            return num < 0 ? Then(res, Inverse<Level>) : res;
+        }
+        if (base->Upper < 0 && den % 2 != 0) {
+            const auto res = PowPositive(Negate(*base), exp);
+            return res && num % 2 != 0 ? Negate(*res) : res;
+        }
+    } else if (exp && exp->IsPoint() && trunc(exp->Lower) == exp->Lower && abs(exp->Lower) <= MAX_SQUARING_EXPONENT) {
+        // An exponent that is not simplified to a number, such as 1+2, may still be an exact integer
+        const auto res = Pow(*base, abs(exp->Lower).template convert_to<uint64_t>());
+        return exp->Lower < 0 ? Then(res, Inverse<Level>) : res;
+    }
+    if (!exp) {
+        return exp;
+    }
+    if (base->Lower > 0) {
+        return PowPositive(*base, exp);
+    }
+    if (base->IsZero()) {
+        if (exp->Lower > 0) {
+            return Interval<Level>{0, 0};
+        }
+        return exp->Upper <= 0 ? UNDEFINED : UNCERTAIN;
+    }
+    return base->Upper < 0 ? UNDEFINED : UNCERTAIN;
+}
+
+template<size_t Level, size_t From>
+Enclosure<Level> Narrow(const Interval<From>& value) {
+    if constexpr (Level == From) {
+        return value;
+    } else {
+        return Widen<Level>(Float<Level>{value.Lower}, Float<Level>{value.Upper}, ARITHMETIC_ULPS);
+    }
+}
+
+// Most precise enclosure computed for a subtree, or monostate if its value is undefined
+template<class Levels>
+struct ApproximationOf;
+
+template<size_t... Levels>
+struct ApproximationOf<std::index_sequence<Levels...>> {
+    using Type = std::variant<std::monostate, Interval<Levels>...>;
+};
+
+using Approximation = ApproximationOf<std::make_index_sequence<LEVELS>>::Type;
+
+// Raises the precision level by level until step returns a value or fails for good
+template<class R, size_t Level = 0, class Step>
+std::optional<R> Refine(Step&& step) {
+    const std::expected<R, EFailure> res = step(std::integral_constant<size_t, Level>{});
+    if (res) {
+        return *res;
+    }
+    if constexpr (Level + 1 < LEVELS) {
+        if (res.error() == EFailure::Uncertain) {
+            return Refine<R, Level + 1>(std::forward<Step>(step));
+        }
+    }
+    return std::nullopt;
+}
+
+}
+
+struct Evaluator::Cache {
+    hash::FingerprintIndex<Approximation> Values;
+
+    // Enclosure from the cache at this precision or better; nullopt if there is none yet
+    template<size_t Level>
+    std::optional<Enclosure<Level>> Find(const IExpr& expr) const {
+        const auto* value = Values.Find(expr);
+        if (!value || (value->index() != 0 && value->index() <= Level)) {
+            return std::nullopt;
+        }
+        return std::visit([]<class T>(const T& value) -> Enclosure<Level> {
+            if constexpr (std::is_same_v<T, std::monostate>) {
+                return UNDEFINED;
+            } else {
+                return Narrow<Level>(value);
+            }
+        }, *value);
+    }
+
+    // Children first, so every node is computed from the cached enclosures of its children.
+    // Uncertain enclosures are not cached, and their parents are uncertain in turn.
+    template<size_t Level>
+    Enclosure<Level> Evaluate(const IExpr& root) {
+        traverse::PostOrder(root,
+            [this](const IExpr& node) {
+                if (Find<Level>(node)) {
+                    return;
+                }
+                const auto res = Compute<Level>(node);
+                if (res || res.error() == EFailure::Undefined) {
+                    auto& value = Values.Insert(node, std::monostate{}).first;
+                    if (res) {
+                        value = *res;
+                    }
+                }
+            },
+            [this](const IExpr& node) { return node.IsConstant() && !Find<Level>(node); });
+        return Find<Level>(root).value_or(UNCERTAIN);
+    }
+
+    template<size_t Level>
+    Enclosure<Level> Compute(const IExpr& node) const {
+        if (!node.IsConstant()) {
+            return UNDEFINED;
+        }
+        const auto child = [this](const IExpr& expr) { return Find<Level>(expr).value_or(UNCERTAIN); };
+        return Match(node,
+            [](const Number& number) { return FromNumber<Level>(number.Value()); },
+            [&child](const Sum& sum) {
+                auto res = FromNumber<Level>(sum.GetConstant());
+                for (const auto& term : sum.GetTerms()) {
+                    res = Apply(res, child(*term.Expression), Add<Level>);
+                }
+                return res;
+            },
+            [&child](const Product& product) {
+                auto res = FromNumber<Level>(product.GetCoefficient());
+                traverse::ForEachChild(product, [&](const IExpr& factor) {
+                    res = Apply(res, child(factor), Multiply<Level>);
+                });
+                return res;
+            },
+            [&child](const Power& power) {
+                return RaisePower(child(power.GetBase()), power.GetExp(), child(power.GetExp()));
+            },
+            [&child](const Log& log) {
+                return Then(child(log.GetArgument()), Logarithm<Level>);
+            },
+            [](const auto&) -> Enclosure<Level> { return UNDEFINED; });
+    }
+};
+
+Evaluator::Evaluator()
+    : m_cache{std::make_unique<Cache>()}
+{}
+
+Evaluator::~Evaluator() = default;
+
+std::optional<int> Evaluator::Sign(const IExpr& expr) {
+    return Refine<int>([this, &expr]<size_t Level>(std::integral_constant<size_t, Level>) -> std::expected<int, EFailure> {
+        const auto value = m_cache->Evaluate<Level>(expr);
+        if (!value) {
+            return std::unexpected{value.error()};
+        }
+        if (value->Lower > 0) {
+            return 1;
+        }
+        if (value->Upper < 0) {
+            return -1;
+        }
+        return value->IsZero() ? std::expected<int, EFailure>{0} : UNCERTAIN;
+    });
+}
+
+std::optional<std::strong_ordering> Evaluator::Compare(const IExpr& lhs, const IExpr& rhs) {
+    if (lhs.IsEqualTo(rhs) && Sign(lhs)) {
+        return std::strong_ordering::equal;
+    }
+    using Result = std::expected<std::strong_ordering, EFailure>;
+    return Refine<std::strong_ordering>([this, &lhs, &rhs]<size_t Level>(std::integral_constant<size_t, Level>) -> Result {
+        const auto left = m_cache->Evaluate<Level>(lhs);
+        const auto right = m_cache->Evaluate<Level>(rhs);
+        if (!left || !right) {
+            return Failure(left, right);
+        }
+        if (left->Upper < right->Lower) {
+            return std::strong_ordering::less;
+        }
+        if (left->Lower > right->Upper) {
+            return std::strong_ordering::greater;
+        }
+        if (left->Lower == left->Upper && right->Lower == right->Upper && left->Lower == right->Lower) {
+            return std::strong_ordering::equal;
+        }
+        return UNCERTAIN;
+    });
+}
+
+std::optional<std::string> Evaluator::Evalf(const IExpr& expr, size_t digits) {
+    digits = std::max<size_t>(digits, 1);
+    return Refine<std::string>([this, &expr, digits]<size_t Level>(std::integral_constant<size_t, Level>) -> std::expected<std::string, EFailure> {
+        const auto value = m_cache->Evaluate<Level>(expr);
+        if (!value) {
+            return std::unexpected{value.error()};
+        }
+        // Rounding is monotone, so the values between bounds of equal digits have them too
+        auto lower = value->Lower.str(static_cast<std::streamsize>(digits), std::ios_base::fmtflags{});
+        if (lower != value->Upper.str(static_cast<std::streamsize>(digits), std::ios_base::fmtflags{})) {
+            return UNCERTAIN;
+        }
+        return lower;
+    });
+}
+
+void Evaluator::Clear() noexcept {
+    m_cache->Values.Clear();
+}
+
+std::optional<int> NumericSign(const IExpr& expr) {
+    return Evaluator{}.Sign(expr);
+}
+
+std::optional<std::strong_ordering> NumericCompare(const IExpr& lhs, const IExpr& rhs) {
+    return Evaluator{}.Compare(lhs, rhs);
+}
+
+std::optional<std::string> Evalf(const IExpr& expr, const size_t digits) {
+    return Evaluator{}.Evalf(expr, digits);
+}
+
+}
@@ -0,0 +1,195 @@
+#include <tree/traverse.hpp>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ezmath::tree {
+
+namespace {
+
+// Results computed by an unwinding walk for the children of the node being visited; each parent
+// takes the results of its children out of the table
+template<class T>
+using Pending = std::unordered_map<const IExpr*, T>;
+
+thread_local Pending<std::unique_ptr<IExpr>>* pendingCopies = nullptr;
+thread_local Pending<std::string>* pendingStrings = nullptr;
+
+thread_local size_t releaseDepth = 0;
+thread_local std::vector<std::unique_ptr<IExpr>> releaseQueue;
+
+template<class T>
+std::optional<T> TakePending(Pending<T>* pending, const IExpr* node) {
+    if (!pending) {
+        return std::nullopt;
+    }
+    const auto it = pending->find(node);
+    if (it == pending->end()) {
+        return std::nullopt;
+    }
+    auto res = std::move(it->second);
+    pending->erase(it);
+    return res;
+}
+
+// Installs a table of pending results and a fresh recursion budget for the nodes of a walk
+template<class T>
+class Unwinding {
+public:
+    Unwinding(Pending<T>*& slot, size_t& depth) noexcept
+        : m_slot{slot}
+        , m_previous{std::exchange(slot, &m_pending)}
+        , m_depth{depth}
+        , m_previousDepth{std::exchange(depth, 0)}
+    {}
+
+    ~Unwinding() {
+        m_slot = m_previous;
+        m_depth = m_previousDepth;
+    }
+
+    Unwinding(const Unwinding&) = delete;
+    Unwinding& operator=(const Unwinding&) = delete;
+
+    Pending<T>& Results() noexcept { return m_pending; }
+
+private:
+    Pending<T> m_pending;
+    Pending<T>*& m_slot;
+    Pending<T>* m_previous;
+    size_t& m_depth;
+    size_t m_previousDepth;
+};
+
+}
+
+void BaseExpression::UnwindSubtree(const ECached cache) const {
+    const auto isReady = [cache](const BaseExpression& node) {
+        switch (cache) {
+        case ECached::Hash:
+            return node.m_bufferedHash.load(std::memory_order_relaxed) != 0;
+        case ECached::Fingerprint:
+            return node.m_fingerprintState.load(std::memory_order_acquire) == ECache::Ready;
+        case ECached::Metadata:
+            return node.m_metadataState.load(std::memory_order_acquire) == ECache::Ready;
+        }
+        std::unreachable();
+    };
+    const auto fill = [cache](const IExpr& node) {
+        switch (cache) {
+        case ECached::Hash:
+            node.Hash();
+            break;
+        case ECached::Fingerprint:
+            node.Fingerprint();
+            break;
+        case ECached::Metadata:
+            node.Meta();
+            break;
+        }
+    };
+
+    const auto depth = std::exchange(recursionDepth, 0);
+    traverse::PostOrder(*this,
+        [this, &fill](const IExpr& node) {
+            if (&node != this) {
+                fill(node);
+            }
+        },
+        [this, &isReady](const IExpr& node) {
+            return &node == this || !isReady(*node.As<BaseExpression>());
+        });
+    recursionDepth = depth;
+}
+
+bool BaseExpression::IsEqualTo(const IExpr& other) const {
+    if (recursionDepth >= MAX_RECURSION_DEPTH) {
+        return Hash() == other.Hash() && Fingerprint() == other.Fingerprint();
+    }
+    const Nesting nesting;
+    return IsEqualToImpl(other);
+}
+
+std::unique_ptr<IExpr> BaseExpression::CopyNode() const {
+    auto res = CopyImpl();
+    auto* copy = res->As<BaseExpression>();
+    copy->m_bufferedHash.store(m_bufferedHash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    if (m_fingerprintState.load(std::memory_order_acquire) == ECache::Ready) {
+        copy->m_bufferedFingerprint = m_bufferedFingerprint;
+        copy->m_fingerprintState.store(ECache::Ready, std::memory_order_relaxed);
+    }
+    if (m_metadataState.load(std::memory_order_acquire) == ECache::Ready) {
+        copy->m_bufferedMetadata = m_bufferedMetadata;
+        copy->m_metadataState.store(ECache::Ready, std::memory_order_relaxed);
+    }
+    return res;
+}
+
+std::unique_ptr<IExpr> BaseExpression::UnwindCopy() const {
+    Unwinding<std::unique_ptr<IExpr>> unwinding{pendingCopies, recursionDepth};
+    auto& copies = unwinding.Results();
+    traverse::PostOrder(*this, [this, &copies](const IExpr& node) {
+        if (&node != this) {
+            copies.emplace(&node, node.As<BaseExpression>()->CopyNode());
+        }
+    });
+    return CopyNode();
+}
+
+std::unique_ptr<IExpr> BaseExpression::Copy() const {
+    if (auto res = TakePending(pendingCopies, this)) {
+        return std::move(*res);
+    }
+    if (recursionDepth >= MAX_RECURSION_DEPTH) {
+        return UnwindCopy();
+    }
+    const Nesting nesting;
+    return CopyNode();
+}
+
+std::string BaseExpression::UnwindToString() const {
+    Unwinding<std::string> unwinding{pendingStrings, recursionDepth};
+    auto& strings = unwinding.Results();
+    traverse::PostOrder(*this, [this, &strings](const IExpr& node) {
+        if (&node != this) {
+            strings.emplace(&node, node.As<BaseExpression>()->ToStringImpl());
+        }
+    });
+    return ToStringImpl();
+}
+
+std::string BaseExpression::ToString() const {
+    if (auto res = TakePending(pendingStrings, this)) {
+        return std::move(*res);
+    }
+    if (recursionDepth >= MAX_RECURSION_DEPTH) {
+        return UnwindToString();
+    }
+    const Nesting nesting;
+    return ToStringImpl();
+}
+
+void BaseExpression::Release(std::unique_ptr<IExpr>&& child) noexcept {
+    if (!child) {
+        return;
+    }
+    if (releaseDepth >= MAX_RECURSION_DEPTH) {
+        releaseQueue.push_back(std::move(child));
+        return;
+    }
+    ++releaseDepth;
+    child.reset();
+    --releaseDepth;
+    if (releaseDepth == 0) {
+        while (!releaseQueue.empty()) {
+            auto next = std::move(releaseQueue.back());
+            releaseQueue.pop_back();
+            ++releaseDepth;
+            next.reset();
+            --releaseDepth;
+        }
+    }
+}
+
+}
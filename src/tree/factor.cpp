@@ -0,0 +1,483 @@
+#include <tree/factor.hpp>
+#include <tree/dense_polynomial.hpp>
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+namespace ezmath::tree {
+
+namespace {
+
+using Integer = BigNum::Integer;
+// Integer polynomial, lowest degree first
+using IntPoly = std::vector<Integer>;
+
+// Polynomials modulo a prime below 2^31, lowest degree first and without trailing zeros.
+// Products of two residues fit in 64 bits, so all arithmetic stays in machine words.
+using Word = uint64_t;
+using ModPoly = std::vector<Word>;
+
+class Field {
+public:
+    explicit Field(const Word prime)
+        : m_prime{prime}
+    {}
+
+    Word Prime() const noexcept { return m_prime; }
+
+    Word Reduce(const Integer& value) const {
+        Integer res = value % m_prime;
+        return res < 0 ? (res + m_prime).convert_to<Word>() : res.convert_to<Word>();
+    }
+
+    ModPoly Reduce(const std::span<const Integer> poly) const {
+        ModPoly res;
+        res.reserve(poly.size());
+        for (const auto& coef : poly) {
+            res.push_back(Reduce(coef));
+        }
+        return Trim(std::move(res));
+    }
+
+    Word Inverse(const Word value) const { return Pow(value, m_prime - 2); }
+
+    Word Pow(Word base, Word exp) const {
+        Word res = 1;
+        for (; exp; exp >>= 1) {
+            if (exp & 1) {
+                res = res * base % m_prime;
+            }
+            base = base * base % m_prime;
+        }
+        return res;
+    }
+
+    static ModPoly Trim(ModPoly poly) {
+        while (!poly.empty() && poly.back() == 0) {
+            poly.pop_back();
+        }
+        return poly;
+    }
+
+    ModPoly Subtract(ModPoly lhs, const ModPoly& rhs) const {
+        lhs.resize(std::max(lhs.size(), rhs.size()));
+        for (size_t i = 0; i < rhs.size(); ++i) {
+            lhs[i] = (lhs[i] + m_prime - rhs[i]) % m_prime;
+        }
+        return Trim(std::move(lhs));
+    }
+
+    ModPoly Multiply(const ModPoly& lhs, const ModPoly& rhs) const {
+        if (lhs.empty() || rhs.empty()) {
+            return {};
+        }
+        ModPoly res(lhs.size() + rhs.size() - 1);
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            for (size_t j = 0; j < rhs.size(); ++j) {
+                res[i + j] = (res[i + j] + lhs[i] * rhs[j]) % m_prime;
+            }
+        }
+        return Trim(std::move(res));
+    }
+
+    ModPoly Scale(ModPoly poly, const Word factor) const {
+        for (auto& coef : poly) {
+            coef = coef * factor % m_prime;
+        }
+        return Trim(std::move(poly));
+    }
+
+    ModPoly Monic(ModPoly poly) const {
+        return poly.empty() ? poly : Scale(std::move(poly), Inverse(poly.back()));
+    }
+
+    // Quotient and remainder; divisor is not zero
+    std::pair<ModPoly, ModPoly> DivMod(ModPoly dividend, const ModPoly& divisor) const {
+        if (dividend.size() < divisor.size()) {
+            return {{}, std::move(dividend)};
+        }
+        const auto inverse = Inverse(divisor.back());
+        ModPoly quotient(dividend.size() - divisor.size() + 1);
+        for (size_t i = quotient.size(); i-- > 0;) {
+            const auto coef = dividend[i + divisor.size() - 1] * inverse % m_prime;
+            quotient[i] = coef;
+            for (size_t j = 0; j < divisor.size(); ++j) {
+                dividend[i + j] = (dividend[i + j] + m_prime - coef * divisor[j] % m_prime) % m_prime;
+            }
+        }
+        dividend.resize(divisor.size() - 1);
+        return {Trim(std::move(quotient)), Trim(std::move(dividend))};
+    }
+
+    ModPoly Remainder(ModPoly dividend, const ModPoly& divisor) const {
+        return DivMod(std::move(dividend), divisor).second;
+    }
+
+    ModPoly Gcd(ModPoly lhs, ModPoly rhs) const {
+        while (!rhs.empty()) {
+            lhs = Remainder(std::move(lhs), rhs);
+            std::swap(lhs, rhs);
+        }
+        return Monic(std::move(lhs));
+    }
+
+    // s with s * value = 1 modulo modulus, for coprime arguments
+    ModPoly InverseModulo(const ModPoly& value, const ModPoly& modulus) const {
+        ModPoly r0 = modulus, r1 = Remainder(value, modulus);
+        ModPoly s0, s1{1};
+        while (!r1.empty()) {
+            auto [quotient, remainder] = DivMod(r0, r1);
+            s0 = Subtract(std::move(s0), Multiply(quotient, s1));
+            r0 = std::exchange(r1, std::move(remainder));
+            std::swap(s0, s1);
+        }
+        // r0 is a nonzero constant
+        return Remainder(Scale(std::move(s0), Inverse(r0.front())), modulus);
+    }
+
+    ModPoly PowModulo(ModPoly base, Word exp, const ModPoly& modulus) const {
+        ModPoly res{1};
+        base = Remainder(std::move(base), modulus);
+        for (; exp; exp >>= 1) {
+            if (exp & 1) {
+                res = Remainder(Multiply(res, base), modulus);
+            }
+            base = Remainder(Multiply(base, base), modulus);
+        }
+        return res;
+    }
+
+    ModPoly Derivative(const ModPoly& poly) const {
+        ModPoly res;
+        for (size_t i = 1; i < poly.size(); ++i) {
+            res.push_back(i % m_prime * poly[i] % m_prime);
+        }
+        return Trim(std::move(res));
+    }
+
+private:
+    Word m_prime;
+};
+
+size_t Degree(const ModPoly& poly) {
+    return poly.size() - 1;
+}
+
+// Splits a monic square-free polynomial into products of the irreducible factors of equal degree
+std::vector<std::pair<ModPoly, size_t>> DistinctDegree(const Field& field, ModPoly poly) {
+    std::vector<std::pair<ModPoly, size_t>> res;
+    const ModPoly x{0, 1};
+    ModPoly power = x;
+    for (size_t degree = 1; 2 * degree <= Degree(poly); ++degree) {
+        // power = x^(p^degree) modulo poly
+        power = field.PowModulo(std::move(power), field.Prime(), poly);
+        auto common = field.Gcd(poly, field.Subtract(power, x));
+        if (Degree(common) > 0) {
+            poly = field.DivMod(std::move(poly), common).first;
+            power = field.Remainder(std::move(power), poly);
+            res.emplace_back(std::move(common), degree);
+        }
+    }
+    if (Degree(poly) > 0) {
+        const auto degree = Degree(poly);
+        res.emplace_back(std::move(poly), degree);
+    }
+    return res;
+}
+
+// Cantor-Zassenhaus: gcd(poly, a^((p^d-1)/2) - 1) for random a splits the factors of degree d
+void EqualDegree(const Field& field, const ModPoly& poly, const size_t degree, std::mt19937_64& random, std::vector<ModPoly>& res) {
+    if (Degree(poly) == degree) {
+        res.push_back(poly);
+        return;
+    }
+    while (true) {
+        ModPoly a(Degree(poly));
+        for (auto& coef : a) {
+            coef = random() % field.Prime();
+        }
+        a = Field::Trim(std::move(a));
+        if (a.empty()) {
+            continue;
+        }
+        // (p^d - 1) / 2 = (1 + p + ... + p^(d-1)) * (p - 1) / 2
+        auto power = a;
+        for (size_t i = 1; i < degree; ++i) {
+            power = field.Remainder(field.Multiply(field.PowModulo(std::move(power), field.Prime(), poly), a), poly);
+        }
+        power = field.PowModulo(std::move(power), (field.Prime() - 1) / 2, poly);
+        auto common = field.Gcd(poly, field.Subtract(std::move(power), ModPoly{1}));
+        if (Degree(common) > 0 && Degree(common) < Degree(poly)) {
+            auto quotient = field.DivMod(poly, common).first;
+            EqualDegree(field, common, degree, random, res);
+            EqualDegree(field, quotient, degree, random, res);
+            return;
+        }
+    }
+}
+
+// Monic irreducible factors modulo p of a polynomial which is square-free modulo p
+std::vector<ModPoly> FactorModulo(const Field& field, const ModPoly& poly) {
+    std::mt19937_64 random{field.Prime()};
+    std::vector<ModPoly> res;
+    for (auto& [product, degree] : DistinctDegree(field, field.Monic(poly))) {
+        EqualDegree(field, product, degree, random, res);
+    }
+    return res;
+}
+
+bool IsPrime(const Word n) {
+    for (Word d = 2; d * d <= n; ++d) {
+        if (n % d == 0) {
+            return false;
+        }
+    }
+    return n >= 2;
+}
+
+IntPoly Multiply(const IntPoly& lhs, const IntPoly& rhs) {
+    return DensePolynomial::Multiply(lhs, rhs);
+}
+
+// Symmetric representative of value modulo modulus
+Integer Symmetric(Integer value, const Integer& modulus) {
+    value %= modulus;
+    if (value < 0) {
+        value += modulus;
+    }
+    return 2 * value > modulus ? Integer{value - modulus} : value;
+}
+
+IntPoly PrimitivePart(IntPoly poly) {
+    Integer content = 0;
+    for (const auto& coef : poly) {
+        content = boost::multiprecision::gcd(content, coef);
+    }
+    if (poly.back() < 0) {
+        content = -content;
+    }
+    for (auto& coef : poly) {
+        coef /= content;
+    }
+    return poly;
+}
+
+// Quotient over the integers, nullopt if divisor does not divide dividend
+std::optional<IntPoly> DivideExact(IntPoly dividend, const IntPoly& divisor) {
+    if (dividend.size() < divisor.size()) {
+        return std::nullopt;
+    }
+    IntPoly quotient(dividend.size() - divisor.size() + 1);
+    for (size_t i = quotient.size(); i-- > 0;) {
+        auto& lead = dividend[i + divisor.size() - 1];
+        if (lead % divisor.back() != 0) {
+            return std::nullopt;
+        }
+        quotient[i] = lead / divisor.back();
+        for (size_t j = 0; j < divisor.size(); ++j) {
+            dividend[i + j] -= quotient[i] * divisor[j];
+        }
+    }
+    if (std::ranges::any_of(dividend, [](const auto& coef) { return coef != 0; })) {
+        return std::nullopt;
+    }
+    return quotient;
+}
+
+// Mignotte: coefficients of lc(poly) / lc(h) * h for a factor h are below lc * 2^n * ||poly||_2
+Integer FactorBound(const IntPoly& poly) {
+    Integer norm = 0;
+    for (const auto& coef : poly) {
+        norm += coef * coef;
+    }
+    Integer res = boost::multiprecision::abs(poly.back()) * (boost::multiprecision::sqrt(norm) + 1);
+    return res << (poly.size() - 1);
+}
+
+// Multifactor linear Hensel lifting of poly = lc * prod factors (mod p) to modulus p^k > bound.
+// Corrections come from a partial fraction decomposition 1 = sum a_i * prod_{j!=i} f_j modulo p,
+// so every step needs one product over the integers and word arithmetic otherwise.
+std::vector<IntPoly> HenselLift(const Field& field, const IntPoly& poly, const std::vector<ModPoly>& factors,
+                                const Integer& bound, Integer& modulus) {
+    const auto& lc = poly.back();
+    std::vector<ModPoly> coefs;
+    coefs.reserve(factors.size());
+    for (size_t i = 0; i < factors.size(); ++i) {
+        ModPoly others{1};
+        for (size_t j = 0; j < factors.size(); ++j) {
+            if (j != i) {
+                others = field.Multiply(others, factors[j]);
+            }
+        }
+        coefs.push_back(field.InverseModulo(others, factors[i]));
+    }
+
+    std::vector<IntPoly> lifted;
+    for (const auto& factor : factors) {
+        lifted.emplace_back(factor.begin(), factor.end());
+    }
+    const auto lcInverse = field.Inverse(field.Reduce(lc));
+    modulus = field.Prime();
+    while (modulus <= bound) {
+        IntPoly product{lc};
+        for (const auto& factor : lifted) {
+            product = Multiply(product, factor);
+        }
+        IntPoly error(poly.size());
+        for (size_t i = 0; i < poly.size(); ++i) {
+            error[i] = (poly[i] - product[i]) / modulus;
+        }
+        const auto reduced = field.Scale(field.Reduce(error), lcInverse);
+        for (size_t i = 0; i < lifted.size(); ++i) {
+            const auto correction = field.Remainder(field.Multiply(reduced, coefs[i]), factors[i]);
+            for (size_t j = 0; j < correction.size(); ++j) {
+                lifted[i][j] += modulus * correction[j];
+            }
+        }
+        modulus *= field.Prime();
+    }
+    return lifted;
+}
+
+// Zassenhaus recombination: lc * product of a subset of the lifted factors, reduced symmetrically,
+// is a true factor up to content if it divides poly; subsets are tried by increasing size
+std::vector<IntPoly> Recombine(IntPoly poly, std::vector<IntPoly> lifted, const Integer& modulus) {
+    std::vector<IntPoly> res;
+    for (size_t size = 1; 2 * size <= lifted.size();) {
+        bool found = false;
+        std::vector<size_t> subset(size);
+        std::iota(subset.begin(), subset.end(), 0);
+        while (true) {
+            IntPoly candidate{poly.back()};
+            for (const auto i : subset) {
+                candidate = Multiply(candidate, lifted[i]);
+            }
+            for (auto& coef : candidate) {
+                coef = Symmetric(std::move(coef), modulus);
+            }
+            candidate = PrimitivePart(std::move(candidate));
+            // the constant term of a factor divides the constant term of poly
+            const bool plausible = poly.front() == 0 || (candidate.front() != 0 && poly.front() % candidate.front() == 0);
+            if (auto quotient = plausible ? DivideExact(poly, candidate) : std::nullopt) {
+                poly = std::move(*quotient);
+                res.push_back(std::move(candidate));
+                for (size_t k = subset.size(); k-- > 0;) {
+                    lifted.erase(lifted.begin() + subset[k]);
+                }
+                found = true;
+                break;
+            }
+
+            // next subset in lexicographic order
+            size_t k = size;
+            while (k > 0 && subset[k - 1] == lifted.size() - size + k - 1) {
+                --k;
+            }
+            if (k == 0) {
+                break;
+            }
+            ++subset[k - 1];
+            std::iota(subset.begin() + k, subset.end(), subset[k - 1] + 1);
+        }
+        if (!found) {
+            ++size;
+        }
+    }
+    res.push_back(PrimitivePart(std::move(poly)));
+    return res;
+}
+
+// Irreducible factors of a square-free primitive polynomial with a positive leading coefficient
+std::vector<IntPoly> FactorSquareFree(const IntPoly& poly) {
+    if (poly.size() <= 2) {
+        return {poly};
+    }
+
+    // A few primes which keep the polynomial square-free; the fewest modular factors win
+    constexpr size_t PRIME_TRIALS = 3;
+    constexpr Word FIRST_PRIME = 65537;
+    std::optional<Field> best;
+    std::vector<ModPoly> bestFactors;
+    size_t trials = 0;
+    for (Word p = FIRST_PRIME; trials < PRIME_TRIALS; p += 2) {
+        if (!IsPrime(p) || poly.back() % p == 0) {
+            continue;
+        }
+        const Field field{p};
+        const auto reduced = field.Reduce(poly);
+        if (Degree(field.Gcd(reduced, field.Derivative(reduced))) != 0) {
+            continue;
+        }
+        ++trials;
+        auto factors = FactorModulo(field, reduced);
+        if (!best || factors.size() < bestFactors.size()) {
+            best = field;
+            bestFactors = std::move(factors);
+        }
+    }
+    if (bestFactors.size() == 1) {
+        return {poly};
+    }
+
+    Integer modulus;
+    auto lifted = HenselLift(*best, poly, bestFactors, 2 * FactorBound(poly), modulus);
+    return Recombine(poly, std::move(lifted), modulus);
+}
+
+// Yun's algorithm: poly = prod parts[i]^(i+1) with square-free, pairwise coprime parts
+std::vector<Polynomial> SquareFree(const Polynomial& poly) {
+    const auto derivative = [](const Polynomial& value) {
+        const auto dense = *DensePolynomial::FromSparse(value);
+        std::vector<Integer> coefs;
+        for (size_t i = 1; i < dense.Integers().size(); ++i) {
+            coefs.emplace_back(dense.Integers()[i] * i);
+        }
+        return DensePolynomial{std::move(coefs), dense.Scale()}.ToSparse();
+    };
+
+    std::vector<Polynomial> res;
+    const auto common = Polynomial::Gcd(poly, derivative(poly));
+    auto w = *poly.DivideExact(common);
+    auto y = *derivative(poly).DivideExact(common);
+    auto z = y - derivative(w);
+    while (!w.IsConstant()) {
+        auto part = Polynomial::Gcd(w, z);
+        w = *w.DivideExact(part);
+        y = *z.DivideExact(part);
+        z = y - derivative(w);
+        res.push_back(std::move(part));
+    }
+    return res;
+}
+
+}
+
+std::optional<Factorization> Factor(const Polynomial& poly) {
+    if (poly.Variables() > 1) {
+        return std::nullopt;
+    }
+    Factorization res;
+    if (poly.IsZero() || poly.IsConstant()) {
+        res.Content = poly.IsZero() ? BigNum{0} : poly.LeadingCoefficient();
+        return res;
+    }
+
+    res.Content = poly.Content();
+    const auto parts = SquareFree(poly.PrimitivePart());
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (parts[i].IsConstant()) {
+            continue;
+        }
+        const auto dense = *DensePolynomial::FromSparse(parts[i]);
+        for (auto& factor : FactorSquareFree({dense.Integers().begin(), dense.Integers().end()})) {
+            res.Factors.emplace_back(DensePolynomial{std::move(factor)}.ToSparse(), static_cast<uint32_t>(i + 1));
+        }
+    }
+
+    std::ranges::stable_sort(res.Factors, [](const auto& lhs, const auto& rhs) {
+        return lhs.first.Degree(0) < rhs.first.Degree(0);
+    });
+    return res;
+}
+
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Coroutine API of the simplifier: simplification runs in quanta of rule applications
+// and yields to an executor between them, so that many of them interleave on few threads.
+
+namespace ezmath::tree {
+
+class Executor {
+public:
+    virtual ~Executor() = default;
+
+    // Resumes the coroutine later, on a thread of the executor
+    virtual void Post(std::coroutine_handle<> coroutine) = 0;
+};
+
+// Queue of coroutines drained by its owner, e.g. once per iteration of an event loop
+class QueueExecutor : public Executor {
+public:
+    void Post(std::coroutine_handle<> coroutine) override;
+
+    // Resumes the oldest posted coroutine, false if there was none
+    bool RunOne();
+    // Resumes the coroutines posted before the call, returns their number
+    size_t RunPending();
+
+private:
+    std::mutex m_mutex;
+    std::deque<std::coroutine_handle<>> m_queue;
+};
+
+class ThreadPoolExecutor : public Executor {
+public:
+    explicit ThreadPoolExecutor(size_t threads = std::thread::hardware_concurrency());
+    ~ThreadPoolExecutor() override;
+
+    void Post(std::coroutine_handle<> coroutine) override;
+
+private:
+    void Work();
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<std::coroutine_handle<>> m_queue;
+    bool m_stopped = false;
+    std::vector<std::jthread> m_threads;
+};
+
+// Awaiting it continues the coroutine on the executor
+struct Schedule {
+    Executor& Target;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> coroutine) const { Target.Post(coroutine); }
+    void await_resume() const noexcept {}
+};
+
+// Lazy coroutine: runs when awaited or started. It must outlive the coroutine it owns.
+template<class T>
+class Task {
+public:
+    struct promise_type {
+        std::optional<T> Value;
+        std::exception_ptr Error;
+        std::coroutine_handle<> Continuation;
+        std::atomic<bool> Ready = false;
+
+        Task get_return_object() { return Task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+
+        auto final_suspend() const noexcept {
+            struct Final {
+                bool await_ready() const noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> self) const noexcept {
+                    auto& promise = self.promise();
+                    // the awaiting side may destroy the task as soon as it is ready
+                    auto continuation = promise.Continuation;
+                    promise.Ready.store(true, std::memory_order_release);
+                    promise.Ready.notify_all();
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {}
+            };
+            return Final{};
+        }
+
+        void return_value(T value) { Value.emplace(std::move(value)); }
+        void unhandled_exception() noexcept { Error = std::current_exception(); }
+    };
+
+    Task(Task&& other) noexcept
+        : m_handle{std::exchange(other.m_handle, nullptr)}
+    {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        m_handle.promise().Continuation = awaiting;
+        return m_handle;
+    }
+
+    T await_resume() { return Result(); }
+
+    // Runs the coroutine on the calling thread until its first suspension
+    void Start() { m_handle.resume(); }
+
+    bool IsReady() const noexcept { return m_handle.promise().Ready.load(std::memory_order_acquire); }
+
+    // Blocks until the coroutine finishes on another thread
+    void Wait() const { m_handle.promise().Ready.wait(false, std::memory_order_acquire); }
+
+    // Result of the finished coroutine; rethrows its exception
+    T Result() {
+        auto& promise = m_handle.promise();
+        if (promise.Error) {
+            std::rethrow_exception(promise.Error);
+        }
+        return std::move(*promise.Value);
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+        : m_handle{handle}
+    {}
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+// Rule applications between two suspensions of SimplifyAsync
+constexpr size_t DEFAULT_SIMPLIFY_QUANTUM = 256;
+
+// Runs math::simplify for at most quantum rule applications, true if it has finished
+bool SimplifyStep(std::unique_ptr<IExpr>& val, size_t quantum);
+
+// Simplifies on the executor, yielding to it after every quantum of rule applications
+Task<std::unique_ptr<IExpr>> SimplifyAsync(std::unique_ptr<IExpr> val, Executor& executor,
+                                           size_t quantum = DEFAULT_SIMPLIFY_QUANTUM);
+
+}
@@ -1,17 +1,46 @@
 #pragma once
 
+#include <tree/bignum_backend.hpp>
+#include <tree/fingerprint.hpp>
 #include <tuple>
 #include <optional>
-#include <boost/multiprecision/cpp_int.hpp>
 
 namespace ezmath::tree {
 
+// How numbers with many digits are printed
+struct NumberFormat {
+    enum class EStyle : uint8_t {
+        Exact,
+        Scientific,    // leading digits and the power of ten, e.g. 1.2345\cdot10^{30102}
+        Truncated      // leading and trailing digits around \ldots
+    };
+
+    EStyle Style = EStyle::Exact;
+    // Integers with more digits are shortened; the shortened form keeps about this many digits
+    size_t MaxDigits = 64;
+};
+
+// Sets the format of BigNum::ToString() on this thread while alive
+class NumberFormatScope {
+public:
+    explicit NumberFormatScope(NumberFormat format) noexcept;
+    ~NumberFormatScope();
+
+    NumberFormatScope(const NumberFormatScope&) = delete;
+    NumberFormatScope& operator=(const NumberFormatScope&) = delete;
+
+private:
+    NumberFormat m_previous;
+};
+
 class BigNum {
 public:
-    using Rational = boost::multiprecision::cpp_rational;
-    using Integer = boost::multiprecision::cpp_int;
+    using Backend = backend::Selected;
+    using Rational = Backend::Rational;
+    using Integer = Backend::Integer;
 
     BigNum();
+    // A decimal, such as -12 or 1.25, or a fraction of integers, such as 4/7
     BigNum(std::string_view str);
     BigNum(Rational val);
     BigNum(int64_t val);
@@ -20,10 +49,24 @@ public:
     const Rational& GetImpl() const noexcept;
 
     size_t Hash() const;
+    hash::Fingerprint Fingerprint() const;
 
     bool IsInteger() const;
     int Sign() const;
     std::string ToString() const;
+    std::string ToString(const NumberFormat& format) const;
+
+    BigNum Numerator() const;
+    BigNum Denominator() const;
+    BigNum Abs() const;
+    BigNum Pow(uint32_t exp) const;
+
+    // Integer-only operations
+    std::pair<BigNum, BigNum> DivMod(const BigNum& divisor) const;
+    BigNum Sqrt() const;
+
+    // For rationals: gcd of numerators over lcm of denominators
+    static BigNum Gcd(const BigNum& lhs, const BigNum& rhs);
 
     BigNum operator-() const;
 
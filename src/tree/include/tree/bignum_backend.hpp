@@ -0,0 +1,107 @@
+#pragma once
+
+#include <boost/multiprecision/cpp_int.hpp>
+#ifdef EZMATH_BIGNUM_GMP
+#include <boost/multiprecision/gmp.hpp>
+#endif
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Arithmetic backends of BigNum, selected with the BIGNUM_BACKEND cmake option.
+// Each one is a pair of boost::multiprecision number types, so BigNum and the rules
+// use the same free functions (numerator, pow, gcd, ...) with any of them.
+// Fraction(num, den) builds a normalized rational: equality compares representations.
+
+namespace ezmath::tree::backend {
+
+namespace detail {
+
+// rational_adaptor expects a positive denominator
+template<class Rational, class Integer>
+Rational MakeFraction(Integer num, Integer den) {
+    if (den.sign() < 0) {
+        num = -num;
+        den = -den;
+    }
+    return Rational{std::move(num), std::move(den)};
+}
+
+}
+
+// Arbitrary precision without dependencies. Decimal conversion of large values is quadratic
+// in boost and is done by halves in BigNum instead.
+struct CppRational {
+    using Integer = boost::multiprecision::cpp_int;
+    using Rational = boost::multiprecision::cpp_rational;
+
+    static constexpr std::string_view NAME = "cpp_rational";
+    static constexpr bool FAST_DECIMAL = false;
+
+    static Rational Fraction(Integer num, Integer den) {
+        return detail::MakeFraction<Rational>(std::move(num), std::move(den));
+    }
+};
+
+// Numerator and denominator of at most 128 bits stored inline, so arithmetic never allocates.
+// For bounded workloads: overflow throws std::overflow_error.
+struct Int128 {
+    using Integer = boost::multiprecision::checked_int128_t;
+    using Rational = boost::multiprecision::number<boost::multiprecision::rational_adaptor<Integer::backend_type>>;
+
+    static constexpr std::string_view NAME = "int128";
+    static constexpr bool FAST_DECIMAL = true;
+
+    static Rational Fraction(Integer num, Integer den) {
+        return detail::MakeFraction<Rational>(std::move(num), std::move(den));
+    }
+};
+
+#ifdef EZMATH_BIGNUM_GMP
+// GMP: subquadratic multiplication and decimal conversion for large operands
+struct Gmp {
+    using Integer = boost::multiprecision::mpz_int;
+    using Rational = boost::multiprecision::mpq_rational;
+
+    static constexpr std::string_view NAME = "gmp";
+    static constexpr bool FAST_DECIMAL = true;
+
+    // mpq keeps the given numerator and denominator as they are
+    static Rational Fraction(Integer num, Integer den) {
+        Rational res{std::move(num), std::move(den)};
+        mpq_canonicalize(res.backend().data());
+        return res;
+    }
+};
+#endif
+
+#if defined(EZMATH_BIGNUM_GMP)
+using Selected = Gmp;
+#elif defined(EZMATH_BIGNUM_INT128)
+using Selected = Int128;
+#else
+using Selected = CppRational;
+#endif
+
+// Magnitude as 64-bit words, most significant first
+template<class Integer>
+std::vector<uint64_t> Limbs(const Integer& value) {
+    std::vector<uint64_t> res;
+#ifdef EZMATH_BIGNUM_GMP
+    if constexpr (std::is_same_v<Integer, boost::multiprecision::mpz_int>) {
+        size_t count = 0;
+        res.resize((mpz_sizeinbase(value.backend().data(), 2) + 63) / 64);
+        mpz_export(res.data(), &count, 1, sizeof(uint64_t), 0, 0, value.backend().data());
+        res.resize(count);
+        return res;
+    } else
+#endif
+    {
+        boost::multiprecision::export_bits(value, std::back_inserter(res), 64);
+        return res;
+    }
+}
+
+}
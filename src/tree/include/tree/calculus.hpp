@@ -0,0 +1,14 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <string_view>
+
+namespace ezmath::tree {
+
+// Derivative of expr with respect to the symbol var, not simplified. Equal subtrees, compared by
+// Hash and IsEqualTo, are differentiated once and their derivatives are copied on reuse.
+// Products of many factors are differentiated logarithmically, (prod f)' = prod f * sum f'/f,
+// which keeps the result linear in the number of factors instead of quadratic.
+std::unique_ptr<IExpr> Differentiate(const IExpr& expr, std::string_view var);
+
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <tree/polynomial.hpp>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace ezmath::tree {
+
+// Univariate polynomial as a dense vector of integer coefficients, lowest degree first, times
+// a rational scale. The integer part is primitive with a positive leading coefficient, so that
+// products of such polynomials stay primitive and never need a gcd.
+//
+// Multiplication picks schoolbook, Karatsuba or multi-modular NTT by the size of the factors;
+// Polynomial switches to this representation for long univariate products.
+class DensePolynomial {
+public:
+    using Integer = BigNum::Integer;
+
+    enum class EAlgorithm : uint8_t {
+        Schoolbook,
+        Karatsuba,
+        Ntt
+    };
+
+    DensePolynomial() = default;
+    explicit DensePolynomial(std::vector<Integer> coefs, BigNum scale = 1);
+
+    static DensePolynomial Constant(BigNum value);
+    static DensePolynomial Variable(size_t exp = 1);
+
+    // nullopt if poly has more than one variable
+    static std::optional<DensePolynomial> FromSparse(const Polynomial& poly);
+    // Polynomial in one variable
+    Polynomial ToSparse() const;
+
+    bool IsZero() const noexcept;
+    // 0 for the zero polynomial
+    size_t Degree() const noexcept;
+    BigNum Coefficient(size_t exp) const;
+    std::span<const Integer> Integers() const noexcept;
+    const BigNum& Scale() const noexcept;
+
+    DensePolynomial Pow(uint32_t exp) const;
+
+    DensePolynomial operator-() const;
+    DensePolynomial operator+(const DensePolynomial& other) const;
+    DensePolynomial operator-(const DensePolynomial& other) const;
+    DensePolynomial operator*(const DensePolynomial& other) const;
+
+    bool operator==(const DensePolynomial& other) const;
+
+    // Product of integer coefficient vectors, lowest degree first
+    static std::vector<Integer> Multiply(std::span<const Integer> lhs, std::span<const Integer> rhs);
+    static std::vector<Integer> Multiply(std::span<const Integer> lhs, std::span<const Integer> rhs, EAlgorithm algorithm);
+    // bits: length of the largest coefficient
+    static EAlgorithm ChooseAlgorithm(size_t lhsSize, size_t rhsSize, size_t bits) noexcept;
+
+private:
+    void Normalize();
+
+private:
+    std::vector<Integer> m_coefficients;
+    BigNum m_scale = 1;
+};
+
+}
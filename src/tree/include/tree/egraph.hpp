@@ -0,0 +1,109 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Equality saturation: equivalent forms of an expression are collected in an e-graph
+// and the cheapest one under a cost model is extracted.
+
+namespace ezmath::tree::egraph {
+
+using ClassId = uint32_t;
+
+// Operator over e-classes. Numbers and symbols are leaves and keep the expression itself.
+// Children of sums and products are sorted, so operand order does not matter.
+struct ENode {
+    IExpr::EKind Kind;
+    std::shared_ptr<const IExpr> Leaf;
+    std::vector<ClassId> Children;
+
+    bool operator==(const ENode& other) const;
+};
+
+struct ENodeHash {
+    size_t operator()(const ENode& node) const;
+};
+
+class CostModel {
+public:
+    virtual ~CostModel() = default;
+
+    // Must be greater than the cost of every child
+    virtual size_t Cost(const ENode& node, std::span<const size_t> children) const = 0;
+};
+
+class NodeCount : public CostModel {
+public:
+    size_t Cost(const ENode& node, std::span<const size_t> children) const override;
+};
+
+// Approximate length of ToString()
+class PrintLength : public CostModel {
+public:
+    size_t Cost(const ENode& node, std::span<const size_t> children) const override;
+};
+
+// Produces an equivalent form of the expression or nullptr
+using Rewriter = std::function<std::unique_ptr<IExpr>(const IExpr&)>;
+
+// Every simplification rule of sums, products, powers and logarithms on its own, such as adding
+// like terms, factoring out common factors or distributing a power over a product
+std::vector<Rewriter> NodeRewriters();
+
+// The greedy simplifier, polynomial expansion and cancellation of rational functions, followed
+// by the node rewriters
+std::vector<Rewriter> DefaultRewriters();
+
+struct Options {
+    size_t MaxNodes = 4096;
+    size_t MaxIterations = 8;
+    std::chrono::milliseconds TimeLimit{200};
+    const CostModel* Cost = nullptr;    // NodeCount if not set
+    std::vector<Rewriter> Rewriters = DefaultRewriters();
+};
+
+class EGraph {
+public:
+    struct Choice {
+        size_t Cost;
+        ENode Node;
+    };
+    // Cheapest node of every class, indexed by canonical class id
+    using CostTable = std::vector<std::optional<Choice>>;
+
+    ClassId Add(const IExpr& expr);
+    ClassId Add(ENode node);
+
+    ClassId Find(ClassId id) const;
+    bool Merge(ClassId lhs, ClassId rhs);
+    // Restores congruence: classes whose nodes became equal after merges are merged too
+    void Rebuild();
+
+    size_t Classes() const noexcept;
+    size_t Nodes() const noexcept;
+
+    CostTable ComputeCosts(const CostModel& cost) const;
+    // id must be canonical when the table was computed
+    std::unique_ptr<IExpr> Extract(ClassId id, const CostTable& table) const;
+
+private:
+    ENode Canonicalize(ENode node) const;
+
+private:
+    mutable std::vector<ClassId> m_parents;
+    std::vector<std::vector<ENode>> m_classes;
+    std::unordered_map<ENode, ClassId, ENodeHash> m_hashcons;
+    size_t m_nodes = 0;
+};
+
+// Saturates the e-graph of expr with the rewriters within the limits and returns the cheapest form.
+// The result is not marked as simplified: math::simplify would bring it back to the greedy form.
+std::unique_ptr<IExpr> Saturate(const IExpr& expr, const Options& options = {});
+
+}
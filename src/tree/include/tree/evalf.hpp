@@ -0,0 +1,53 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <compare>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace ezmath::tree {
+
+// Numeric values of constant expressions, enclosed in intervals of binary floats. An expression is
+// evaluated at 128 bits first, and again at 512, 2048 and 8192 bits only while the interval is
+// too wide to answer, so easy questions stay cheap and hard ones get the precision they need.
+//
+// Arithmetic rounds the bounds outwards. Logarithms, exponentials and roots trust the float
+// library to a few units in the last place and are widened by much more than that.
+//
+// The enclosures of subtrees are cached by fingerprint for the evaluator's lifetime, so equal
+// subtrees are evaluated once, and later questions about the same trees start from what earlier
+// ones computed.
+//
+// The answers are empty for expressions with symbols or matrices, for undefined values such as
+// \ln{-1} or 0^{-1}, and when 8192 bits are not enough, e.g. for a sum that is exactly zero but
+// was not simplified to 0.
+class Evaluator {
+public:
+    Evaluator();
+    ~Evaluator();
+
+    Evaluator(const Evaluator&) = delete;
+    Evaluator& operator=(const Evaluator&) = delete;
+
+    // -1, 0 or 1; 0 only if the value is exactly zero at some precision, as 0 or 1-1 is
+    std::optional<int> Sign(const IExpr& expr);
+    std::optional<std::strong_ordering> Compare(const IExpr& lhs, const IExpr& rhs);
+    // The value rounded to the given number of significant decimal digits, e.g. "1.4142" for
+    // \sqrt{2} and 5 digits; the digits are those of every value in the enclosure
+    std::optional<std::string> Evalf(const IExpr& expr, size_t digits);
+
+    void Clear() noexcept;
+
+private:
+    struct Cache;
+
+    std::unique_ptr<Cache> m_cache;
+};
+
+// One-off questions; an Evaluator answers many of them about the same trees faster
+std::optional<int> NumericSign(const IExpr& expr);
+std::optional<std::strong_ordering> NumericCompare(const IExpr& lhs, const IExpr& rhs);
+std::optional<std::string> Evalf(const IExpr& expr, size_t digits);
+
+}
@@ -1,14 +1,83 @@
 #pragma once
 
+#include <tree/fingerprint.hpp>
+#include <tree/stats.hpp>
+#include <tree/yield.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <string>
 
 namespace ezmath::tree {
 
+// Atomic cache slot of a node. Rules rebuild nodes by assignment, which copies the slot;
+// that only happens to nodes owned by one thread, so the copy itself need not be atomic.
+template<class T>
+class CacheSlot : public std::atomic<T> {
+public:
+    using std::atomic<T>::atomic;
+    using std::atomic<T>::operator=;
+
+    CacheSlot(const CacheSlot& other) noexcept
+        : std::atomic<T>{other.load(std::memory_order_relaxed)}
+    {}
+
+    CacheSlot& operator=(const CacheSlot& other) noexcept {
+        this->store(other.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+};
+
+// Facts about a tree that rules consult instead of walking it; computed once per node from the
+// metadata of its children, see IExpr::Meta
+struct Metadata {
+    static constexpr uint32_t NOT_POLYNOMIAL = std::numeric_limits<uint32_t>::max();
+
+    // Bit Symbol::Id of every symbol in the tree. Symbols may share a bit, so a set bit only
+    // means the tree may contain the symbol, and equal masks do not imply equal symbol sets
+    uint64_t Symbols = 0;
+    // Total degree in the symbols, NOT_POLYNOMIAL unless the tree is a polynomial in them
+    uint32_t Degree = 0;
+    // Nodes and levels of the tree, saturating
+    uint32_t Size = 1;
+    uint32_t Depth = 1;
+    // No symbols at all
+    bool IsConstant = true;
+
+    static constexpr uint32_t Saturate(const uint64_t value) noexcept {
+        return static_cast<uint32_t>(std::min<uint64_t>(value, NOT_POLYNOMIAL - 1));
+    }
+
+    // Accounts for a child of the node; the degree is left to the node
+    constexpr void AddChild(const Metadata& child) noexcept {
+        Symbols |= child.Symbols;
+        Size = Saturate(uint64_t{Size} + child.Size);
+        Depth = std::max(Depth, Saturate(uint64_t{child.Depth} + 1));
+        IsConstant &= child.IsConstant;
+    }
+};
+
 struct IExpr {
+    // Concrete node type; Is<T>() compares it with T::KIND instead of running dynamic_cast
+    enum class EKind : uint8_t {
+        Number,
+        Symbol,
+        Sum,
+        Product,
+        Power,
+        Matrix,
+        Log
+    };
+
     virtual ~IExpr() = default;
 
     virtual std::unique_ptr<IExpr> Simplify() = 0;
+    virtual bool IsSimplified() const noexcept = 0;
     virtual size_t Hash() const = 0;
+    virtual hash::Fingerprint Fingerprint() const = 0;
+    virtual Metadata Meta() const = 0;
     virtual constexpr bool IsConstant() const = 0;
     virtual constexpr int Sign() const = 0;
     virtual bool IsEqualTo(const IExpr& other) const = 0;
@@ -22,34 +91,195 @@ struct IExpr {
     const T* As() const noexcept { return static_cast<const T*>(this); }
 
     template<typename T>
-    bool Is() const noexcept { return static_cast<bool>(dynamic_cast<const T*>(this)); }
+    bool Is() const noexcept {
+        if constexpr (requires { T::KIND; }) {
+            return m_kind == T::KIND;
+        } else {
+            return static_cast<bool>(dynamic_cast<const T*>(this));
+        }
+    }
+
+    EKind Kind() const noexcept { return m_kind; }
+
+protected:
+    explicit IExpr(const EKind kind) noexcept
+        : m_kind{kind}
+    {}
+
+private:
+    EKind m_kind;
 };
 
+// Immutable tree shared between threads, see math::freeze
+using SharedExpr = std::shared_ptr<const IExpr>;
+
 class BaseExpression : public IExpr {
 public:
+    explicit BaseExpression(const EKind kind) noexcept
+        : IExpr{kind}
+    {}
+
+    // Caches are filled lazily from const methods, so they are atomic: readers of a frozen tree
+    // may race to compute them, but every one of them computes the same value.
     size_t Hash() const final {
-        return m_bufferedHash = (m_bufferedHash ? m_bufferedHash : HashImpl());
+        auto res = m_bufferedHash.load(std::memory_order_relaxed);
+        if (!res) {
+            Unwind(ECached::Hash);
+            const Nesting nesting;
+            res = HashImpl();
+            m_bufferedHash.store(res, std::memory_order_relaxed);
+        }
+        return res;
+    }
+
+    // Hash of the node as it is, past the cache: rules change nodes in place, and the cache is
+    // reset only once SimplifyImpl returns
+    size_t CurrentHash() const {
+        Unwind(ECached::Hash);
+        const Nesting nesting;
+        return HashImpl();
+    }
+
+    hash::Fingerprint Fingerprint() const final {
+        if (m_fingerprintState.load(std::memory_order_acquire) == ECache::Ready) {
+            return m_bufferedFingerprint;
+        }
+        Unwind(ECached::Fingerprint);
+        const Nesting nesting;
+        const auto res = FingerprintImpl();
+        auto expected = ECache::Empty;
+        if (m_fingerprintState.compare_exchange_strong(expected, ECache::Writing, std::memory_order_acquire)) {
+            m_bufferedFingerprint = res;
+            m_fingerprintState.store(ECache::Ready, std::memory_order_release);
+        }
+        return res;
+    }
+
+    Metadata Meta() const final {
+        if (m_metadataState.load(std::memory_order_acquire) == ECache::Ready) {
+            return m_bufferedMetadata;
+        }
+        Unwind(ECached::Metadata);
+        const Nesting nesting;
+        const auto res = MetadataImpl();
+        auto expected = ECache::Empty;
+        if (m_metadataState.compare_exchange_strong(expected, ECache::Writing, std::memory_order_acquire)) {
+            m_bufferedMetadata = res;
+            m_metadataState.store(ECache::Ready, std::memory_order_release);
+        }
+        return res;
+    }
+
+    // Past MAX_RECURSION_DEPTH nested calls the subtree is compared by fingerprint, which
+    // is computed without recursion
+    bool IsEqualTo(const IExpr& other) const final;
+    // A copy inherits the caches of the original
+    std::unique_ptr<IExpr> Copy() const final;
+    std::string ToString() const final;
+
+    bool IsConstant() const final {
+        return Meta().IsConstant;
     }
 
     std::unique_ptr<IExpr> Simplify() final {
-        if (m_isSimplified) {
+        if (m_isSimplified || yield::Stop()) {
             return nullptr;
         }
         if (auto res = SimplifyImpl()) {
-            res->As<BaseExpression>()->m_isSimplified = true;
+            // A replacement may still be reducible; chains of rewrites are bounded to rule out cycles
+            if (!res->IsSimplified() && rewriteDepth < MAX_REWRITE_DEPTH) {
+                ++rewriteDepth;
+                if (auto next = res->Simplify()) {
+                    res = std::move(next);
+                }
+                --rewriteDepth;
+            }
+            // An interrupted replacement is finished by the next step
+            if (!yield::Interrupted()) {
+                res->As<BaseExpression>()->m_isSimplified = true;
+            }
             return res;
         }
-        m_isSimplified = true;
+        // Rules may have changed the node in place
+        m_bufferedHash.store(0, std::memory_order_relaxed);
+        InvalidateMetadata();
+        m_fingerprintState.store(ECache::Empty, std::memory_order_relaxed);
+        m_isSimplified = !yield::Interrupted();
         return nullptr;
     }
 
+    bool IsSimplified() const noexcept final {
+        return m_isSimplified;
+    }
+
+protected:
+    // Called by every method that changes the children of a node
+    void InvalidateMetadata() noexcept {
+        m_metadataState.store(ECache::Empty, std::memory_order_relaxed);
+    }
+
+    // Destroys a child; called by the destructors of nodes with children. Past
+    // MAX_RECURSION_DEPTH nested destructors the child is queued instead, and the outermost
+    // call frees the queue, so freeing a tree takes bounded stack however deep it is.
+    static void Release(std::unique_ptr<IExpr>&& child) noexcept;
+
 private:
+    enum class ECache : uint8_t {
+        Empty,
+        Writing,
+        Ready
+    };
+
+    enum class ECached : uint8_t {
+        Hash,
+        Fingerprint,
+        Metadata
+    };
+
+    static constexpr size_t MAX_REWRITE_DEPTH = 64;
+    static inline thread_local size_t rewriteDepth = 0;
+
+    // Calls into children recurse through the methods below; deeper calls continue on the
+    // explicit stacks of traverse.hpp, with a fresh budget for the nodes they visit
+    static constexpr size_t MAX_RECURSION_DEPTH = 512;
+    static inline thread_local size_t recursionDepth = 0;
+
+    struct Nesting {
+        Nesting() noexcept { ++recursionDepth; }
+        ~Nesting() { --recursionDepth; }
+        Nesting(const Nesting&) = delete;
+        Nesting& operator=(const Nesting&) = delete;
+    };
+
+    // Past the budget, fills the cache in every node below this one, children first, so the
+    // Impl method of this node reads the caches of its children and does not recurse
+    void Unwind(const ECached cache) const {
+        if (recursionDepth >= MAX_RECURSION_DEPTH) {
+            UnwindSubtree(cache);
+        }
+    }
+
+    void UnwindSubtree(ECached cache) const;
+    std::unique_ptr<IExpr> CopyNode() const;
+    std::unique_ptr<IExpr> UnwindCopy() const;
+    std::string UnwindToString() const;
+
     virtual size_t HashImpl() const = 0;
+    virtual hash::Fingerprint FingerprintImpl() const = 0;
+    virtual Metadata MetadataImpl() const = 0;
+    virtual bool IsEqualToImpl(const IExpr& other) const = 0;
+    virtual std::unique_ptr<IExpr> CopyImpl() const = 0;
+    virtual std::string ToStringImpl() const = 0;
     virtual std::unique_ptr<IExpr> SimplifyImpl() = 0;
 
 private:
     bool m_isSimplified = false;
-    mutable size_t m_bufferedHash = 0;
+    mutable CacheSlot<ECache> m_fingerprintState = ECache::Empty;
+    mutable CacheSlot<size_t> m_bufferedHash = 0;
+    mutable hash::Fingerprint m_bufferedFingerprint;
+    mutable CacheSlot<ECache> m_metadataState = ECache::Empty;
+    mutable Metadata m_bufferedMetadata;
+    [[no_unique_address]] stats::NodeTracker m_tracker;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <tree/polynomial.hpp>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace ezmath::tree {
+
+// poly = Content * product of Factors[i].first ^ Factors[i].second
+struct Factorization {
+    BigNum Content = 1;
+    // Irreducible over the integers, primitive with a positive leading coefficient, sorted by degree
+    std::vector<std::pair<Polynomial, uint32_t>> Factors;
+};
+
+// Factorization over the integers of a polynomial in one variable; nullopt for several variables.
+// Square-free parts are factored modulo a word-sized prime by Cantor-Zassenhaus, the factors are
+// lifted by Hensel's lemma beyond the Mignotte bound, and true factors are recombined from subsets.
+std::optional<Factorization> Factor(const Polynomial& poly);
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <bit>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace ezmath::tree::hash {
+
+// 128-bit structural fingerprint. Unlike Hash(), equal fingerprints are treated as equal trees.
+struct Fingerprint {
+    uint64_t Low = 0;
+    uint64_t High = 0;
+
+    constexpr auto operator<=>(const Fingerprint&) const = default;
+};
+
+struct FingerprintHash {
+    constexpr size_t operator()(const Fingerprint& fp) const noexcept {
+        return fp.Low;
+    }
+};
+
+// Block step of MurmurHash3_x64_128: order dependent
+constexpr Fingerprint absorb(Fingerprint fp, uint64_t k1, uint64_t k2) {
+    constexpr uint64_t C1 = 0x87c37b91114253d5u;
+    constexpr uint64_t C2 = 0x4cf5ad432745937fu;
+
+    k1 *= C1; k1 = std::rotl(k1, 31); k1 *= C2; fp.Low ^= k1;
+    fp.Low = std::rotl(fp.Low, 27); fp.Low += fp.High; fp.Low = fp.Low * 5 + 0x52dce729;
+
+    k2 *= C2; k2 = std::rotl(k2, 33); k2 *= C1; fp.High ^= k2;
+    fp.High = std::rotl(fp.High, 31); fp.High += fp.Low; fp.High = fp.High * 5 + 0x38495ab5;
+    return fp;
+}
+
+constexpr Fingerprint absorb(const Fingerprint fp, const Fingerprint value) {
+    return absorb(fp, value.Low, value.High);
+}
+
+constexpr uint64_t _fmix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdu;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53u;
+    k ^= k >> 33;
+    return k;
+}
+
+constexpr Fingerprint finalize(Fingerprint fp) {
+    fp.Low += fp.High;
+    fp.High += fp.Low;
+    fp.Low = _fmix(fp.Low);
+    fp.High = _fmix(fp.High);
+    fp.Low += fp.High;
+    fp.High += fp.Low;
+    return fp;
+}
+
+// Order independent combination: addition modulo 2^128
+constexpr Fingerprint accumulate(const Fingerprint lhs, const Fingerprint rhs) {
+    const uint64_t low = lhs.Low + rhs.Low;
+    return {low, lhs.High + rhs.High + (low < lhs.Low)};
+}
+
+inline Fingerprint fingerprint(const uint64_t seed, const std::string_view bytes) {
+    Fingerprint fp{seed, ~seed};
+    size_t i = 0;
+    for (; i + 16 <= bytes.size(); i += 16) {
+        uint64_t k1, k2;
+        std::memcpy(&k1, bytes.data() + i, 8);
+        std::memcpy(&k2, bytes.data() + i + 8, 8);
+        fp = absorb(fp, k1, k2);
+    }
+    uint64_t tail[2] = {0, 0};
+    std::memcpy(tail, bytes.data() + i, bytes.size() - i);
+    return finalize(absorb(absorb(fp, tail[0], tail[1]), bytes.size(), 0));
+}
+
+}
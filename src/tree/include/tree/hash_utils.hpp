@@ -2,6 +2,8 @@
 
 #include <tree/expression.hpp>
 #include <numeric>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace ezmath::tree::hash {
@@ -42,4 +44,70 @@ inline size_t asymmetric_hash(const T& container) {
     return std::accumulate(++hashes.begin(), hashes.end(), hashes.front(), _combine);
 }
 
+// Fingerprint of a multiset of children: does not depend on iteration order
+template<std::ranges::range T>
+inline Fingerprint unordered_fingerprint(const T& container) {
+    Fingerprint res;
+    for (const auto& val : container) {
+        res = accumulate(res, val.Expression->Fingerprint());
+    }
+    return absorb(res, container.size(), 0);
+}
+
+// Equality of multisets of children that compares every pair at most once. operator== of
+// std::unordered_multiset may compare a pair twice, which doubles the work at every level of
+// nested sums or products.
+template<class T>
+inline bool same_elements(const T& lhs, const T& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    const auto hash = rhs.hash_function();
+    std::unordered_set<const typename T::value_type*> matched;
+    matched.reserve(rhs.size());
+    for (const auto& val : lhs) {
+        const auto valHash = hash(val);
+        const auto bucket = rhs.bucket(val);
+        const auto it = std::find_if(rhs.begin(bucket), rhs.end(bucket), [&](const auto& other) {
+            return hash(other) == valHash && !matched.contains(&other) && other == val;
+        });
+        if (it == rhs.end(bucket)) {
+            return false;
+        }
+        matched.insert(&*it);
+    }
+    return true;
+}
+
+// Maps trees to values by fingerprint alone, without comparing the trees themselves
+template<class V>
+class FingerprintIndex {
+public:
+    V* Find(const Fingerprint& key) {
+        auto it = m_values.find(key);
+        return it == m_values.end() ? nullptr : &it->second;
+    }
+
+    const V* Find(const Fingerprint& key) const {
+        auto it = m_values.find(key);
+        return it == m_values.end() ? nullptr : &it->second;
+    }
+
+    V* Find(const IExpr& expr) { return Find(expr.Fingerprint()); }
+    const V* Find(const IExpr& expr) const { return Find(expr.Fingerprint()); }
+
+    // Returns the stored value and whether it was inserted now
+    std::pair<V&, bool> Insert(const IExpr& expr, V value) {
+        auto [it, inserted] = m_values.try_emplace(expr.Fingerprint(), std::move(value));
+        return {it->second, inserted};
+    }
+
+    bool Erase(const IExpr& expr) { return m_values.erase(expr.Fingerprint()) != 0; }
+    void Clear() noexcept { m_values.clear(); }
+    size_t Size() const noexcept { return m_values.size(); }
+
+private:
+    std::unordered_map<Fingerprint, V, FingerprintHash> m_values;
+};
+
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <tree/polynomial.hpp>
+#include <limits>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ezmath::tree {
+
+struct Equation {
+    std::unique_ptr<IExpr> Lhs;
+    std::unique_ptr<IExpr> Rhs;
+};
+
+// System of linear equations with rational coefficients in its symbols, stored as sparse integer rows.
+// Solved by fraction-free (Bareiss) elimination: every division is exact and the entries stay
+// minors of the input, so coefficients grow linearly with the rank instead of exponentially.
+class LinearSystem {
+public:
+    enum class ESolution : uint8_t {
+        Unique,
+        Infinite,
+        Inconsistent
+    };
+
+    struct Solution {
+        ESolution Kind = ESolution::Inconsistent;
+        // Unknowns in order with their values. With infinitely many solutions the pivot unknowns
+        // are expressed through the free ones, and a free unknown is its own value.
+        std::vector<std::pair<std::unique_ptr<IExpr>, std::unique_ptr<IExpr>>> Values;
+    };
+
+    LinearSystem() = default;
+    LinearSystem(LinearSystem&&) = default;
+    LinearSystem(const LinearSystem&) = delete;
+
+    // nullopt if an equation is not linear or has coefficients which are not rational numbers
+    static std::optional<LinearSystem> FromEquations(std::span<const Equation> equations);
+
+    size_t Unknowns() const noexcept;
+    size_t Equations() const noexcept;
+    const IExpr& Unknown(size_t var) const;
+
+    Solution Solve() const;
+
+private:
+    // Nonzero entries sorted by column; the right-hand side is the last column, RHS
+    using Row = std::vector<std::pair<size_t, BigNum::Integer>>;
+    static constexpr size_t RHS = std::numeric_limits<size_t>::max();
+
+    static std::optional<Row> MakeRow(const Polynomial& poly);
+    // Bareiss elimination to row echelon form; returns the pivot column of every nonzero row
+    static std::vector<size_t> Eliminate(std::vector<Row>& rows, size_t columns);
+
+private:
+    PolynomialRing m_ring;
+    // Generator of the ring in every column, by name of the unknown
+    std::vector<size_t> m_unknowns;
+    std::vector<Row> m_rows;
+};
+
+}
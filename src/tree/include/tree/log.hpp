@@ -0,0 +1,42 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <tree/rules.hpp>
+#include <span>
+
+namespace ezmath::tree {
+
+// Natural logarithm
+class Log : public BaseExpression {
+public:
+    static constexpr EKind KIND = EKind::Log;
+
+    explicit Log(std::unique_ptr<IExpr>&& arg);
+    ~Log() override;
+
+    const IExpr& GetArgument() const noexcept;
+    std::unique_ptr<IExpr>&& DetachArgument() noexcept;
+
+    constexpr int Sign() const override { return 1; }
+    bool HasDirtyChildren() const;
+
+    // Rules of SimplifyImpl in the order they are tried, each of them rewrites this node only
+    static std::span<const Rule<Log>> Rules();
+
+private:
+    std::unique_ptr<IExpr> simplify_SimplifyChildren();
+    std::unique_ptr<IExpr> simplify_DegenerateCases();
+
+    std::unique_ptr<IExpr> SimplifyImpl() override;
+    size_t HashImpl() const override;
+    hash::Fingerprint FingerprintImpl() const override;
+    Metadata MetadataImpl() const override;
+    bool IsEqualToImpl(const IExpr& other) const override;
+    std::unique_ptr<IExpr> CopyImpl() const override;
+    std::string ToStringImpl() const override;
+
+private:
+    std::unique_ptr<IExpr> m_arg;
+};
+
+}
@@ -1,9 +1,16 @@
 #pragma once
 
+#include <tree/calculus.hpp>
+#include <tree/evalf.hpp>
 #include <tree/exception.hpp>
+#include <tree/factor.hpp>
+#include <tree/log.hpp>
+#include <tree/matrix.hpp>
 #include <tree/number.hpp>
+#include <tree/polynomial.hpp>
 #include <tree/power.hpp>
 #include <tree/product.hpp>
+#include <tree/substitute.hpp>
 #include <tree/sum.hpp>
 #include <tree/symbol.hpp>
 
@@ -72,6 +79,14 @@ struct math {
         return std::make_unique<Number>(std::move(val));
     }
 
+    static std::unique_ptr<Matrix> matrix(const size_t rows, const size_t cols, Matrix::Entries&& entries) {
+        return std::make_unique<Matrix>(rows, cols, std::move(entries));
+    }
+
+    static std::unique_ptr<Log> log(std::unique_ptr<IExpr>&& arg) {
+        return std::make_unique<Log>(std::move(arg));
+    }
+
     static std::unique_ptr<IExpr> negate(std::unique_ptr<IExpr>&& val) {
         return multiply(number(-1), std::move(val));
     }
@@ -85,6 +100,81 @@ struct math {
             val = std::move(res);
         }
     }
+
+    // Replaces symbols by values in one pass, simplifying bottom-up unless told otherwise
+    static void substitute(std::unique_ptr<IExpr>& val, const Substitution& values, const bool simplify = true) {
+        Substitute(val, values, simplify);
+    }
+
+    // order-th derivative with respect to var, simplified after every step
+    static void diff(std::unique_ptr<IExpr>& val, const std::string_view var, const size_t order = 1) {
+        for (size_t i = 0; i < order; ++i) {
+            val = Differentiate(*val, var);
+            simplify(val);
+        }
+    }
+
+    // Multiplies out products and natural powers of sums; univariate ones use dense arithmetic.
+    // Only the monomials are simplified afterwards, since simplifying the sum would factor its
+    // content back out.
+    static void expand(std::unique_ptr<IExpr>& val) {
+        // Simplify first, so that exponents such as {3} are numbers
+        simplify(val);
+        PolynomialRing ring;
+        auto poly = ring.FromExpr(*val);
+        if (!poly) {
+            return;
+        }
+        auto terms = ring.ToTerms(*poly);
+        for (auto& term : terms) {
+            simplify(term);
+        }
+        if (terms.empty()) {
+            val = number(0);
+        } else if (terms.size() == 1) {
+            val = std::move(terms.front());
+        } else {
+            val = add(std::move(terms));
+        }
+    }
+
+    // Writes a polynomial in one variable as a product of powers of irreducible integer polynomials
+    static void factor(std::unique_ptr<IExpr>& val) {
+        // Simplify first, so that exponents such as {2} are numbers
+        simplify(val);
+        PolynomialRing ring;
+        if (auto poly = ring.FromExpr(*val)) {
+            if (auto res = Factor(*poly); res && !res->Factors.empty()) {
+                std::vector<std::unique_ptr<IExpr>> factors;
+                factors.push_back(number(std::move(res->Content)));
+                for (auto& [factor, exp] : res->Factors) {
+                    factors.push_back(math::exp(ring.ToExpr(factor), number(static_cast<int64_t>(exp))));
+                }
+                val = multiply(std::move(factors));
+            }
+        }
+        simplify(val);
+    }
+
+    // Rewrites val as a single fraction of polynomials without common factors
+    static void cancel(std::unique_ptr<IExpr>& val) {
+        PolynomialRing ring;
+        if (auto func = ring.FromRational(*val)) {
+            func->Cancel();
+            val = ring.ToExpr(*func);
+        }
+        simplify(val);
+    }
+
+    // Takes ownership of the tree and fills its caches, so that threads can read, print and
+    // compare it without copying. Only const methods are reachable, which never change the tree.
+    static SharedExpr freeze(std::unique_ptr<IExpr>&& val) {
+        val->Hash();
+        val->Fingerprint();
+        val->Meta();
+        val->Sign();
+        return SharedExpr{std::move(val)};
+    }
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <tree/bigint.hpp>
+#include <span>
+#include <variant>
+#include <vector>
+
+namespace ezmath::tree {
+
+// Dense matrix in a contiguous row-major buffer. Entries are expressions, or BigNums once every
+// entry is a number: simplification converts the buffer, and arithmetic on numeric matrices
+// runs on integer kernels instead of expression trees.
+//
+// Products of matrices do not commute, while Product is a multiset, so a product may contain
+// at most one matrix (it scales the entries); matrices are multiplied with Multiply.
+class Matrix : public BaseExpression {
+public:
+    static constexpr EKind KIND = EKind::Matrix;
+
+    using Entries = std::vector<std::unique_ptr<IExpr>>;
+    using Numbers = std::vector<BigNum>;
+
+    Matrix(size_t rows, size_t cols, Entries&& entries);
+    Matrix(size_t rows, size_t cols, Numbers&& numbers);
+    ~Matrix() override;
+
+    static std::unique_ptr<Matrix> Identity(size_t size);
+
+    size_t Rows() const noexcept;
+    size_t Cols() const noexcept;
+    bool IsNumeric() const noexcept;
+    // Only for numeric matrices
+    std::span<const BigNum> GetNumbers() const;
+    // Empty for numeric matrices
+    std::span<const std::unique_ptr<IExpr>> GetEntries() const noexcept;
+    std::unique_ptr<IExpr> Entry(size_t row, size_t col) const;
+
+    std::unique_ptr<Matrix> Add(const Matrix& other) const;
+    std::unique_ptr<Matrix> Scale(const IExpr& factor) const;
+    std::unique_ptr<Matrix> Multiply(const Matrix& other) const;
+    std::unique_ptr<Matrix> Pow(const BigNum& exp) const;
+    std::unique_ptr<IExpr> Determinant() const;
+    // Throws CalcException if the matrix is singular
+    std::unique_ptr<Matrix> Inverse() const;
+
+    constexpr int Sign() const override { return 1; }
+    bool HasDirtyChildren() const;
+
+private:
+    std::unique_ptr<IExpr> simplify_SimplifyChildren();
+    std::unique_ptr<IExpr> simplify_NumericEntries();
+
+    std::unique_ptr<IExpr> SimplifyImpl() override;
+    size_t HashImpl() const override;
+    hash::Fingerprint FingerprintImpl() const override;
+    Metadata MetadataImpl() const override;
+    bool IsEqualToImpl(const IExpr& other) const override;
+    std::unique_ptr<IExpr> CopyImpl() const override;
+    std::string ToStringImpl() const override;
+
+    void CheckSquare(std::string_view operation) const;
+    std::unique_ptr<Matrix> Clone() const;
+
+private:
+    size_t m_rows;
+    size_t m_cols;
+    std::variant<Entries, Numbers> m_entries;
+};
+
+}
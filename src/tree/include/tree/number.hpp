@@ -7,6 +7,8 @@ namespace ezmath::tree {
 
 class Number : public BaseExpression {
 public:
+    static constexpr EKind KIND = EKind::Number;
+
     using bigint = BigNum;
 
     Number(bigint val);
@@ -15,15 +17,16 @@ public:
     const bigint& Value() const noexcept;
     bigint&& DetachValue() noexcept;
 
-    constexpr bool IsConstant() const override { return true; }
     int Sign() const override;
-    bool IsEqualTo(const IExpr& other) const override;
-    std::unique_ptr<IExpr> Copy() const override;
-    std::string ToString() const override;
     
 private:
     std::unique_ptr<IExpr> SimplifyImpl() override;
     size_t HashImpl() const override;
+    hash::Fingerprint FingerprintImpl() const override;
+    Metadata MetadataImpl() const override;
+    bool IsEqualToImpl(const IExpr& other) const override;
+    std::unique_ptr<IExpr> CopyImpl() const override;
+    std::string ToStringImpl() const override;
     bigint m_value;
 };
 
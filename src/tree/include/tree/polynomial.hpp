@@ -0,0 +1,133 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <tree/bigint.hpp>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace ezmath::tree {
+
+// Sparse multivariate polynomial with rational coefficients.
+// Terms are stored packed: exponent vectors of all terms live in one contiguous buffer,
+// sorted in descending lexicographic order without zero coefficients.
+class Polynomial {
+public:
+    using Exponent = uint32_t;
+
+    explicit Polynomial(size_t variables = 0);
+
+    static Polynomial Constant(size_t variables, BigNum value);
+    static Polynomial Variable(size_t variables, size_t var, Exponent exp = 1);
+
+    size_t Variables() const noexcept;
+    size_t Size() const noexcept;
+    std::span<const Exponent> Exponents(size_t term) const;
+    const BigNum& Coefficient(size_t term) const;
+    const BigNum& LeadingCoefficient() const;
+
+    bool IsZero() const noexcept;
+    bool IsConstant() const noexcept;
+    Exponent Degree(size_t var) const;
+
+    // Rational c such that *this / c has coprime integer coefficients and a positive leading coefficient
+    BigNum Content() const;
+    Polynomial PrimitivePart() const;
+
+    // Gcd of the coefficients of *this viewed as a univariate polynomial in var
+    Polynomial ContentIn(size_t var) const;
+    std::vector<Polynomial> CoefficientsIn(size_t var) const;
+
+    Polynomial Evaluate(size_t var, const BigNum& value) const;
+    Polynomial Pow(Exponent exp) const;
+    std::optional<Polynomial> DivideExact(const Polynomial& divisor) const;
+
+    // Primitive gcd with positive leading coefficient; numeric content is not included
+    static Polynomial Gcd(const Polynomial& lhs, const Polynomial& rhs);
+
+    Polynomial operator-() const;
+    Polynomial operator+(const Polynomial& other) const;
+    Polynomial operator-(const Polynomial& other) const;
+    Polynomial operator*(const Polynomial& other) const;
+    Polynomial operator*(const BigNum& value) const;
+
+    bool operator==(const Polynomial& other) const;
+
+private:
+    friend class DensePolynomial;
+
+    // Univariate products switch to DensePolynomial from this many terms per factor,
+    // unless the degree exceeds the number of terms this many times
+    static constexpr size_t DENSE_MIN_TERMS = 16;
+    static constexpr size_t DENSE_MAX_GAP = 4;
+
+    void Extend(size_t variables);
+    void PushTerm(std::span<const Exponent> exps, BigNum coef);
+    void Normalize();
+
+    static Polynomial Merge(const Polynomial& lhs, const Polynomial& rhs, int sign);
+    Polynomial MultiplyByTerm(std::span<const Exponent> exps, const BigNum& coef) const;
+
+    static Polynomial FromCoefficients(std::vector<Polynomial>&& coefs, size_t var);
+    static Polynomial Interpolate(Polynomial image, const BigNum& xi, size_t var);
+
+    static Polynomial IntegerGcd(const Polynomial& lhs, const Polynomial& rhs);
+    static Polynomial PrimitiveGcd(const Polynomial& lhs, const Polynomial& rhs);
+    static std::optional<Polynomial> HeuristicGcd(const Polynomial& lhs, const Polynomial& rhs);
+    static Polynomial PrsGcd(const Polynomial& lhs, const Polynomial& rhs);
+
+private:
+    size_t m_variables;
+    std::vector<Exponent> m_exponents;
+    std::vector<BigNum> m_coefficients;
+};
+
+// Quotient of two polynomials, kept as is until Cancel is called
+struct RationalFunction {
+    Polynomial Numerator;
+    Polynomial Denominator;
+
+    RationalFunction Inverse() const;
+    RationalFunction Pow(Polynomial::Exponent exp) const;
+
+    RationalFunction operator+(const RationalFunction& other) const;
+    RationalFunction operator*(const RationalFunction& other) const;
+
+    // Divides out the gcd and makes the denominator primitive with a positive leading coefficient.
+    // Returns false if numerator and denominator had no common non-constant factor.
+    bool Cancel();
+};
+
+// Maps expression trees to polynomials over generators: every subexpression which is not
+// a number, sum, product or natural power becomes a variable.
+class PolynomialRing {
+public:
+    PolynomialRing() = default;
+    PolynomialRing(PolynomialRing&&) = default;
+    PolynomialRing(const PolynomialRing&) = delete;
+
+    static constexpr size_t MAX_TERMS = 4096;
+    static constexpr Polynomial::Exponent MAX_EXPONENT = 1024;
+
+    std::optional<Polynomial> FromExpr(const IExpr& expr, size_t maxTerms = MAX_TERMS);
+    std::unique_ptr<IExpr> ToExpr(const Polynomial& poly) const;
+    // The monomials of ToExpr, one product each
+    std::vector<std::unique_ptr<IExpr>> ToTerms(const Polynomial& poly) const;
+
+    // Like FromExpr, but integer powers may be negative and sums of fractions are brought together
+    std::optional<RationalFunction> FromRational(const IExpr& expr, size_t maxTerms = MAX_TERMS);
+    std::unique_ptr<IExpr> ToExpr(const RationalFunction& func) const;
+
+    size_t Variables() const noexcept;
+    const IExpr& Generator(size_t var) const;
+
+private:
+    size_t AddGenerator(const IExpr& expr);
+
+private:
+    std::vector<std::unique_ptr<IExpr>> m_generators;
+    std::unordered_multimap<size_t, size_t> m_index;
+};
+
+}
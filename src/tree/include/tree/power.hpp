@@ -2,12 +2,17 @@
 
 #include <tree/expression.hpp>
 #include <tree/number.hpp>
+#include <tree/rules.hpp>
+#include <span>
 
 namespace ezmath::tree {
 
 class Power : public BaseExpression {
 public:
+    static constexpr EKind KIND = EKind::Power;
+
     Power(std::unique_ptr<IExpr>&& base, std::unique_ptr<IExpr>&& exp);
+    ~Power() override;
 
     const IExpr& GetBase() const noexcept;
     const IExpr& GetExp() const noexcept;
@@ -15,19 +20,26 @@ public:
     std::unique_ptr<IExpr>&& DetachBase() noexcept;
     std::unique_ptr<IExpr>&& DetachExp() noexcept;
 
-    bool IsConstant() const override;
     constexpr int Sign() const override { return 1; };
-    bool IsEqualTo(const IExpr& other) const override;
-    std::unique_ptr<IExpr> Copy() const override;
-    std::string ToString() const override;
+    bool HasDirtyChildren() const;
+
+    // Rules of SimplifyImpl in the order they are tried, each of them rewrites this node only
+    static std::span<const Rule<Power>> Rules();
 
 private:
     std::unique_ptr<IExpr> simplify_ProductBase();
+    std::unique_ptr<IExpr> simplify_CancelFractions();
     std::unique_ptr<IExpr> simplify_SimplifyChildren();
+    std::unique_ptr<IExpr> simplify_MatrixBase();
     std::unique_ptr<IExpr> simplify_DegenerateCases();
 
     std::unique_ptr<IExpr> SimplifyImpl() override;
     size_t HashImpl() const override;
+    hash::Fingerprint FingerprintImpl() const override;
+    Metadata MetadataImpl() const override;
+    bool IsEqualToImpl(const IExpr& other) const override;
+    std::unique_ptr<IExpr> CopyImpl() const override;
+    std::string ToStringImpl() const override;
 
 private:
     std::unique_ptr<IExpr> m_base;
@@ -2,6 +2,8 @@
 
 #include <tree/hash_utils.hpp>
 #include <tree/number.hpp>
+#include <tree/rules.hpp>
+#include <span>
 #include <unordered_set>
 #include <vector>
 
@@ -30,12 +32,17 @@ const IExpr& GetExp(const Multiplier& mul);
 
 class Product : public BaseExpression {
 public:
+    static constexpr EKind KIND = EKind::Product;
+
     using ValueType = std::unordered_multiset<Multiplier, MultiplierHash>;
     using ConstantPart = ValueType;
     using VariablePart = ValueType;
     using Coefficient = Number::bigint;
 
     Product(std::vector<std::unique_ptr<IExpr>>&& values);
+    ~Product() override;
+    Product(Product&&) = default;
+    Product& operator=(Product&&) = default;
 
     const Coefficient& GetCoefficient() const;
     const ConstantPart& GetConstants() const;
@@ -45,23 +52,35 @@ public:
     ConstantPart&& DetachConstants();
     VariablePart&& DetachVariables();
 
-    bool IsConstant() const override;
+    // Hash of the simplified product with its coefficient dropped
+    size_t MonomialHash() const;
+
+    using BaseExpression::ToString;
+
     int Sign() const override;
-    bool IsEqualTo(const IExpr& other) const override;
-    std::unique_ptr<IExpr> Copy() const override;
-    std::string ToString() const override;
+    bool HasDirtyChildren() const;
+
+    // Rules of SimplifyImpl in the order they are tried, each of them rewrites this node only
+    static std::span<const Rule<Product>> Rules();
 
 private:
     std::unique_ptr<IExpr> simplify_MultiplyLikeTerms();
     std::unique_ptr<IExpr> simplify_SimplifyChildren();
     std::unique_ptr<IExpr> simplify_DegenerateCases();
+    std::unique_ptr<IExpr> simplify_ScaleMatrix();
+    std::unique_ptr<IExpr> simplify_CancelFractions();
 
     std::unique_ptr<IExpr> SimplifyImpl() override;
     size_t HashImpl() const override;
+    hash::Fingerprint FingerprintImpl() const override;
+    Metadata MetadataImpl() const override;
+    bool IsEqualToImpl(const IExpr& other) const override;
+    std::unique_ptr<IExpr> CopyImpl() const override;
+    std::string ToStringImpl() const override;
 
     void Add(std::unique_ptr<IExpr>&& subExpr);
 
-    void ToString(std::string& res, const IExpr& add, bool isSingle) const;
+    void ToString(std::string& res, const IExpr& add, std::string_view str, bool isSingle) const;
     std::string ToString(const ValueType& expressions) const;
 
 private:
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <tree/stats.hpp>
+#include <tree/yield.hpp>
+#include <array>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace ezmath::tree {
+
+template<class T>
+struct Rule {
+    std::string_view Name;
+    std::unique_ptr<IExpr> (T::*Apply)();
+    // May stop between nested simplifications when the quantum runs out, see yield.hpp
+    bool Interruptible = false;
+};
+
+template<class T>
+std::unique_ptr<IExpr> RunRule(T& expr, const Rule<T>& rule) {
+    const auto apply = [&] {
+        if (rule.Interruptible) {
+            return (expr.*rule.Apply)();
+        }
+        yield::Consume();
+        yield::Pin pin;
+        return (expr.*rule.Apply)();
+    };
+#ifdef EZMATH_SIMPLIFY_STATS
+    if (stats::IsEnabled()) {
+        const auto hash = expr.CurrentHash();
+        return stats::Measure(rule.Name, apply, [&] { return expr.CurrentHash() != hash; });
+    }
+#endif
+    return apply();
+}
+
+constexpr size_t MAX_RULE_PASSES = 8;
+
+// Applies rules in order until one of them produces a replacement for the expression.
+// Rules may leave new children unsimplified; the pass is then repeated, so that only those
+// children are revisited, until the expression reaches a fixed point.
+// Returns nullptr without finishing when an interruptible rule leaves children unsimplified
+// and the simplification has to yield.
+template<class T>
+std::unique_ptr<IExpr> ApplyRules(T& expr, const std::type_identity_t<std::span<const Rule<T>>> rules) {
+    for (size_t pass = 0; pass < MAX_RULE_PASSES; ++pass) {
+        for (const auto& rule : rules) {
+            if (auto res = RunRule(expr, rule)) {
+                return res;
+            }
+            if (rule.Interruptible && expr.HasDirtyChildren() && yield::Stop()) {
+                return nullptr;
+            }
+        }
+        if (!expr.HasDirtyChildren()) {
+            break;
+        }
+    }
+    return nullptr;
+}
+
+}
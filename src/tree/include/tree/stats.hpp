@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Per-rule simplifier instrumentation. Compiled in only with EZMATH_SIMPLIFY_STATS
+// (cmake -DENABLE_SIMPLIFY_STATS=ON); otherwise every hook below is empty.
+
+namespace ezmath::tree::stats {
+
+#ifdef EZMATH_SIMPLIFY_STATS
+constexpr bool Available = true;
+#else
+constexpr bool Available = false;
+#endif
+
+struct RuleStats {
+    std::string Name;
+    uint64_t Invocations = 0;
+    uint64_t Fired = 0;
+    std::chrono::nanoseconds Time{0};
+    uint64_t NodesAllocated = 0;
+    uint64_t NodesFreed = 0;
+};
+
+using Snapshot = std::vector<RuleStats>;
+
+void Enable(bool enabled) noexcept;
+bool IsEnabled() noexcept;
+
+Snapshot TakeSnapshot();
+void Reset();
+std::string ToJson(const Snapshot& snapshot);
+
+namespace detail {
+
+struct NodeCounters {
+    uint64_t Allocated = 0;
+    uint64_t Freed = 0;
+};
+
+inline thread_local NodeCounters nodeCounters;
+
+void Record(std::string_view rule, bool fired, std::chrono::nanoseconds time, const NodeCounters& nodes);
+
+} // namespace detail
+
+// Counts constructions and destructions of the expression node it is embedded into.
+#ifdef EZMATH_SIMPLIFY_STATS
+struct NodeTracker {
+    NodeTracker() noexcept { ++detail::nodeCounters.Allocated; }
+    NodeTracker(const NodeTracker&) noexcept : NodeTracker{} {}
+    NodeTracker& operator=(const NodeTracker&) noexcept { return *this; }
+    ~NodeTracker() { ++detail::nodeCounters.Freed; }
+};
+#else
+struct NodeTracker {};
+#endif
+
+// Runs a single rule application and accounts it. Inclusive: nested simplifications are counted too.
+// The rule fired if it returned a replacement or, failing that, if changed() reports that it
+// rewrote the node in place.
+template<class F, class C>
+auto Measure(const std::string_view rule, F&& apply, C&& changed) {
+    const auto before = detail::nodeCounters;
+    const auto start = std::chrono::steady_clock::now();
+
+    auto res = apply();
+
+    const auto time = std::chrono::steady_clock::now() - start;
+    const auto& after = detail::nodeCounters;
+    const bool fired = res != nullptr || changed();
+    detail::Record(rule, fired, std::chrono::duration_cast<std::chrono::nanoseconds>(time), {
+        .Allocated = after.Allocated - before.Allocated,
+        .Freed = after.Freed - before.Freed
+    });
+    return res;
+}
+
+} // namespace ezmath::tree::stats
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <tree/expression.hpp>
+#include <string_view>
+#include <unordered_map>
+
+namespace ezmath::tree {
+
+// Values of symbols by name; a value is copied into every place its symbol occurs
+using Substitution = std::unordered_map<std::string_view, SharedExpr>;
+
+// Replaces all symbols of values in expr at once, so values may mention the replaced symbols.
+// Subtrees whose Metadata::Symbols miss every replaced symbol are neither visited nor copied, and
+// the nodes on the way to a replacement are rebuilt from their moved children. With simplify,
+// each rebuilt node is simplified as soon as its children are, so numeric parts collapse early.
+void Substitute(std::unique_ptr<IExpr>& expr, const Substitution& values, bool simplify = true);
+
+}
@@ -3,6 +3,8 @@
 #include <tree/hash_utils.hpp>
 #include <tree/product.hpp>
 #include <tree/expression.hpp>
+#include <tree/rules.hpp>
+#include <span>
 #include <vector>
 
 namespace ezmath::tree {
@@ -11,6 +13,8 @@ struct Term {
     Term(std::unique_ptr<IExpr>&& expr);
 
     size_t Hash;
+    // Orders terms when choosing the leading one: hash of the term without its numeric coefficient
+    size_t Rank;
     std::unique_ptr<IExpr> Expression;
 
     friend bool operator==(const Term& lhs, const Term& rhs);
@@ -24,10 +28,15 @@ struct TermHash {
 
 class Sum : public BaseExpression {
 public:
+    static constexpr EKind KIND = EKind::Sum;
+
     using ValueType = std::unordered_multiset<Term, TermHash>;
     using ConstantType = Number::bigint;
 
     Sum(std::vector<std::unique_ptr<IExpr>>&& values);
+    ~Sum() override;
+    Sum(Sum&&) = default;
+    Sum& operator=(Sum&&) = default;
 
     const ConstantType& GetConstant() const noexcept;
     const ValueType& GetTerms() const noexcept;
@@ -35,11 +44,16 @@ public:
     ValueType&& DetachTerms() noexcept;
 
     size_t HashImpl() const override;
+    hash::Fingerprint FingerprintImpl() const override;
+    Metadata MetadataImpl() const override;
+    bool IsEqualToImpl(const IExpr& other) const override;
+    std::unique_ptr<IExpr> CopyImpl() const override;
+    std::string ToStringImpl() const override;
     int Sign() const override;
-    bool IsConstant() const override;
-    bool IsEqualTo(const IExpr& other) const override;
-    std::unique_ptr<IExpr> Copy() const override;
-    std::string ToString() const override;
+    bool HasDirtyChildren() const;
+
+    // Rules of SimplifyImpl in the order they are tried, each of them rewrites this node only
+    static std::span<const Rule<Sum>> Rules();
     
 private:
     std::unique_ptr<IExpr> simplify_FactorOutCoeffs();
@@ -47,13 +61,19 @@ private:
     std::unique_ptr<IExpr> simplify_SimplifyChildren();
     std::unique_ptr<IExpr> simplify_FactorOutTerms();
     std::unique_ptr<IExpr> simplify_AddLikeTerms();
+    std::unique_ptr<IExpr> simplify_AddMatrices();
     virtual std::unique_ptr<IExpr> SimplifyImpl() override;
 
     void Add(std::unique_ptr<IExpr>&& subExpr);
+    void Insert(Term&& term);
+    Term Extract(ValueType::const_iterator it);
+    const Term* Leading() const;
 
 private:
     ConstantType m_constant;
     ValueType m_terms;
+    // Term of the highest rank, nullptr if unknown; its sign is the sign of the sum
+    mutable CacheSlot<const Term*> m_leading = nullptr;
 };
 
 }
\ No newline at end of file
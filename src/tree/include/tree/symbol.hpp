@@ -6,19 +6,29 @@ namespace ezmath::tree {
 
 class Symbol : public BaseExpression {
 public:
+    static constexpr EKind KIND = EKind::Symbol;
+
     Symbol(std::string_view s);
 
     std::string_view Name() const noexcept;
+    // Names get ids below MAX_INTERNED: the first MAX_INTERNED names of the process are interned
+    // to distinct ids in order of first use, later ones share ids chosen by the hash of the name.
+    // The table is global and never shrinks, so it is capped at the number of mask bits.
+    static constexpr uint32_t MAX_INTERNED = 64;
+    static uint32_t Id(std::string_view name);
+    // Bit of the symbol in Metadata::Symbols
+    static uint64_t MaskBit(std::string_view name);
 
-    constexpr bool IsConstant() const override { return false; }
     constexpr int Sign() const override { return 1; }
-    bool IsEqualTo(const IExpr& other) const override;
-    std::unique_ptr<IExpr> Copy() const override;
-    std::string ToString() const override;
 
 private:
     std::unique_ptr<IExpr> SimplifyImpl() override;
     size_t HashImpl() const override;
+    hash::Fingerprint FingerprintImpl() const override;
+    Metadata MetadataImpl() const override;
+    bool IsEqualToImpl(const IExpr& other) const override;
+    std::unique_ptr<IExpr> CopyImpl() const override;
+    std::string ToStringImpl() const override;
     std::string_view m_value;
 };
 
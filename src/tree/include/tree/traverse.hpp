@@ -0,0 +1,82 @@
+#pragma once
+
+#include <tree/visit.hpp>
+#include <vector>
+
+// Walks over trees on explicit stacks, so the depth of a tree is bounded by memory rather than
+// by the call stack. BaseExpression falls back to these walks once nested calls get too deep.
+namespace ezmath::tree::traverse {
+
+// Calls f with every child of expr; the order is fixed for a given node
+template<class F>
+void ForEachChild(const IExpr& expr, F&& f) {
+    Match(expr,
+        [&f](const Sum& sum) {
+            for (const auto& term : sum.GetTerms()) {
+                f(*term.Expression);
+            }
+        },
+        [&f](const Product& product) {
+            for (const auto& mul : product.GetConstants()) {
+                f(*mul.Expression);
+            }
+            for (const auto& mul : product.GetVariables()) {
+                f(*mul.Expression);
+            }
+        },
+        [&f](const Power& power) {
+            f(power.GetBase());
+            f(power.GetExp());
+        },
+        [&f](const Log& log) {
+            f(log.GetArgument());
+        },
+        [&f](const Matrix& matrix) {
+            for (const auto& entry : matrix.GetEntries()) {
+                f(*entry);
+            }
+        },
+        [](const auto&) {});
+}
+
+// Calls visit with every node of the tree, children before their parent. Children of the nodes
+// for which descend is false are skipped, but the nodes themselves are visited.
+template<class Visit, class Descend>
+void PostOrder(const IExpr& root, Visit&& visit, Descend&& descend) {
+    struct Frame {
+        const IExpr* Node;
+        bool Expanded;
+    };
+    std::vector<Frame> stack{{&root, false}};
+    while (!stack.empty()) {
+        auto [node, expanded] = stack.back();
+        if (expanded || !descend(*node)) {
+            stack.pop_back();
+            visit(*node);
+            continue;
+        }
+        stack.back().Expanded = true;
+        ForEachChild(*node, [&stack](const IExpr& child) { stack.push_back({&child, false}); });
+    }
+}
+
+template<class Visit>
+void PostOrder(const IExpr& root, Visit&& visit) {
+    PostOrder(root, std::forward<Visit>(visit), [](const IExpr&) { return true; });
+}
+
+// Calls visit with every node of the tree, parents before their children; the children of a node
+// are skipped if visit returns false for it
+template<class Visit>
+void PreOrder(const IExpr& root, Visit&& visit) {
+    std::vector<const IExpr*> stack{&root};
+    while (!stack.empty()) {
+        const auto* node = stack.back();
+        stack.pop_back();
+        if (visit(*node)) {
+            ForEachChild(*node, [&stack](const IExpr& child) { stack.push_back(&child); });
+        }
+    }
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <tree/log.hpp>
+#include <tree/matrix.hpp>
+#include <tree/number.hpp>
+#include <tree/power.hpp>
+#include <tree/product.hpp>
+#include <tree/sum.hpp>
+#include <tree/symbol.hpp>
+#include <utility>
+
+namespace ezmath::tree {
+
+// Calls visitor with the concrete node type; dispatch is a switch over the node kind.
+template<class F, class E>
+    requires std::is_same_v<std::remove_const_t<E>, IExpr>
+decltype(auto) Visit(F&& visitor, E& expr) {
+    using Kind = IExpr::EKind;
+    switch (expr.Kind()) {
+    case Kind::Number:
+        return std::forward<F>(visitor)(*expr.template As<Number>());
+    case Kind::Symbol:
+        return std::forward<F>(visitor)(*expr.template As<Symbol>());
+    case Kind::Sum:
+        return std::forward<F>(visitor)(*expr.template As<Sum>());
+    case Kind::Product:
+        return std::forward<F>(visitor)(*expr.template As<Product>());
+    case Kind::Power:
+        return std::forward<F>(visitor)(*expr.template As<Power>());
+    case Kind::Matrix:
+        return std::forward<F>(visitor)(*expr.template As<Matrix>());
+    case Kind::Log:
+        return std::forward<F>(visitor)(*expr.template As<Log>());
+    }
+    std::unreachable();
+}
+
+template<class... Fs>
+struct Overloaded : Fs... {
+    using Fs::operator()...;
+};
+
+// Visit with one handler per node type, e.g. Match(expr, [](const Sum&) {...}, [](const auto&) {...})
+template<class E, class... Fs>
+decltype(auto) Match(E& expr, Fs&&... handlers) {
+    return Visit(Overloaded<std::decay_t<Fs>...>{std::forward<Fs>(handlers)...}, expr);
+}
+
+}
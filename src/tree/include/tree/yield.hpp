@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+
+// Cooperative interruption of the simplifier. A step of simplification gets a quantum of rule
+// applications. Once it is used up, nodes that have not started yet refuse to, and nodes whose
+// children were left unfinished return early; all of them stay unsimplified, so the next step
+// continues where the previous one stopped. A node whose children are simplified always runs
+// to the end, which guarantees progress.
+
+namespace ezmath::tree::yield {
+
+namespace detail {
+
+constexpr size_t UNLIMITED = std::numeric_limits<size_t>::max();
+
+inline thread_local size_t budget = UNLIMITED;
+inline thread_local size_t pinned = 0;
+inline thread_local bool requested = false;
+inline thread_local bool interrupted = false;
+
+} // namespace detail
+
+// Uses up one rule application of the quantum
+inline void Consume() noexcept {
+    using namespace detail;
+    if (budget == UNLIMITED || requested) {
+        return;
+    }
+    if (budget == 0) {
+        requested = true;
+    } else {
+        --budget;
+    }
+}
+
+// Whether the simplification has to unwind from this point; once it does, the rest of the step
+// unwinds, except inside pinned rules, which always run to the end
+inline bool Stop() noexcept {
+    using namespace detail;
+    if (pinned > 0) {
+        return false;
+    }
+    if (requested) {
+        interrupted = true;
+    }
+    return interrupted;
+}
+
+// True when nodes unwind unfinished; never inside pinned rules, whose nested nodes are finished
+inline bool Interrupted() noexcept {
+    return detail::interrupted && detail::pinned == 0;
+}
+
+// Rules that rely on nested simplifications being complete run pinned: nothing stops inside them
+class Pin {
+public:
+    Pin() noexcept { ++detail::pinned; }
+    ~Pin() { --detail::pinned; }
+
+    Pin(const Pin&) = delete;
+    Pin& operator=(const Pin&) = delete;
+};
+
+// Limits the simplifications on this thread to about the given number of rule applications
+class Quantum {
+public:
+    explicit Quantum(const size_t rules) noexcept {
+        detail::budget = rules;
+        detail::requested = false;
+        detail::interrupted = false;
+    }
+
+    ~Quantum() {
+        detail::budget = detail::UNLIMITED;
+        detail::requested = false;
+        detail::interrupted = false;
+    }
+
+    Quantum(const Quantum&) = delete;
+    Quantum& operator=(const Quantum&) = delete;
+
+    bool Exhausted() const noexcept { return detail::interrupted; }
+};
+
+}
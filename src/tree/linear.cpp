@@ -0,0 +1,241 @@
+#include <tree/linear.hpp>
+#include <tree/math.hpp>
+#include <algorithm>
+#include <map>
+#include <string>
+
+namespace ezmath::tree {
+
+namespace {
+
+using Integer = BigNum::Integer;
+
+// (pivot * row - row[col] * pivotRow) / previous, where both rows start at the pivot column
+template<class Row>
+Row Combine(const Row& pivotRow, const Row& row, const Integer& previous) {
+    const auto& pivot = pivotRow.front().second;
+    const auto& factor = row.front().second;
+
+    Row res;
+    res.reserve(pivotRow.size() + row.size());
+    auto lhs = std::next(pivotRow.begin());
+    auto rhs = std::next(row.begin());
+    while (lhs != pivotRow.end() || rhs != row.end()) {
+        Integer val;
+        size_t col;
+        if (rhs == row.end() || (lhs != pivotRow.end() && lhs->first < rhs->first)) {
+            col = lhs->first;
+            val = -factor * lhs->second;
+            ++lhs;
+        } else if (lhs == pivotRow.end() || rhs->first < lhs->first) {
+            col = rhs->first;
+            val = pivot * rhs->second;
+            ++rhs;
+        } else {
+            col = lhs->first;
+            val = pivot * rhs->second - factor * lhs->second;
+            ++lhs;
+            ++rhs;
+        }
+        if (val != 0) {
+            res.emplace_back(col, val / previous);
+        }
+    }
+    return res;
+}
+
+}
+
+std::optional<LinearSystem> LinearSystem::FromEquations(const std::span<const Equation> equations) {
+    LinearSystem res;
+    res.m_rows.reserve(equations.size());
+    for (const auto& [lhs, rhs] : equations) {
+        std::unique_ptr<IExpr> expr = math::add(lhs->Copy(), math::negate(rhs->Copy()));
+        math::simplify(expr);
+
+        auto poly = res.m_ring.FromExpr(*expr);
+        if (!poly) {
+            return std::nullopt;
+        }
+        auto row = MakeRow(*poly);
+        if (!row) {
+            return std::nullopt;
+        }
+        res.m_rows.emplace_back(std::move(*row));
+    }
+
+    // Columns go by the names of the unknowns, the ring numbers them in the order of terms in sums
+    std::vector<std::string> names;
+    names.reserve(res.m_ring.Variables());
+    for (size_t var = 0; var < res.m_ring.Variables(); ++var) {
+        if (!res.m_ring.Generator(var).Is<Symbol>()) {
+            return std::nullopt;
+        }
+        names.emplace_back(res.m_ring.Generator(var).ToString());
+        res.m_unknowns.push_back(var);
+    }
+    std::ranges::sort(res.m_unknowns, {}, [&names](const size_t var) { return names[var]; });
+
+    std::vector<size_t> columns(res.m_unknowns.size());
+    for (size_t col = 0; col < columns.size(); ++col) {
+        columns[res.m_unknowns[col]] = col;
+    }
+    for (auto& row : res.m_rows) {
+        for (auto& [col, _] : row) {
+            if (col != RHS) {
+                col = columns[col];
+            }
+        }
+        std::ranges::sort(row, {}, &Row::value_type::first);
+    }
+    return res;
+}
+
+// Columns are the generators of the ring, with the constant last. The row is scaled to coprime integers.
+std::optional<LinearSystem::Row> LinearSystem::MakeRow(const Polynomial& poly) {
+    Integer denominators = 1;
+    for (size_t term = 0; term < poly.Size(); ++term) {
+        denominators = boost::multiprecision::lcm(denominators, poly.Coefficient(term).Decompose().second);
+    }
+
+    Row res;
+    res.reserve(poly.Size());
+    Integer content = 0;
+    for (size_t term = 0; term < poly.Size(); ++term) {
+        const auto exps = poly.Exponents(term);
+        const auto var = std::ranges::find_if(exps, [](const auto exp) { return exp != 0; });
+
+        auto [num, den] = poly.Coefficient(term).Decompose();
+        Integer val = num * (denominators / den);
+        content = boost::multiprecision::gcd(content, val);
+
+        if (var == exps.end()) {
+            res.emplace_back(RHS, -val);
+            continue;
+        }
+        if (*var != 1 || std::any_of(std::next(var), exps.end(), [](const auto exp) { return exp != 0; })) {
+            return std::nullopt;
+        }
+        res.emplace_back(static_cast<size_t>(var - exps.begin()), std::move(val));
+    }
+
+    if (content > 1) {
+        for (auto& [_, val] : res) {
+            val /= content;
+        }
+    }
+    return res;
+}
+
+std::vector<size_t> LinearSystem::Eliminate(std::vector<Row>& rows, const size_t columns) {
+    std::vector<size_t> pivots;
+    Integer previous = 1;
+
+    for (size_t col = 0; col < columns && pivots.size() < rows.size(); ++col) {
+        const auto rank = static_cast<std::ptrdiff_t>(pivots.size());
+
+        // Remaining rows have no entries before col. The sparsest candidate keeps fill-in low.
+        auto best = rows.end();
+        for (auto it = rows.begin() + rank; it != rows.end(); ++it) {
+            if (!it->empty() && it->front().first == col && (best == rows.end() || it->size() < best->size())) {
+                best = it;
+            }
+        }
+        if (best == rows.end()) {
+            continue;
+        }
+        std::iter_swap(rows.begin() + rank, best);
+
+        const auto& pivotRow = rows[rank];
+        const Integer pivot = pivotRow.front().second;
+        for (auto it = rows.begin() + rank + 1; it != rows.end(); ++it) {
+            if (!it->empty() && it->front().first == col) {
+                *it = Combine(pivotRow, *it, previous);
+            } else if (pivot != previous) {
+                // the Bareiss update with a zero in the pivot column; the division is still exact
+                for (auto& [_, val] : *it) {
+                    val = val * pivot / previous;
+                }
+            }
+        }
+
+        previous = pivot;
+        pivots.push_back(col);
+    }
+    return pivots;
+}
+
+LinearSystem::Solution LinearSystem::Solve() const {
+    auto rows = m_rows;
+    const auto pivots = Eliminate(rows, Unknowns());
+
+    Solution res;
+    for (size_t row = pivots.size(); row < rows.size(); ++row) {
+        if (!rows[row].empty()) {
+            return res;
+        }
+    }
+    res.Kind = pivots.size() == Unknowns() ? ESolution::Unique : ESolution::Infinite;
+
+    // Every unknown as a combination of the free unknowns and the constant column RHS
+    std::vector<std::map<size_t, BigNum>> values(Unknowns());
+    std::vector<bool> isPivot(Unknowns());
+    for (const auto col : pivots) {
+        isPivot[col] = true;
+    }
+    for (size_t var = 0; var < Unknowns(); ++var) {
+        if (!isPivot[var]) {
+            values[var].emplace(var, 1);
+        }
+    }
+
+    for (size_t row = pivots.size(); row-- > 0;) {
+        auto& value = values[pivots[row]];
+        for (const auto& [col, coef] : std::span{rows[row]}.subspan(1)) {
+            const BigNum factor{BigNum::Rational{coef}};
+            if (col == RHS) {
+                value[RHS] += factor;
+                continue;
+            }
+            for (const auto& [var, val] : values[col]) {
+                value[var] -= factor * val;
+            }
+        }
+        const BigNum pivot{BigNum::Rational{rows[row].front().second}};
+        std::erase_if(value, [](const auto& entry) { return entry.second == 0; });
+        for (auto& [_, val] : value) {
+            val /= pivot;
+        }
+    }
+
+    res.Values.reserve(Unknowns());
+    for (size_t var = 0; var < Unknowns(); ++var) {
+        std::vector<std::unique_ptr<IExpr>> terms;
+        terms.reserve(values[var].size());
+        for (const auto& [col, val] : values[var]) {
+            if (col == RHS) {
+                terms.emplace_back(math::number(val));
+            } else {
+                terms.emplace_back(math::multiply(math::number(val), Unknown(col).Copy()));
+            }
+        }
+        std::unique_ptr<IExpr> value = math::add(std::move(terms));
+        math::simplify(value);
+        res.Values.emplace_back(Unknown(var).Copy(), std::move(value));
+    }
+    return res;
+}
+
+size_t LinearSystem::Unknowns() const noexcept {
+    return m_unknowns.size();
+}
+
+size_t LinearSystem::Equations() const noexcept {
+    return m_rows.size();
+}
+
+const IExpr& LinearSystem::Unknown(const size_t var) const {
+    return m_ring.Generator(m_unknowns[var]);
+}
+
+}
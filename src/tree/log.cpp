@@ -0,0 +1,92 @@
+#include <tree/math.hpp>
+#include <tree/hash_utils.hpp>
+#include <tree/rules.hpp>
+#include <fmt/format.h>
+
+namespace ezmath::tree {
+
+Log::Log(std::unique_ptr<IExpr>&& arg)
+    : BaseExpression{KIND}
+    , m_arg{std::move(arg)}
+{}
+
+Log::~Log() {
+    Release(std::move(m_arg));
+}
+
+const IExpr& Log::GetArgument() const noexcept { return *m_arg; }
+
+std::unique_ptr<IExpr>&& Log::DetachArgument() noexcept {
+    InvalidateMetadata();
+    return std::move(m_arg);
+}
+
+std::unique_ptr<IExpr> Log::simplify_SimplifyChildren() {
+    math::simplify(m_arg);
+    return nullptr;
+}
+
+std::unique_ptr<IExpr> Log::simplify_DegenerateCases() {
+    if (!m_arg->Is<Number>()) {
+        return nullptr;
+    }
+    const auto& value = m_arg->As<Number>()->Value();
+    if (value.Sign() <= 0) {
+        throw exception::CalcException{"logarithm of a non-positive number"};
+    }
+    if (value == 1) {
+        return math::number(0);
+    }
+    return nullptr;
+}
+
+std::span<const Rule<Log>> Log::Rules() {
+    static constexpr std::array<Rule<Log>, 2> rules = {{
+        {"Log::SimplifyChildren", &Log::simplify_SimplifyChildren, true},
+        {"Log::DegenerateCases", &Log::simplify_DegenerateCases}
+    }};
+
+    return rules;
+}
+
+std::unique_ptr<IExpr> Log::SimplifyImpl() {
+    return ApplyRules(*this, Rules());
+}
+
+size_t Log::HashImpl() const {
+    constexpr size_t RANDOM_BASE = 9182663207645341287u;
+    return hash::combine(RANDOM_BASE, m_arg->Hash());
+}
+
+hash::Fingerprint Log::FingerprintImpl() const {
+    constexpr hash::Fingerprint RANDOM_BASE = {4620371966307519671u, 15203399251787453051u};
+    return hash::finalize(hash::absorb(RANDOM_BASE, m_arg->Fingerprint()));
+}
+
+Metadata Log::MetadataImpl() const {
+    Metadata res;
+    res.AddChild(m_arg->Meta());
+    res.Degree = res.IsConstant ? 0 : Metadata::NOT_POLYNOMIAL;
+    return res;
+}
+
+bool Log::HasDirtyChildren() const {
+    return !m_arg->IsSimplified();
+}
+
+bool Log::IsEqualToImpl(const IExpr& other) const {
+    if (Hash() != other.Hash()) {
+        return false;
+    }
+    return other.Is<Log>() && m_arg->IsEqualTo(*other.As<Log>()->m_arg);
+}
+
+std::unique_ptr<IExpr> Log::CopyImpl() const {
+    return math::log(m_arg->Copy());
+}
+
+std::string Log::ToStringImpl() const {
+    return fmt::format("\\ln\\left({}\\right)", m_arg->ToString());
+}
+
+}
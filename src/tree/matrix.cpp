@@ -0,0 +1,629 @@
+#include <tree/math.hpp>
+#include <tree/exception.hpp>
+#include <tree/hash_utils.hpp>
+#include <tree/rules.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <bit>
+#include <optional>
+
+namespace ezmath::tree {
+
+namespace {
+
+using Integer = BigNum::Integer;
+
+// Numeric matrix as integers over a common denominator
+struct IntegerMatrix {
+    std::vector<Integer> Values;
+    Integer Denominator = 1;
+};
+
+IntegerMatrix ToIntegers(const std::span<const BigNum> numbers) {
+    IntegerMatrix res;
+    for (const auto& val : numbers) {
+        res.Denominator = boost::multiprecision::lcm(res.Denominator, boost::multiprecision::denominator(val.GetImpl()));
+    }
+    res.Values.reserve(numbers.size());
+    for (const auto& val : numbers) {
+        res.Values.emplace_back(boost::multiprecision::numerator(val.GetImpl()) * (res.Denominator / boost::multiprecision::denominator(val.GetImpl())));
+    }
+    return res;
+}
+
+BigNum FromFraction(Integer num, Integer den) {
+    if (den == 1) {
+        return BigNum::Rational{std::move(num)};
+    }
+    return BigNum::Backend::Fraction(std::move(num), std::move(den));
+}
+
+size_t MaxBits(const std::span<const Integer> values) {
+    size_t res = 0;
+    for (const auto& val : values) {
+        if (val != 0) {
+            res = std::max<size_t>(res, boost::multiprecision::msb(boost::multiprecision::abs(val)) + 1);
+        }
+    }
+    return res;
+}
+
+// res += lhs * rhs for row-major n x m and m x p matrices. Blocks keep a tile of rhs in cache
+// while a tile of lhs rows reuses it; the innermost loop runs along rows of rhs and res.
+template<class T>
+void MultiplyBlocked(const std::span<const T> lhs, const std::span<const T> rhs, const std::span<T> res,
+                     const size_t n, const size_t m, const size_t p) {
+    constexpr size_t BLOCK = 64;
+    for (size_t i0 = 0; i0 < n; i0 += BLOCK) {
+        const auto i1 = std::min(i0 + BLOCK, n);
+        for (size_t k0 = 0; k0 < m; k0 += BLOCK) {
+            const auto k1 = std::min(k0 + BLOCK, m);
+            for (size_t j0 = 0; j0 < p; j0 += BLOCK) {
+                const auto j1 = std::min(j0 + BLOCK, p);
+                for (size_t i = i0; i < i1; ++i) {
+                    for (size_t k = k0; k < k1; ++k) {
+                        const auto& factor = lhs[i * m + k];
+                        if (factor == 0) {
+                            continue;
+                        }
+                        for (size_t j = j0; j < j1; ++j) {
+                            res[i * p + j] += factor * rhs[k * p + j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Product of integer matrices; small entries are multiplied as machine words
+std::vector<Integer> MultiplyIntegers(const std::span<const Integer> lhs, const std::span<const Integer> rhs,
+                                      const size_t n, const size_t m, const size_t p) {
+    if (MaxBits(lhs) + MaxBits(rhs) + std::bit_width(m) < 63) {
+        const auto toWords = [](const std::span<const Integer> values) {
+            std::vector<int64_t> res;
+            res.reserve(values.size());
+            for (const auto& val : values) {
+                res.emplace_back(val.convert_to<int64_t>());
+            }
+            return res;
+        };
+        const auto lhsWords = toWords(lhs);
+        const auto rhsWords = toWords(rhs);
+        std::vector<int64_t> words(n * p);
+        MultiplyBlocked<int64_t>(lhsWords, rhsWords, words, n, m, p);
+        return {words.begin(), words.end()};
+    }
+
+    std::vector<Integer> res(n * p);
+    MultiplyBlocked<Integer>(lhs, rhs, res, n, m, p);
+    return res;
+}
+
+// Bareiss elimination of an n x n integer matrix in place: the divisions are exact
+Integer BareissDeterminant(std::vector<Integer>& values, const size_t n) {
+    Integer previous = 1;
+    bool negate = false;
+    for (size_t k = 0; k < n; ++k) {
+        size_t pivot = k;
+        while (pivot < n && values[pivot * n + k] == 0) {
+            ++pivot;
+        }
+        if (pivot == n) {
+            return 0;
+        }
+        if (pivot != k) {
+            std::swap_ranges(values.begin() + pivot * n, values.begin() + (pivot + 1) * n, values.begin() + k * n);
+            negate = !negate;
+        }
+        for (size_t i = k + 1; i < n; ++i) {
+            for (size_t j = k + 1; j < n; ++j) {
+                values[i * n + j] = (values[k * n + k] * values[i * n + j] - values[i * n + k] * values[k * n + j]) / previous;
+            }
+        }
+        previous = values[k * n + k];
+    }
+    return negate ? Integer{-previous} : previous;
+}
+
+// Fraction-free Gauss-Jordan elimination of [values | I]. The left half ends up as det * I and
+// the right half as the adjugate times the sign of the row permutation. nullopt if singular.
+std::optional<std::pair<std::vector<Integer>, Integer>> AdjugateIntegers(const std::span<const Integer> values, const size_t n) {
+    const auto width = 2 * n;
+    std::vector<Integer> aug(n * width);
+    for (size_t i = 0; i < n; ++i) {
+        std::copy_n(values.begin() + i * n, n, aug.begin() + i * width);
+        aug[i * width + n + i] = 1;
+    }
+
+    Integer previous = 1;
+    for (size_t k = 0; k < n; ++k) {
+        size_t pivot = k;
+        while (pivot < n && aug[pivot * width + k] == 0) {
+            ++pivot;
+        }
+        if (pivot == n) {
+            return std::nullopt;
+        }
+        if (pivot != k) {
+            std::swap_ranges(aug.begin() + pivot * width, aug.begin() + (pivot + 1) * width, aug.begin() + k * width);
+        }
+
+        const Integer diagonal = aug[k * width + k];
+        for (size_t i = 0; i < n; ++i) {
+            if (i == k) {
+                continue;
+            }
+            const Integer factor = aug[i * width + k];
+            for (size_t j = 0; j < width; ++j) {
+                if (j != k) {
+                    aug[i * width + j] = (diagonal * aug[i * width + j] - factor * aug[k * width + j]) / previous;
+                }
+            }
+            aug[i * width + k] = 0;
+        }
+        previous = diagonal;
+    }
+
+    std::vector<Integer> adjugate(n * n);
+    for (size_t i = 0; i < n; ++i) {
+        std::move(aug.begin() + i * width + n, aug.begin() + (i + 1) * width, adjugate.begin() + i * n);
+    }
+    return std::pair{std::move(adjugate), std::move(previous)};
+}
+
+// Bareiss over polynomials; nullptr if an entry is not a polynomial
+std::unique_ptr<IExpr> PolynomialDeterminant(const std::span<const IExpr* const> entries, const size_t n) {
+    PolynomialRing ring;
+    std::vector<Polynomial> values;
+    values.reserve(entries.size());
+    for (const auto* entry : entries) {
+        auto poly = ring.FromExpr(*entry);
+        if (!poly) {
+            return nullptr;
+        }
+        values.emplace_back(std::move(*poly));
+    }
+
+    auto previous = Polynomial::Constant(0, 1);
+    bool negate = false;
+    for (size_t k = 0; k < n; ++k) {
+        size_t pivot = k;
+        while (pivot < n && values[pivot * n + k].IsZero()) {
+            ++pivot;
+        }
+        if (pivot == n) {
+            return math::number(0);
+        }
+        if (pivot != k) {
+            std::swap_ranges(values.begin() + pivot * n, values.begin() + (pivot + 1) * n, values.begin() + k * n);
+            negate = !negate;
+        }
+        for (size_t i = k + 1; i < n; ++i) {
+            for (size_t j = k + 1; j < n; ++j) {
+                auto quotient = (values[k * n + k] * values[i * n + j] - values[i * n + k] * values[k * n + j]).DivideExact(previous);
+                if (!quotient) {
+                    return nullptr;
+                }
+                values[i * n + j] = std::move(*quotient);
+            }
+        }
+        previous = values[k * n + k];
+    }
+    return ring.ToExpr(negate ? -previous : previous);
+}
+
+// Laplace expansion along the first row, for entries which are not polynomials
+std::unique_ptr<IExpr> CofactorDeterminant(const std::span<const IExpr* const> entries, const size_t n) {
+    if (n == 1) {
+        return entries.front()->Copy();
+    }
+    std::vector<std::unique_ptr<IExpr>> terms;
+    terms.reserve(n);
+    std::vector<const IExpr*> minor((n - 1) * (n - 1));
+    for (size_t col = 0; col < n; ++col) {
+        for (size_t i = 1; i < n; ++i) {
+            for (size_t j = 0, out = 0; j < n; ++j) {
+                if (j != col) {
+                    minor[(i - 1) * (n - 1) + out++] = entries[i * n + j];
+                }
+            }
+        }
+        std::unique_ptr<IExpr> term = math::multiply(entries[col]->Copy(), CofactorDeterminant(minor, n - 1));
+        terms.emplace_back(col % 2 ? math::negate(std::move(term)) : std::move(term));
+    }
+    return math::add(std::move(terms));
+}
+
+std::unique_ptr<IExpr> SymbolicDeterminant(const std::span<const IExpr* const> entries, const size_t n) {
+    if (n == 0) {
+        return math::number(1);
+    }
+    auto res = PolynomialDeterminant(entries, n);
+    if (!res) {
+        res = CofactorDeterminant(entries, n);
+    }
+    math::simplify(res);
+    return res;
+}
+
+}
+
+Matrix::Matrix(const size_t rows, const size_t cols, Entries&& entries)
+    : BaseExpression{KIND}
+    , m_rows{rows}
+    , m_cols{cols}
+    , m_entries{std::move(entries)}
+{
+    if (std::get<Entries>(m_entries).size() != rows * cols) {
+        throw exception::CalcException{"matrix entries do not match its size"};
+    }
+}
+
+Matrix::Matrix(const size_t rows, const size_t cols, Numbers&& numbers)
+    : BaseExpression{KIND}
+    , m_rows{rows}
+    , m_cols{cols}
+    , m_entries{std::move(numbers)}
+{
+    if (std::get<Numbers>(m_entries).size() != rows * cols) {
+        throw exception::CalcException{"matrix entries do not match its size"};
+    }
+}
+
+Matrix::~Matrix() {
+    if (auto* entries = std::get_if<Entries>(&m_entries)) {
+        for (auto& entry : *entries) {
+            Release(std::move(entry));
+        }
+    }
+}
+
+std::unique_ptr<Matrix> Matrix::Identity(const size_t size) {
+    Numbers numbers(size * size);
+    for (size_t i = 0; i < size; ++i) {
+        numbers[i * size + i] = 1;
+    }
+    return std::make_unique<Matrix>(size, size, std::move(numbers));
+}
+
+size_t Matrix::Rows() const noexcept { return m_rows; }
+
+size_t Matrix::Cols() const noexcept { return m_cols; }
+
+bool Matrix::IsNumeric() const noexcept { return std::holds_alternative<Numbers>(m_entries); }
+
+std::span<const BigNum> Matrix::GetNumbers() const { return std::get<Numbers>(m_entries); }
+
+std::span<const std::unique_ptr<IExpr>> Matrix::GetEntries() const noexcept {
+    if (const auto* entries = std::get_if<Entries>(&m_entries)) {
+        return *entries;
+    }
+    return {};
+}
+
+std::unique_ptr<IExpr> Matrix::Entry(const size_t row, const size_t col) const {
+    if (IsNumeric()) {
+        return math::number(GetNumbers()[row * m_cols + col]);
+    }
+    return std::get<Entries>(m_entries)[row * m_cols + col]->Copy();
+}
+
+void Matrix::CheckSquare(const std::string_view operation) const {
+    if (m_rows != m_cols) {
+        throw exception::CalcException{fmt::format("{} of a non-square {}x{} matrix", operation, m_rows, m_cols)};
+    }
+}
+
+std::unique_ptr<Matrix> Matrix::Add(const Matrix& other) const {
+    if (m_rows != other.m_rows || m_cols != other.m_cols) {
+        throw exception::CalcException{fmt::format("cannot add {}x{} and {}x{} matrices", m_rows, m_cols, other.m_rows, other.m_cols)};
+    }
+    if (IsNumeric() && other.IsNumeric()) {
+        Numbers numbers{GetNumbers().begin(), GetNumbers().end()};
+        for (size_t i = 0; i < numbers.size(); ++i) {
+            numbers[i] += other.GetNumbers()[i];
+        }
+        return std::make_unique<Matrix>(m_rows, m_cols, std::move(numbers));
+    }
+
+    Entries entries;
+    entries.reserve(m_rows * m_cols);
+    for (size_t i = 0; i < m_rows; ++i) {
+        for (size_t j = 0; j < m_cols; ++j) {
+            std::unique_ptr<IExpr> entry = math::add(Entry(i, j), other.Entry(i, j));
+            math::simplify(entry);
+            entries.emplace_back(std::move(entry));
+        }
+    }
+    return std::make_unique<Matrix>(m_rows, m_cols, std::move(entries));
+}
+
+std::unique_ptr<Matrix> Matrix::Scale(const IExpr& factor) const {
+    if (IsNumeric() && factor.Is<Number>()) {
+        Numbers numbers{GetNumbers().begin(), GetNumbers().end()};
+        for (auto& val : numbers) {
+            val *= factor.As<Number>()->Value();
+        }
+        return std::make_unique<Matrix>(m_rows, m_cols, std::move(numbers));
+    }
+
+    Entries entries;
+    entries.reserve(m_rows * m_cols);
+    for (size_t i = 0; i < m_rows; ++i) {
+        for (size_t j = 0; j < m_cols; ++j) {
+            std::unique_ptr<IExpr> entry = math::multiply(factor.Copy(), Entry(i, j));
+            math::simplify(entry);
+            entries.emplace_back(std::move(entry));
+        }
+    }
+    return std::make_unique<Matrix>(m_rows, m_cols, std::move(entries));
+}
+
+std::unique_ptr<Matrix> Matrix::Multiply(const Matrix& other) const {
+    if (m_cols != other.m_rows) {
+        throw exception::CalcException{fmt::format("cannot multiply {}x{} and {}x{} matrices", m_rows, m_cols, other.m_rows, other.m_cols)};
+    }
+    if (IsNumeric() && other.IsNumeric()) {
+        const auto lhs = ToIntegers(GetNumbers());
+        const auto rhs = ToIntegers(other.GetNumbers());
+        auto product = MultiplyIntegers(lhs.Values, rhs.Values, m_rows, m_cols, other.m_cols);
+
+        const Integer denominator = lhs.Denominator * rhs.Denominator;
+        Numbers numbers;
+        numbers.reserve(product.size());
+        for (auto& val : product) {
+            numbers.emplace_back(FromFraction(std::move(val), denominator));
+        }
+        return std::make_unique<Matrix>(m_rows, other.m_cols, std::move(numbers));
+    }
+
+    Entries entries;
+    entries.reserve(m_rows * other.m_cols);
+    for (size_t i = 0; i < m_rows; ++i) {
+        for (size_t j = 0; j < other.m_cols; ++j) {
+            std::vector<std::unique_ptr<IExpr>> terms;
+            terms.reserve(m_cols);
+            for (size_t k = 0; k < m_cols; ++k) {
+                terms.emplace_back(math::multiply(Entry(i, k), other.Entry(k, j)));
+            }
+            std::unique_ptr<IExpr> entry = math::add(std::move(terms));
+            math::simplify(entry);
+            entries.emplace_back(std::move(entry));
+        }
+    }
+    return std::make_unique<Matrix>(m_rows, other.m_cols, std::move(entries));
+}
+
+std::unique_ptr<Matrix> Matrix::Pow(const BigNum& exp) const {
+    CheckSquare("power");
+    if (!exp.IsInteger()) {
+        throw exception::CalcException{"matrix exponent must be an integer"};
+    }
+    if (exp.Sign() < 0) {
+        return Inverse()->Pow(-exp);
+    }
+    if (exp > std::numeric_limits<uint32_t>::max()) {
+        throw exception::CalcException{"unable to exponentiate"};
+    }
+
+    auto res = Identity(m_rows);
+    std::unique_ptr<Matrix> base = Clone();
+    for (auto n = exp.GetImpl().convert_to<uint32_t>(); n > 0; n >>= 1) {
+        if (n & 1) {
+            res = res->Multiply(*base);
+        }
+        if (n > 1) {
+            base = base->Multiply(*base);
+        }
+    }
+    return res;
+}
+
+std::unique_ptr<IExpr> Matrix::Determinant() const {
+    CheckSquare("determinant");
+    if (IsNumeric()) {
+        auto integers = ToIntegers(GetNumbers());
+        auto det = BareissDeterminant(integers.Values, m_rows);
+        return math::number(FromFraction(std::move(det), boost::multiprecision::pow(integers.Denominator, static_cast<unsigned>(m_rows))));
+    }
+
+    std::vector<const IExpr*> entries;
+    entries.reserve(m_rows * m_cols);
+    for (const auto& entry : std::get<Entries>(m_entries)) {
+        entries.emplace_back(entry.get());
+    }
+    return SymbolicDeterminant(entries, m_rows);
+}
+
+std::unique_ptr<Matrix> Matrix::Inverse() const {
+    CheckSquare("inverse");
+    if (IsNumeric()) {
+        const auto integers = ToIntegers(GetNumbers());
+        auto adjugate = AdjugateIntegers(integers.Values, m_rows);
+        if (!adjugate) {
+            throw exception::CalcException{"matrix is singular"};
+        }
+        // values = A * denominator, so A^-1 = denominator * adjugate / det
+        auto& [values, det] = *adjugate;
+        Numbers numbers;
+        numbers.reserve(values.size());
+        for (auto& val : values) {
+            numbers.emplace_back(BigNum::Backend::Fraction(val * integers.Denominator, det));
+        }
+        return std::make_unique<Matrix>(m_rows, m_cols, std::move(numbers));
+    }
+
+    const auto det = Determinant();
+    if (det->Is<Number>() && det->As<Number>()->Value() == 0) {
+        throw exception::CalcException{"matrix is singular"};
+    }
+
+    const auto& all = std::get<Entries>(m_entries);
+    const auto n = m_rows;
+    Entries entries(n * n);
+    std::vector<const IExpr*> minor((n - 1) * (n - 1));
+    for (size_t row = 0; row < n; ++row) {
+        for (size_t col = 0; col < n; ++col) {
+            for (size_t i = 0, outRow = 0; i < n; ++i) {
+                if (i == row) {
+                    continue;
+                }
+                for (size_t j = 0, outCol = 0; j < n; ++j) {
+                    if (j != col) {
+                        minor[outRow * (n - 1) + outCol++] = all[i * n + j].get();
+                    }
+                }
+                ++outRow;
+            }
+            std::unique_ptr<IExpr> cofactor = math::multiply(SymbolicDeterminant(minor, n - 1), math::inverse(det->Copy()));
+            if ((row + col) % 2) {
+                cofactor = math::negate(std::move(cofactor));
+            }
+            math::cancel(cofactor);
+            entries[col * n + row] = std::move(cofactor);
+        }
+    }
+    return std::make_unique<Matrix>(n, n, std::move(entries));
+}
+
+std::unique_ptr<IExpr> Matrix::simplify_SimplifyChildren() {
+    if (auto* entries = std::get_if<Entries>(&m_entries)) {
+        for (auto& entry : *entries) {
+            math::simplify(entry);
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<IExpr> Matrix::simplify_NumericEntries() {
+    const auto* entries = std::get_if<Entries>(&m_entries);
+    if (!entries || !std::ranges::all_of(*entries, [](const auto& entry) { return entry->template Is<Number>(); })) {
+        return nullptr;
+    }
+    Numbers numbers;
+    numbers.reserve(entries->size());
+    for (const auto& entry : *entries) {
+        numbers.emplace_back(entry->As<Number>()->Value());
+    }
+    m_entries = std::move(numbers);
+    return nullptr;
+}
+
+std::unique_ptr<IExpr> Matrix::SimplifyImpl() {
+    static constexpr std::array<Rule<Matrix>, 2> simplifyRules = {{
+        {"Matrix::SimplifyChildren", &Matrix::simplify_SimplifyChildren, true},
+        {"Matrix::NumericEntries", &Matrix::simplify_NumericEntries}
+    }};
+
+    return ApplyRules(*this, simplifyRules);
+}
+
+// Entries hash like the numbers they are, so both representations of a matrix agree
+size_t Matrix::HashImpl() const {
+    constexpr size_t RANDOM_BASE = 7329861204856106717u;
+    auto res = hash::combine(RANDOM_BASE, m_rows, m_cols);
+    if (IsNumeric()) {
+        for (const auto& val : GetNumbers()) {
+            res = hash::combine(res, Number{val}.Hash());
+        }
+        return res;
+    }
+    for (const auto& entry : std::get<Entries>(m_entries)) {
+        res = hash::combine(res, entry->Hash());
+    }
+    return res;
+}
+
+hash::Fingerprint Matrix::FingerprintImpl() const {
+    constexpr hash::Fingerprint RANDOM_BASE = {16097353364541628417u, 4613127364917264989u};
+    auto res = hash::absorb(RANDOM_BASE, m_rows, m_cols);
+    if (IsNumeric()) {
+        for (const auto& val : GetNumbers()) {
+            res = hash::absorb(res, val.Fingerprint());
+        }
+    } else {
+        for (const auto& entry : std::get<Entries>(m_entries)) {
+            res = hash::absorb(res, entry->Fingerprint());
+        }
+    }
+    return hash::finalize(res);
+}
+
+Metadata Matrix::MetadataImpl() const {
+    Metadata res;
+    if (const auto* entries = std::get_if<Entries>(&m_entries)) {
+        for (const auto& entry : *entries) {
+            res.AddChild(entry->Meta());
+        }
+    } else {
+        res.Size = Metadata::Saturate(uint64_t{res.Size} + m_rows * m_cols);
+        res.Depth = 2;
+    }
+    res.Degree = res.IsConstant ? 0 : Metadata::NOT_POLYNOMIAL;
+    return res;
+}
+
+bool Matrix::HasDirtyChildren() const {
+    const auto* entries = std::get_if<Entries>(&m_entries);
+    return entries && std::ranges::any_of(*entries, [](const auto& entry) { return !entry->IsSimplified(); });
+}
+
+bool Matrix::IsEqualToImpl(const IExpr& other) const {
+    if (Hash() != other.Hash() || !other.Is<Matrix>()) {
+        return false;
+    }
+    const auto* matrix = other.As<Matrix>();
+    if (m_rows != matrix->m_rows || m_cols != matrix->m_cols) {
+        return false;
+    }
+    if (IsNumeric() && matrix->IsNumeric()) {
+        return std::ranges::equal(GetNumbers(), matrix->GetNumbers());
+    }
+    if (!IsNumeric() && !matrix->IsNumeric()) {
+        return std::ranges::equal(GetEntries(), matrix->GetEntries(), [](const auto& lhs, const auto& rhs) { return lhs->IsEqualTo(*rhs); });
+    }
+    for (size_t i = 0; i < m_rows; ++i) {
+        for (size_t j = 0; j < m_cols; ++j) {
+            if (!Entry(i, j)->IsEqualTo(*matrix->Entry(i, j))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<Matrix> Matrix::Clone() const {
+    if (IsNumeric()) {
+        return std::make_unique<Matrix>(m_rows, m_cols, Numbers{GetNumbers().begin(), GetNumbers().end()});
+    }
+    Entries entries;
+    entries.reserve(m_rows * m_cols);
+    for (const auto& entry : std::get<Entries>(m_entries)) {
+        entries.emplace_back(entry->Copy());
+    }
+    return std::make_unique<Matrix>(m_rows, m_cols, std::move(entries));
+}
+
+std::unique_ptr<IExpr> Matrix::CopyImpl() const {
+    return Clone();
+}
+
+std::string Matrix::ToStringImpl() const {
+    std::string res = "\\begin{pmatrix}";
+    for (size_t i = 0; i < m_rows; ++i) {
+        if (i > 0) {
+            res.append("\\\\");
+        }
+        for (size_t j = 0; j < m_cols; ++j) {
+            if (j > 0) {
+                res.push_back('&');
+            }
+            res.append(Entry(i, j)->ToString());
+        }
+    }
+    res.append("\\end{pmatrix}");
+    return res;
+}
+
+}
@@ -5,7 +5,8 @@
 namespace ezmath::tree {
 
 Number::Number(bigint val)
-    : m_value{std::move(val)}
+    : BaseExpression{KIND}
+    , m_value{std::move(val)}
 {}
 
 Number::Number(int64_t val)
@@ -21,11 +22,19 @@ size_t Number::HashImpl() const {
     return hash::combine(RANDOM_BASE, m_value.Hash());
 }
 
+hash::Fingerprint Number::FingerprintImpl() const {
+    return m_value.Fingerprint();
+}
+
+Metadata Number::MetadataImpl() const {
+    return {};
+}
+
 int Number::Sign() const {
     return m_value.Sign();
 }
 
-bool Number::IsEqualTo(const IExpr& other) const {
+bool Number::IsEqualToImpl(const IExpr& other) const {
     if (Hash() != other.Hash()) {
         return false;
     }
@@ -38,11 +47,11 @@ Number::bigint&& Number::DetachValue() noexcept {
     return std::move(m_value);
 }
 
-std::unique_ptr<IExpr> Number::Copy() const {
+std::unique_ptr<IExpr> Number::CopyImpl() const {
     return math::number(m_value);
 }
 
-std::string Number::ToString() const {
+std::string Number::ToStringImpl() const {
     return m_value.ToString();
 }
 
@@ -0,0 +1,761 @@
+#include <tree/polynomial.hpp>
+#include <tree/dense_polynomial.hpp>
+#include <tree/exception.hpp>
+#include <tree/math.hpp>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace ezmath::tree {
+
+namespace {
+
+using Exponent = Polynomial::Exponent;
+
+int CompareMonomials(const std::span<const Exponent> lhs, const std::span<const Exponent> rhs) {
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i] != rhs[i]) {
+            return lhs[i] < rhs[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+BigNum Floor(const BigNum& value) {
+    return value.Numerator().DivMod(value.Denominator()).first;
+}
+
+BigNum MaxNorm(const Polynomial& poly) {
+    BigNum res = 0;
+    for (size_t i = 0; i < poly.Size(); ++i) {
+        res = std::max(res, poly.Coefficient(i).Abs());
+    }
+    return res;
+}
+
+std::optional<size_t> FindVariable(const Polynomial& lhs, const Polynomial& rhs, const bool last) {
+    std::optional<size_t> res;
+    for (size_t var = 0; var < lhs.Variables(); ++var) {
+        if (lhs.Degree(var) || rhs.Degree(var)) {
+            res = var;
+            if (!last) {
+                break;
+            }
+        }
+    }
+    return res;
+}
+
+// Remainder of a pseudo-division of univariate polynomials given by coefficients (index is the degree).
+// The remainder is correct up to a factor from the coefficient ring.
+std::vector<Polynomial> PseudoRemainder(std::vector<Polynomial> lhs, const std::vector<Polynomial>& rhs) {
+    const auto& lcRhs = rhs.back();
+    while (lhs.size() >= rhs.size()) {
+        const auto lcLhs = lhs.back();
+        const auto shift = lhs.size() - rhs.size();
+        for (auto& coef : lhs) {
+            coef = coef * lcRhs;
+        }
+        for (size_t i = 0; i < rhs.size(); ++i) {
+            lhs[i + shift] = lhs[i + shift] - lcLhs * rhs[i];
+        }
+        while (!lhs.empty() && lhs.back().IsZero()) {
+            lhs.pop_back();
+        }
+    }
+    return lhs;
+}
+
+} // namespace
+
+Polynomial::Polynomial(const size_t variables)
+    : m_variables{variables}
+{}
+
+Polynomial Polynomial::Constant(const size_t variables, BigNum value) {
+    Polynomial res{variables};
+    if (value != 0) {
+        res.m_exponents.resize(variables, 0);
+        res.m_coefficients.emplace_back(std::move(value));
+    }
+    return res;
+}
+
+Polynomial Polynomial::Variable(const size_t variables, const size_t var, const Exponent exp) {
+    auto res = Constant(variables, 1);
+    res.m_exponents[var] = exp;
+    return res;
+}
+
+size_t Polynomial::Variables() const noexcept { return m_variables; }
+
+size_t Polynomial::Size() const noexcept { return m_coefficients.size(); }
+
+std::span<const Polynomial::Exponent> Polynomial::Exponents(const size_t term) const {
+    return {m_exponents.data() + term * m_variables, m_variables};
+}
+
+const BigNum& Polynomial::Coefficient(const size_t term) const { return m_coefficients[term]; }
+
+const BigNum& Polynomial::LeadingCoefficient() const { return m_coefficients.front(); }
+
+bool Polynomial::IsZero() const noexcept { return m_coefficients.empty(); }
+
+bool Polynomial::IsConstant() const noexcept {
+    return IsZero() || (Size() == 1 && std::ranges::all_of(Exponents(0), [](auto exp) { return exp == 0; }));
+}
+
+Polynomial::Exponent Polynomial::Degree(const size_t var) const {
+    Exponent res = 0;
+    if (var >= m_variables) {
+        return res;
+    }
+    for (size_t i = 0; i < Size(); ++i) {
+        res = std::max(res, m_exponents[i * m_variables + var]);
+    }
+    return res;
+}
+
+void Polynomial::Extend(const size_t variables) {
+    if (variables <= m_variables) {
+        return;
+    }
+    std::vector<Exponent> exponents(Size() * variables, 0);
+    for (size_t i = 0; i < Size(); ++i) {
+        std::ranges::copy(Exponents(i), exponents.begin() + i * variables);
+    }
+    m_exponents = std::move(exponents);
+    m_variables = variables;
+}
+
+void Polynomial::PushTerm(const std::span<const Exponent> exps, BigNum coef) {
+    m_exponents.insert(m_exponents.end(), exps.begin(), exps.end());
+    m_coefficients.emplace_back(std::move(coef));
+}
+
+void Polynomial::Normalize() {
+    std::vector<size_t> order(Size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::sort(order, [this](size_t a, size_t b) { return CompareMonomials(Exponents(a), Exponents(b)) > 0; });
+
+    Polynomial res{m_variables};
+    res.m_exponents.reserve(m_exponents.size());
+    res.m_coefficients.reserve(Size());
+    for (size_t i = 0; i < order.size();) {
+        auto coef = std::move(m_coefficients[order[i]]);
+        size_t j = i + 1;
+        for (; j < order.size() && CompareMonomials(Exponents(order[i]), Exponents(order[j])) == 0; ++j) {
+            coef += m_coefficients[order[j]];
+        }
+        if (coef != 0) {
+            res.PushTerm(Exponents(order[i]), std::move(coef));
+        }
+        i = j;
+    }
+    *this = std::move(res);
+}
+
+Polynomial Polynomial::Merge(const Polynomial& lhs, const Polynomial& rhs, const int sign) {
+    if (lhs.m_variables != rhs.m_variables) {
+        auto lhsExt = lhs;
+        auto rhsExt = rhs;
+        lhsExt.Extend(rhs.m_variables);
+        rhsExt.Extend(lhs.m_variables);
+        return Merge(lhsExt, rhsExt, sign);
+    }
+
+    Polynomial res{lhs.m_variables};
+    res.m_exponents.reserve(lhs.m_exponents.size() + rhs.m_exponents.size());
+    res.m_coefficients.reserve(lhs.Size() + rhs.Size());
+
+    size_t i = 0, j = 0;
+    while (i < lhs.Size() && j < rhs.Size()) {
+        const auto cmp = CompareMonomials(lhs.Exponents(i), rhs.Exponents(j));
+        if (cmp > 0) {
+            res.PushTerm(lhs.Exponents(i), lhs.m_coefficients[i]);
+            ++i;
+        } else if (cmp < 0) {
+            res.PushTerm(rhs.Exponents(j), sign > 0 ? rhs.m_coefficients[j] : -rhs.m_coefficients[j]);
+            ++j;
+        } else {
+            auto coef = sign > 0
+                ? lhs.m_coefficients[i] + rhs.m_coefficients[j]
+                : lhs.m_coefficients[i] - rhs.m_coefficients[j];
+            if (coef != 0) {
+                res.PushTerm(lhs.Exponents(i), std::move(coef));
+            }
+            ++i, ++j;
+        }
+    }
+    for (; i < lhs.Size(); ++i) {
+        res.PushTerm(lhs.Exponents(i), lhs.m_coefficients[i]);
+    }
+    for (; j < rhs.Size(); ++j) {
+        res.PushTerm(rhs.Exponents(j), sign > 0 ? rhs.m_coefficients[j] : -rhs.m_coefficients[j]);
+    }
+    return res;
+}
+
+Polynomial Polynomial::MultiplyByTerm(const std::span<const Exponent> exps, const BigNum& coef) const {
+    Polynomial res{m_variables};
+    if (coef == 0) {
+        return res;
+    }
+    res.m_exponents = m_exponents;
+    res.m_coefficients.reserve(Size());
+    for (size_t i = 0; i < Size(); ++i) {
+        for (size_t var = 0; var < m_variables; ++var) {
+            res.m_exponents[i * m_variables + var] += exps[var];
+        }
+        res.m_coefficients.emplace_back(m_coefficients[i] * coef);
+    }
+    return res;
+}
+
+Polynomial Polynomial::operator-() const {
+    return *this * BigNum{-1};
+}
+
+Polynomial Polynomial::operator+(const Polynomial& other) const {
+    return Merge(*this, other, 1);
+}
+
+Polynomial Polynomial::operator-(const Polynomial& other) const {
+    return Merge(*this, other, -1);
+}
+
+Polynomial Polynomial::operator*(const Polynomial& other) const {
+    if (m_variables != other.m_variables) {
+        auto lhs = *this;
+        auto rhs = other;
+        lhs.Extend(other.m_variables);
+        rhs.Extend(m_variables);
+        return lhs * rhs;
+    }
+    if (other.Size() == 1) {
+        return MultiplyByTerm(other.Exponents(0), other.m_coefficients[0]);
+    }
+    if (Size() == 1) {
+        return other.MultiplyByTerm(Exponents(0), m_coefficients[0]);
+    }
+    // Long univariate factors without large gaps are multiplied as coefficient vectors
+    const auto isDense = [](const Polynomial& poly) {
+        return poly.Size() >= DENSE_MIN_TERMS && poly.Degree(0) < DENSE_MAX_GAP * poly.Size();
+    };
+    if (m_variables == 1 && isDense(*this) && isDense(other)) {
+        return (*DensePolynomial::FromSparse(*this) * *DensePolynomial::FromSparse(other)).ToSparse();
+    }
+
+    Polynomial res{m_variables};
+    res.m_exponents.resize(Size() * other.Size() * m_variables);
+    res.m_coefficients.reserve(Size() * other.Size());
+
+    auto out = res.m_exponents.begin();
+    for (size_t i = 0; i < Size(); ++i) {
+        const auto lhsExps = Exponents(i);
+        for (size_t j = 0; j < other.Size(); ++j) {
+            out = std::transform(lhsExps.begin(), lhsExps.end(), other.Exponents(j).begin(), out, std::plus{});
+            res.m_coefficients.emplace_back(m_coefficients[i] * other.m_coefficients[j]);
+        }
+    }
+    res.Normalize();
+    return res;
+}
+
+Polynomial Polynomial::operator*(const BigNum& value) const {
+    std::vector<Exponent> zero(m_variables, 0);
+    return MultiplyByTerm(zero, value);
+}
+
+bool Polynomial::operator==(const Polynomial& other) const {
+    if (m_variables != other.m_variables) {
+        return (*this - other).IsZero();
+    }
+    return m_coefficients == other.m_coefficients && m_exponents == other.m_exponents;
+}
+
+Polynomial Polynomial::Pow(Exponent exp) const {
+    auto res = Constant(m_variables, 1);
+    auto base = *this;
+    while (exp) {
+        if (exp & 1) {
+            res = res * base;
+        }
+        exp >>= 1;
+        if (exp) {
+            base = base * base;
+        }
+    }
+    return res;
+}
+
+std::optional<Polynomial> Polynomial::DivideExact(const Polynomial& divisor) const {
+    if (divisor.IsZero()) {
+        throw exception::CalcException{"division by zero"};
+    }
+    if (m_variables != divisor.m_variables) {
+        auto lhs = *this;
+        auto rhs = divisor;
+        lhs.Extend(divisor.m_variables);
+        rhs.Extend(m_variables);
+        return lhs.DivideExact(rhs);
+    }
+
+    Polynomial quotient{m_variables};
+    auto remainder = *this;
+    std::vector<Exponent> shift(m_variables);
+    const auto divisorLead = divisor.Exponents(0);
+
+    while (!remainder.IsZero()) {
+        const auto remainderLead = remainder.Exponents(0);
+        for (size_t var = 0; var < m_variables; ++var) {
+            if (remainderLead[var] < divisorLead[var]) {
+                return std::nullopt;
+            }
+            shift[var] = remainderLead[var] - divisorLead[var];
+        }
+        auto coef = remainder.m_coefficients[0] / divisor.m_coefficients[0];
+        remainder = remainder - divisor.MultiplyByTerm(shift, coef);
+        quotient.PushTerm(shift, std::move(coef));
+    }
+    return quotient;
+}
+
+BigNum Polynomial::Content() const {
+    if (IsZero()) {
+        return 0;
+    }
+    auto res = m_coefficients.front();
+    for (const auto& coef : m_coefficients) {
+        res = BigNum::Gcd(res, coef);
+    }
+    res = res.Abs();
+    return LeadingCoefficient().Sign() < 0 ? -res : res;
+}
+
+Polynomial Polynomial::PrimitivePart() const {
+    if (IsZero()) {
+        return *this;
+    }
+    return *this * (BigNum{1} / Content());
+}
+
+std::vector<Polynomial> Polynomial::CoefficientsIn(const size_t var) const {
+    std::vector<Polynomial> res(Degree(var) + 1, Polynomial{m_variables});
+    std::vector<Exponent> exps(m_variables);
+    for (size_t i = 0; i < Size(); ++i) {
+        std::ranges::copy(Exponents(i), exps.begin());
+        if (var >= m_variables) {
+            res[0].PushTerm(exps, m_coefficients[i]);
+            continue;
+        }
+        const auto degree = std::exchange(exps[var], 0);
+        // Zeroing a single position keeps terms of equal degree sorted
+        res[degree].PushTerm(exps, m_coefficients[i]);
+    }
+    return res;
+}
+
+Polynomial Polynomial::FromCoefficients(std::vector<Polynomial>&& coefs, const size_t var) {
+    const auto variables = coefs.empty() ? var + 1 : std::max(coefs.front().m_variables, var + 1);
+    Polynomial res{variables};
+    std::vector<Exponent> exps(variables, 0);
+    for (size_t degree = 0; degree < coefs.size(); ++degree) {
+        coefs[degree].Extend(variables);
+        exps[var] = static_cast<Exponent>(degree);
+        res = res + coefs[degree].MultiplyByTerm(exps, 1);
+    }
+    return res;
+}
+
+Polynomial Polynomial::ContentIn(const size_t var) const {
+    Polynomial res{m_variables};
+    for (const auto& coef : CoefficientsIn(var)) {
+        if (coef.IsZero()) {
+            continue;
+        }
+        res = res.IsZero() ? coef.PrimitivePart() : Gcd(res, coef);
+        if (res.IsConstant()) {
+            break;
+        }
+    }
+    return res;
+}
+
+Polynomial Polynomial::Evaluate(const size_t var, const BigNum& value) const {
+    Polynomial res{m_variables};
+    if (var >= m_variables) {
+        return *this;
+    }
+
+    std::vector<BigNum> powers{1};
+    std::vector<Exponent> exps(m_variables);
+    for (size_t i = 0; i < Size(); ++i) {
+        std::ranges::copy(Exponents(i), exps.begin());
+        const auto degree = std::exchange(exps[var], 0);
+        while (powers.size() <= degree) {
+            powers.emplace_back(powers.back() * value);
+        }
+        res.PushTerm(exps, m_coefficients[i] * powers[degree]);
+    }
+    res.Normalize();
+    return res;
+}
+
+Polynomial Polynomial::Interpolate(Polynomial image, const BigNum& xi, const size_t var) {
+    const auto halfXi = xi.DivMod(2).first;
+    const auto xiInv = BigNum{1} / xi;
+
+    Polynomial res{std::max(image.m_variables, var + 1)};
+    std::vector<Exponent> shift(res.m_variables, 0);
+    for (Exponent degree = 0; !image.IsZero(); ++degree) {
+        Polynomial digit{image.m_variables};
+        for (size_t i = 0; i < image.Size(); ++i) {
+            auto remainder = image.m_coefficients[i].DivMod(xi).second;
+            if (remainder > halfXi) {
+                remainder -= xi;
+            }
+            if (remainder != 0) {
+                digit.PushTerm(image.Exponents(i), std::move(remainder));
+            }
+        }
+        image = (image - digit) * xiInv;
+
+        digit.Extend(res.m_variables);
+        shift[var] = degree;
+        res = res + digit.MultiplyByTerm(shift, 1);
+    }
+    return res;
+}
+
+Polynomial Polynomial::Gcd(const Polynomial& lhs, const Polynomial& rhs) {
+    if (lhs.IsZero()) {
+        return rhs.PrimitivePart();
+    }
+    if (rhs.IsZero()) {
+        return lhs.PrimitivePart();
+    }
+    auto lhsExt = lhs.PrimitivePart();
+    auto rhsExt = rhs.PrimitivePart();
+    lhsExt.Extend(rhs.m_variables);
+    rhsExt.Extend(lhs.m_variables);
+    return PrimitiveGcd(lhsExt, rhsExt);
+}
+
+Polynomial Polynomial::IntegerGcd(const Polynomial& lhs, const Polynomial& rhs) {
+    if (lhs.IsZero() || rhs.IsZero()) {
+        const auto& res = lhs.IsZero() ? rhs : lhs;
+        return res.LeadingCoefficient().Sign() < 0 ? -res : res;
+    }
+    const auto lhsContent = lhs.Content().Abs();
+    const auto rhsContent = rhs.Content().Abs();
+    const auto content = BigNum::Gcd(lhsContent, rhsContent);
+    return PrimitiveGcd(lhs * (BigNum{1} / lhsContent), rhs * (BigNum{1} / rhsContent)) * content;
+}
+
+Polynomial Polynomial::PrimitiveGcd(const Polynomial& lhs, const Polynomial& rhs) {
+    if (lhs.IsConstant() || rhs.IsConstant()) {
+        return Constant(lhs.m_variables, 1);
+    }
+    const auto normalize = [](const Polynomial& poly) {
+        return poly.LeadingCoefficient().Sign() < 0 ? -poly : poly;
+    };
+    if (lhs.Size() == rhs.Size() && normalize(lhs) == normalize(rhs)) {
+        return normalize(lhs);
+    }
+    if (auto res = HeuristicGcd(lhs, rhs)) {
+        return std::move(*res);
+    }
+    return PrsGcd(lhs, rhs);
+}
+
+// Heuristic gcd (Char, Geddes, Gonnet): evaluate the last variable at a large integer,
+// compute the gcd of the images recursively and interpolate it back xi-adically.
+std::optional<Polynomial> Polynomial::HeuristicGcd(const Polynomial& lhs, const Polynomial& rhs) {
+    constexpr int ATTEMPTS = 6;
+    // bounded backends keep the images of small inputs in range
+    using IntegerLimits = std::numeric_limits<BigNum::Integer>;
+    static const BigNum XI_LIMIT = BigNum{10}.Pow(IntegerLimits::is_bounded ? IntegerLimits::digits10 / 4 : 300);
+
+    const auto var = *FindVariable(lhs, rhs, true);
+
+    const auto lhsNorm = MaxNorm(lhs);
+    const auto rhsNorm = MaxNorm(rhs);
+    const auto bound = BigNum{2} * std::min(lhsNorm, rhsNorm) + 29;
+
+    auto xi = std::max(
+        std::min(bound, BigNum{99} * bound.Sqrt()),
+        BigNum{2} * std::min(Floor(lhsNorm / lhs.LeadingCoefficient().Abs()), Floor(rhsNorm / rhs.LeadingCoefficient().Abs())) + 2);
+
+    for (int attempt = 0; attempt < ATTEMPTS && xi < XI_LIMIT; ++attempt) {
+        auto lhsImage = lhs.Evaluate(var, xi);
+        auto rhsImage = rhs.Evaluate(var, xi);
+
+        if (!lhsImage.IsZero() && !rhsImage.IsZero()) {
+            auto candidate = Interpolate(IntegerGcd(lhsImage, rhsImage), xi, var).PrimitivePart();
+            candidate.Extend(lhs.m_variables);
+            if (!candidate.IsZero() && lhs.DivideExact(candidate) && rhs.DivideExact(candidate)) {
+                return candidate;
+            }
+        }
+        xi = Floor(BigNum{73794} * xi * xi.Sqrt().Sqrt() / 27011);
+    }
+    return std::nullopt;
+}
+
+// Primitive polynomial remainder sequence in the first variable with recursive contents
+Polynomial Polynomial::PrsGcd(const Polynomial& lhs, const Polynomial& rhs) {
+    const auto var = *FindVariable(lhs, rhs, false);
+
+    if (lhs.Degree(var) == 0) {
+        return Gcd(lhs, rhs.ContentIn(var));
+    }
+    if (rhs.Degree(var) == 0) {
+        return Gcd(rhs, lhs.ContentIn(var));
+    }
+
+    const auto lhsContent = lhs.ContentIn(var);
+    const auto rhsContent = rhs.ContentIn(var);
+    const auto content = Gcd(lhsContent, rhsContent);
+
+    auto a = lhs.DivideExact(lhsContent)->CoefficientsIn(var);
+    auto b = rhs.DivideExact(rhsContent)->CoefficientsIn(var);
+    if (a.size() < b.size()) {
+        std::swap(a, b);
+    }
+
+    while (true) {
+        auto remainder = PseudoRemainder(std::move(a), b);
+        if (remainder.empty()) {
+            break;
+        }
+        if (remainder.size() == 1) {
+            b = {Constant(lhs.m_variables, 1)};
+            break;
+        }
+        auto poly = FromCoefficients(std::move(remainder), var);
+        a = std::move(b);
+        b = poly.DivideExact(poly.ContentIn(var))->PrimitivePart().CoefficientsIn(var);
+    }
+
+    auto res = FromCoefficients(std::move(b), var) * content;
+    res.Extend(lhs.m_variables);
+    return res.PrimitivePart();
+}
+
+RationalFunction RationalFunction::Inverse() const {
+    if (Numerator.IsZero()) {
+        throw exception::CalcException{"division by zero"};
+    }
+    return {Denominator, Numerator};
+}
+
+RationalFunction RationalFunction::Pow(const Polynomial::Exponent exp) const {
+    return {Numerator.Pow(exp), Denominator.Pow(exp)};
+}
+
+RationalFunction RationalFunction::operator+(const RationalFunction& other) const {
+    if (Denominator == other.Denominator) {
+        return {Numerator + other.Numerator, Denominator};
+    }
+    return {Numerator * other.Denominator + other.Numerator * Denominator, Denominator * other.Denominator};
+}
+
+RationalFunction RationalFunction::operator*(const RationalFunction& other) const {
+    return {Numerator * other.Numerator, Denominator * other.Denominator};
+}
+
+bool RationalFunction::Cancel() {
+    bool cancelled = false;
+    if (Numerator.IsZero()) {
+        Denominator = Polynomial::Constant(Denominator.Variables(), 1);
+        return cancelled;
+    }
+
+    if (!Denominator.IsConstant()) {
+        const auto gcd = Polynomial::Gcd(Numerator, Denominator);
+        if (!gcd.IsConstant()) {
+            Numerator = *Numerator.DivideExact(gcd);
+            Denominator = *Denominator.DivideExact(gcd);
+            cancelled = true;
+        }
+    }
+
+    const auto content = BigNum{1} / Denominator.Content();
+    Numerator = Numerator * content;
+    Denominator = Denominator * content;
+    return cancelled;
+}
+
+std::optional<Polynomial> PolynomialRing::FromExpr(const IExpr& expr, const size_t maxTerms) {
+    const auto checked = [maxTerms](Polynomial&& poly) -> std::optional<Polynomial> {
+        if (poly.Size() > maxTerms) {
+            return std::nullopt;
+        }
+        return std::move(poly);
+    };
+
+    if (expr.Is<Number>()) {
+        return Polynomial::Constant(Variables(), expr.As<Number>()->Value());
+    }
+
+    if (expr.Is<Sum>()) {
+        auto sum = expr.As<Sum>();
+        auto res = Polynomial::Constant(Variables(), sum->GetConstant());
+        for (const auto& term : sum->GetTerms()) {
+            auto poly = FromExpr(*term.Expression, maxTerms);
+            if (!poly || !(poly = checked(res + *poly))) {
+                return std::nullopt;
+            }
+            res = std::move(*poly);
+        }
+        return res;
+    }
+
+    if (expr.Is<Product>()) {
+        auto product = expr.As<Product>();
+        auto res = Polynomial::Constant(Variables(), product->GetCoefficient());
+        for (const auto* part : {&product->GetConstants(), &product->GetVariables()}) {
+            for (const auto& mul : *part) {
+                auto poly = FromExpr(*mul.Expression, maxTerms);
+                if (!poly || !(poly = checked(res * *poly))) {
+                    return std::nullopt;
+                }
+                res = std::move(*poly);
+            }
+        }
+        return res;
+    }
+
+    if (expr.Is<Power>() && expr.As<Power>()->GetExp().Is<Number>()) {
+        const auto& exp = expr.As<Power>()->GetExp().As<Number>()->Value();
+        if (exp.IsInteger() && exp.Sign() > 0 && exp <= MAX_EXPONENT) {
+            auto base = FromExpr(expr.As<Power>()->GetBase(), maxTerms);
+            if (!base) {
+                return std::nullopt;
+            }
+            // A univariate power has no more terms than its degree, so only the result is checked
+            if (base->Variables() <= 1) {
+                return checked(base->Pow(exp.GetImpl().convert_to<Polynomial::Exponent>()));
+            }
+            auto res = *base;
+            for (auto power = exp - 1; power > 0; power -= 1) {
+                auto next = checked(res * *base);
+                if (!next) {
+                    return std::nullopt;
+                }
+                res = std::move(*next);
+            }
+            return res;
+        }
+    }
+
+    const auto var = AddGenerator(expr);
+    return Polynomial::Variable(Variables(), var);
+}
+
+std::unique_ptr<IExpr> PolynomialRing::ToExpr(const Polynomial& poly) const {
+    return math::add(ToTerms(poly));
+}
+
+std::vector<std::unique_ptr<IExpr>> PolynomialRing::ToTerms(const Polynomial& poly) const {
+    std::vector<std::unique_ptr<IExpr>> terms;
+    terms.reserve(poly.Size());
+    for (size_t i = 0; i < poly.Size(); ++i) {
+        std::vector<std::unique_ptr<IExpr>> multipliers;
+        multipliers.emplace_back(math::number(poly.Coefficient(i)));
+
+        const auto exps = poly.Exponents(i);
+        for (size_t var = 0; var < exps.size(); ++var) {
+            if (exps[var] == 0) {
+                continue;
+            }
+            auto generator = m_generators[var]->Copy();
+            multipliers.emplace_back(exps[var] == 1
+                ? std::move(generator)
+                : math::exp(std::move(generator), math::number(static_cast<int64_t>(exps[var]))));
+        }
+        terms.emplace_back(math::multiply(std::move(multipliers)));
+    }
+    return terms;
+}
+
+std::optional<RationalFunction> PolynomialRing::FromRational(const IExpr& expr, const size_t maxTerms) {
+    const auto checked = [maxTerms](RationalFunction&& func) -> std::optional<RationalFunction> {
+        if (func.Numerator.Size() > maxTerms || func.Denominator.Size() > maxTerms) {
+            return std::nullopt;
+        }
+        return std::move(func);
+    };
+    const auto one = [this] { return Polynomial::Constant(Variables(), 1); };
+
+    if (expr.Is<Sum>()) {
+        auto sum = expr.As<Sum>();
+        RationalFunction res{Polynomial::Constant(Variables(), sum->GetConstant()), one()};
+        for (const auto& term : sum->GetTerms()) {
+            auto func = FromRational(*term.Expression, maxTerms);
+            if (!func || !(func = checked(res + *func))) {
+                return std::nullopt;
+            }
+            res = std::move(*func);
+        }
+        return res;
+    }
+
+    if (expr.Is<Product>()) {
+        auto product = expr.As<Product>();
+        RationalFunction res{Polynomial::Constant(Variables(), product->GetCoefficient()), one()};
+        for (const auto* part : {&product->GetConstants(), &product->GetVariables()}) {
+            for (const auto& mul : *part) {
+                auto func = FromRational(*mul.Expression, maxTerms);
+                if (!func || !(func = checked(res * *func))) {
+                    return std::nullopt;
+                }
+                res = std::move(*func);
+            }
+        }
+        return res;
+    }
+
+    if (expr.Is<Power>() && expr.As<Power>()->GetExp().Is<Number>()) {
+        const auto& exp = expr.As<Power>()->GetExp().As<Number>()->Value();
+        if (exp.IsInteger() && exp.Sign() < 0 && -exp <= MAX_EXPONENT) {
+            auto base = FromRational(expr.As<Power>()->GetBase(), maxTerms);
+            if (!base || base->Numerator.IsZero()) {
+                return std::nullopt;
+            }
+            return checked(base->Inverse().Pow((-exp).GetImpl().convert_to<Polynomial::Exponent>()));
+        }
+    }
+
+    auto poly = FromExpr(expr, maxTerms);
+    if (!poly) {
+        return std::nullopt;
+    }
+    return RationalFunction{std::move(*poly), one()};
+}
+
+std::unique_ptr<IExpr> PolynomialRing::ToExpr(const RationalFunction& func) const {
+    if (func.Denominator.IsConstant()) {
+        return math::multiply(ToExpr(func.Numerator), math::number(BigNum{1} / func.Denominator.LeadingCoefficient()));
+    }
+    return math::multiply(ToExpr(func.Numerator), math::inverse(ToExpr(func.Denominator)));
+}
+
+size_t PolynomialRing::Variables() const noexcept { return m_generators.size(); }
+
+const IExpr& PolynomialRing::Generator(const size_t var) const { return *m_generators[var]; }
+
+size_t PolynomialRing::AddGenerator(const IExpr& expr) {
+    const auto hash = expr.Hash();
+    for (auto [it, end] = m_index.equal_range(hash); it != end; ++it) {
+        if (m_generators[it->second]->IsEqualTo(expr)) {
+            return it->second;
+        }
+    }
+    m_generators.emplace_back(expr.Copy());
+    m_index.emplace(hash, m_generators.size() - 1);
+    return m_generators.size() - 1;
+}
+
+}
@@ -1,11 +1,14 @@
 #include <tree/math.hpp>
 #include <tree/hash_utils.hpp>
+#include <tree/rules.hpp>
 #include <fmt/format.h>
+#include <algorithm>
 
 namespace ezmath::tree {
 
 Power::Power(std::unique_ptr<IExpr>&& base, std::unique_ptr<IExpr>&& exp)
-    : m_base{std::move(base)}
+    : BaseExpression{KIND}
+    , m_base{std::move(base)}
     , m_exp{std::move(exp)}
 {
     if (m_base->Is<Power>()) {
@@ -14,13 +17,24 @@ Power::Power(std::unique_ptr<IExpr>&& base, std::unique_ptr<IExpr>&& exp)
     }
 }
 
+Power::~Power() {
+    Release(std::move(m_base));
+    Release(std::move(m_exp));
+}
+
 const IExpr& Power::GetBase() const noexcept { return *m_base; }
 
 const IExpr& Power::GetExp() const noexcept { return *m_exp; }
 
-std::unique_ptr<IExpr>&& Power::DetachBase() noexcept { return std::move(m_base); }
+std::unique_ptr<IExpr>&& Power::DetachBase() noexcept {
+    InvalidateMetadata();
+    return std::move(m_base);
+}
 
-std::unique_ptr<IExpr>&& Power::DetachExp() noexcept { return std::move(m_exp); }
+std::unique_ptr<IExpr>&& Power::DetachExp() noexcept {
+    InvalidateMetadata();
+    return std::move(m_exp);
+}
 
 std::unique_ptr<IExpr> Power::simplify_ProductBase() {
     if (!(m_base->Is<Product>() && m_exp->Is<Number>() && m_exp->As<Number>()->Value().IsInteger())) {
@@ -51,12 +65,67 @@ std::unique_ptr<IExpr> Power::simplify_ProductBase() {
     return res;
 }
 
+namespace {
+
+bool HasDenominator(const IExpr& expr) {
+    if (expr.Is<Product>()) {
+        auto product = expr.As<Product>();
+        for (const auto* part : {&product->GetConstants(), &product->GetVariables()}) {
+            for (const auto& mul : *part) {
+                if (HasDenominator(*mul.Expression)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    return expr.Is<Power>() && expr.As<Power>()->GetExp().Is<Number>() && expr.As<Power>()->GetExp().Sign() == -1;
+}
+
+}
+
+// 1/(a/b+c/d) as a single fraction of polynomials. Inside a product this is done by
+// Product::CancelFractions, which a lone power never reaches.
+std::unique_ptr<IExpr> Power::simplify_CancelFractions() {
+    if (!(m_base->Is<Sum>() && m_exp->Is<Number>() && m_exp->Sign() == -1 && m_exp->As<Number>()->Value().IsInteger())) {
+        return nullptr;
+    }
+    const auto& terms = m_base->As<Sum>()->GetTerms();
+    if (std::ranges::none_of(terms, [](const auto& term) { return HasDenominator(*term.Expression); })) {
+        return nullptr;
+    }
+
+    PolynomialRing ring;
+    auto func = ring.FromRational(*this);
+    if (!func) {
+        return nullptr;
+    }
+    func->Cancel();
+
+    std::unique_ptr<IExpr> res = ring.ToExpr(*func);
+    math::simplify(res);
+    return res;
+}
+
 std::unique_ptr<IExpr> Power::simplify_SimplifyChildren() {
     math::simplify(m_base);
     math::simplify(m_exp);
     return nullptr;
 }
 
+// Matrices are raised to integer powers by repeated squaring, negative ones through the inverse
+std::unique_ptr<IExpr> Power::simplify_MatrixBase() {
+    if (!m_base->Is<Matrix>()) {
+        return nullptr;
+    }
+    if (!(m_exp->Is<Number>() && m_exp->As<Number>()->Value().IsInteger())) {
+        throw exception::CalcException{"matrix exponent must be an integer"};
+    }
+    std::unique_ptr<IExpr> res = m_base->As<Matrix>()->Pow(m_exp->As<Number>()->Value());
+    math::simplify(res);
+    return res;
+}
+
 std::unique_ptr<IExpr> extractInteger(std::unique_ptr<IExpr>& base, const BigNum& exp) {
     auto num = boost::multiprecision::numerator(exp.GetImpl());
     auto den = boost::multiprecision::denominator(exp.GetImpl());
@@ -105,11 +174,12 @@ std::optional<BigNum::Integer> intRtImpl(const BigNum::Integer& base, const BigN
     BigNum::Integer rb = base;
 
     while (lb < rb - 1) {
-        auto m = (rb - lb) / 2;
+        // Evaluated here: an expression template would be recomputed from the updated bounds
+        const BigNum::Integer m = lb + (rb - lb) / 2;
         auto cmp = base.compare(boost::multiprecision::pow(m, n));
         switch (cmp) {
             case -1: rb = m; break;
-            case 0: rb = m; return BigNum::Integer{m};
+            case 0: return m;
             case 1: lb = m; break;
         }
     }
@@ -118,7 +188,7 @@ std::optional<BigNum::Integer> intRtImpl(const BigNum::Integer& base, const BigN
 
 std::unique_ptr<IExpr> intPow(const BigNum& base, const BigNum& exp) {
     auto intBase = base.GetImpl().convert_to<BigNum::Integer>();
-    auto numerator = boost::multiprecision::numerator(exp.GetImpl()) * exp.Sign();
+    BigNum::Integer numerator = boost::multiprecision::numerator(exp.GetImpl()) * exp.Sign();
     auto denominator = boost::multiprecision::denominator(exp.GetImpl());
 
     auto step1 = intRtImpl(intBase, denominator);
@@ -128,7 +198,7 @@ std::unique_ptr<IExpr> intPow(const BigNum& base, const BigNum& exp) {
     auto step2 = intPowImpl(*step1, numerator);
 
     if (exp.Sign() == -1) {
-        return math::number(BigNum::Rational{1, step2});
+        return math::number(BigNum::Backend::Fraction(1, std::move(step2)));
     }
     return math::number(step2.convert_to<BigNum::Rational>());
 }
@@ -203,19 +273,20 @@ std::unique_ptr<IExpr> Power::simplify_DegenerateCases() {
     return nullptr;
 }
 
+std::span<const Rule<Power>> Power::Rules() {
+    static constexpr std::array<Rule<Power>, 5> rules = {{
+        {"Power::SimplifyChildren", &Power::simplify_SimplifyChildren, true},
+        {"Power::MatrixBase", &Power::simplify_MatrixBase},
+        {"Power::ProductBase", &Power::simplify_ProductBase},
+        {"Power::CancelFractions", &Power::simplify_CancelFractions},
+        {"Power::DegenerateCases", &Power::simplify_DegenerateCases}
+    }};
+
+    return rules;
+}
+
 std::unique_ptr<IExpr> Power::SimplifyImpl() {
-    decltype(&Power::SimplifyImpl) simplifyRules[] = {
-        &Power::simplify_SimplifyChildren,
-        &Power::simplify_ProductBase,
-        &Power::simplify_DegenerateCases
-    };
-
-    for (auto rule : simplifyRules) {
-        if (auto res = (*this.*rule)()) {
-            return res;
-        }
-    }
-    return nullptr;
+    return ApplyRules(*this, Rules());
 }
 
 size_t Power::HashImpl() const {
@@ -223,11 +294,34 @@ size_t Power::HashImpl() const {
     return hash::combine(RANDOM_BASE, m_base->Hash(), m_exp->Hash());
 }
 
-bool Power::IsConstant() const {
-    return m_base->IsConstant() && m_exp->IsConstant();
+hash::Fingerprint Power::FingerprintImpl() const {
+    constexpr hash::Fingerprint RANDOM_BASE = {12562934126312519281u, 2401633385127795371u};
+    return hash::finalize(hash::absorb(hash::absorb(RANDOM_BASE, m_base->Fingerprint()), m_exp->Fingerprint()));
+}
+
+Metadata Power::MetadataImpl() const {
+    Metadata res;
+    const auto base = m_base->Meta();
+    res.AddChild(base);
+    res.AddChild(m_exp->Meta());
+    if (res.IsConstant) {
+        res.Degree = 0;
+    } else if (m_exp->Is<Number>() && m_exp->As<Number>()->Value().IsInteger() && m_exp->Sign() >= 0
+            && base.Degree != Metadata::NOT_POLYNOMIAL) {
+        const auto& exp = m_exp->As<Number>()->Value();
+        res.Degree = exp > Metadata::NOT_POLYNOMIAL ? Metadata::NOT_POLYNOMIAL - 1
+            : Metadata::Saturate(uint64_t{base.Degree} * exp.Decompose().first.convert_to<uint64_t>());
+    } else {
+        res.Degree = Metadata::NOT_POLYNOMIAL;
+    }
+    return res;
+}
+
+bool Power::HasDirtyChildren() const {
+    return !m_base->IsSimplified() || !m_exp->IsSimplified();
 }
 
-bool Power::IsEqualTo(const IExpr& other) const {
+bool Power::IsEqualToImpl(const IExpr& other) const {
     if (Hash() != other.Hash()) {
         return false;
     }
@@ -236,11 +330,11 @@ bool Power::IsEqualTo(const IExpr& other) const {
         && m_exp->IsEqualTo(*other.As<Power>()->m_exp);
 }
 
-std::unique_ptr<IExpr> Power::Copy() const {
+std::unique_ptr<IExpr> Power::CopyImpl() const {
     return math::exp(m_base->Copy(), m_exp->Copy());
 }
 
-std::string Power::ToString() const {
+std::string Power::ToStringImpl() const {
     if (m_exp->Sign() == -1) {
         std::unique_ptr<IExpr> newExp = math::multiply(m_exp->Copy(), math::number(-1));
         math::simplify(newExp);
@@ -1,5 +1,8 @@
 #include <tree/math.hpp>
 #include <tree/hash_utils.hpp>
+#include <tree/polynomial.hpp>
+#include <tree/rules.hpp>
+#include <algorithm>
 #include <ranges>
 #include <unordered_set>
 
@@ -40,14 +43,27 @@ Multiplier::Multiplier(std::unique_ptr<IExpr>&& expression)
 }
 
 Product::Product(std::vector<std::unique_ptr<IExpr>>&& values) 
-    : m_coefficient{1}
+    : BaseExpression{KIND}
+    , m_coefficient{1}
 {
     for (auto& val : values) {
         Add(std::move(val));
     }
 }
 
+Product::~Product() {
+    for (auto* part : {&m_constants, &m_variables}) {
+        while (!part->empty()) {
+            Release(std::move(part->extract(part->begin()).value().Expression));
+        }
+    }
+}
+
 std::unique_ptr<IExpr> Product::simplify_SimplifyChildren() {
+    if (!HasDirtyChildren()) {
+        return nullptr;
+    }
+
     Product res{{}};
     res.m_constants.reserve(m_constants.size());
     res.m_variables.reserve(m_variables.size());
@@ -101,6 +117,12 @@ void MultiplyLikeTerms(Product::ValueType& multipliers,
 }
 
 std::unique_ptr<IExpr> Product::simplify_MultiplyLikeTerms() {
+    // Multipliers with the same base are adjacent in the multiset
+    if (std::adjacent_find(m_constants.begin(), m_constants.end()) == m_constants.end() &&
+        std::adjacent_find(m_variables.begin(), m_variables.end()) == m_variables.end()) {
+        return nullptr;
+    }
+
     Product res{{}};
     res.m_coefficient = std::move(m_coefficient);
     res.m_constants.reserve(m_constants.size());
@@ -126,26 +148,85 @@ std::unique_ptr<IExpr> Product::simplify_DegenerateCases() {
     return nullptr;
 }
 
-std::unique_ptr<IExpr> Product::SimplifyImpl() {
-    decltype(&Product::SimplifyImpl) simplifyRules[] = {
-        &Product::simplify_SimplifyChildren,
-        &Product::simplify_DegenerateCases,
-        &Product::simplify_MultiplyLikeTerms,
-        &Product::simplify_DegenerateCases
-    };
-
-    for (auto rule : simplifyRules) {
-        if (auto res = (*this.*rule)()) {
-            return res;
+// A product holds at most one matrix, whose entries absorb the other factors
+std::unique_ptr<IExpr> Product::simplify_ScaleMatrix() {
+    auto matrix = m_constants.end();
+    for (auto it = m_constants.begin(); it != m_constants.end(); ++it) {
+        if (it->Expression->Is<Matrix>()) {
+            if (matrix != m_constants.end()) {
+                throw exception::CalcException{"matrices must be multiplied in order"};
+            }
+            matrix = it;
         }
     }
-    return nullptr;
+    for (const auto& mul : m_variables) {
+        if (mul.Expression->Is<Matrix>()) {
+            throw exception::CalcException{"matrices must be multiplied in order"};
+        }
+    }
+    if (matrix == m_constants.end()) {
+        return nullptr;
+    }
+
+    auto base = std::move(m_constants.extract(matrix).value().Expression);
+    std::unique_ptr<IExpr> factor = math::multiply();
+    *factor->As<Product>() = std::move(*this);
+    math::simplify(factor);
+    return base->As<Matrix>()->Scale(*factor);
+}
+
+bool IsDenominator(const Multiplier& mul) {
+    const auto& exp = GetExp(mul);
+    return exp.Is<Number>() && exp.As<Number>()->Value().IsInteger() && exp.As<Number>()->Value().Sign() < 0;
+}
+
+// Brings the product to a single fraction of polynomials and divides out their gcd.
+// Without sums every factor is a monomial, and like terms are already multiplied out.
+std::unique_ptr<IExpr> Product::simplify_CancelFractions() {
+    bool hasDenominator = false, hasSum = false;
+    for (const auto* part : {&m_constants, &m_variables}) {
+        for (const auto& mul : *part) {
+            hasDenominator |= IsDenominator(mul);
+            hasSum |= GetBase(mul).Is<Sum>();
+        }
+    }
+    if (!hasDenominator || !hasSum) {
+        return nullptr;
+    }
+
+    PolynomialRing ring;
+    auto func = ring.FromRational(*this);
+    if (!func || !func->Cancel()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<IExpr> res = ring.ToExpr(*func);
+    math::simplify(res);
+    return res;
+}
+
+std::span<const Rule<Product>> Product::Rules() {
+    static constexpr std::array<Rule<Product>, 6> rules = {{
+        {"Product::SimplifyChildren", &Product::simplify_SimplifyChildren, true},
+        {"Product::DegenerateCases", &Product::simplify_DegenerateCases},
+        {"Product::MultiplyLikeTerms", &Product::simplify_MultiplyLikeTerms},
+        {"Product::ScaleMatrix", &Product::simplify_ScaleMatrix},
+        {"Product::CancelFractions", &Product::simplify_CancelFractions},
+        {"Product::DegenerateCases", &Product::simplify_DegenerateCases}
+    }};
+
+    return rules;
+}
+
+std::unique_ptr<IExpr> Product::SimplifyImpl() {
+    return ApplyRules(*this, Rules());
 }
 
 void Product::Add(std::unique_ptr<IExpr>&& subExpr) {
     if (!subExpr) {
         return;
     }
+    InvalidateMetadata();
 
     if (subExpr->Is<Product>()) {
         auto subProduct = subExpr->As<Product>();
@@ -189,31 +270,78 @@ Product::Coefficient&& Product::DetachCoefficient() {
 }
 
 Product::ConstantPart&& Product::DetachConstants() {
+    InvalidateMetadata();
     return std::move(m_constants);
 }
 
 Product::VariablePart&& Product::DetachVariables() {
+    InvalidateMetadata();
     return std::move(m_variables);
 }
 
-size_t Product::HashImpl() const {
-    constexpr size_t RANDOM_BASE1 = 8323215160037385666u;
-    constexpr size_t RANDOM_BASE2 = 6383974336372012507u;
+constexpr size_t RANDOM_BASE1 = 8323215160037385666u;
+constexpr size_t RANDOM_BASE2 = 6383974336372012507u;
 
+size_t Product::HashImpl() const {
     auto hash1 = hash::asymmetric_hash(RANDOM_BASE1, m_constants);
     auto hash2 = hash::asymmetric_hash(RANDOM_BASE2, m_variables);
     return hash::combine(m_coefficient.Hash(), hash1, hash2);
 }
 
-bool Product::IsConstant() const {
-    return m_variables.empty();
+hash::Fingerprint Product::FingerprintImpl() const {
+    constexpr hash::Fingerprint RANDOM_BASE = {1683577437460949313u, 9766321455810390227u};
+    auto res = hash::absorb(RANDOM_BASE, m_coefficient.Fingerprint());
+    res = hash::absorb(res, hash::unordered_fingerprint(m_constants));
+    res = hash::absorb(res, hash::unordered_fingerprint(m_variables));
+    return hash::finalize(res);
+}
+
+// Constant factors have degree 0 even if they are not polynomials, e.g. 2^{1/2}
+Metadata Product::MetadataImpl() const {
+    Metadata res;
+    for (const auto& mul : m_constants) {
+        res.AddChild(mul.Expression->Meta());
+    }
+    uint64_t degree = 0;
+    for (const auto& mul : m_variables) {
+        const auto meta = mul.Expression->Meta();
+        res.AddChild(meta);
+        degree = degree == Metadata::NOT_POLYNOMIAL || meta.Degree == Metadata::NOT_POLYNOMIAL
+            ? Metadata::NOT_POLYNOMIAL
+            : degree + meta.Degree;
+    }
+    res.Degree = degree == Metadata::NOT_POLYNOMIAL ? Metadata::NOT_POLYNOMIAL : Metadata::Saturate(degree);
+    return res;
+}
+
+size_t Product::MonomialHash() const {
+    static const size_t ONE_HASH = Number{1}.Hash();
+    static const size_t ONE_COEFFICIENT_HASH = Coefficient{1}.Hash();
+
+    switch (m_constants.size() + m_variables.size()) {
+    case 0:
+        return ONE_HASH;
+    case 1:
+        return m_constants.empty()
+            ? m_variables.begin()->Expression->Hash()
+            : m_constants.begin()->Expression->Hash();
+    default:
+        auto hash1 = hash::asymmetric_hash(RANDOM_BASE1, m_constants);
+        auto hash2 = hash::asymmetric_hash(RANDOM_BASE2, m_variables);
+        return hash::combine(ONE_COEFFICIENT_HASH, hash1, hash2);
+    }
+}
+
+bool Product::HasDirtyChildren() const {
+    constexpr auto isDirty = [](const auto& mul) { return !mul.Expression->IsSimplified(); };
+    return std::ranges::any_of(m_constants, isDirty) || std::ranges::any_of(m_variables, isDirty);
 }
 
 int Product::Sign() const {
     return m_coefficient.Sign();
 }
 
-bool Product::IsEqualTo(const IExpr& other) const {
+bool Product::IsEqualToImpl(const IExpr& other) const {
     if (Hash() != other.Hash()) {
         return false;
     }
@@ -225,11 +353,11 @@ bool Product::IsEqualTo(const IExpr& other) const {
     auto otherProduct = other.As<Product>();
 
     return m_coefficient == otherProduct->m_coefficient
-        && m_variables == otherProduct->m_variables
-        && m_constants == otherProduct->m_constants;
+        && hash::same_elements(m_variables, otherProduct->m_variables)
+        && hash::same_elements(m_constants, otherProduct->m_constants);
 }
 
-std::unique_ptr<IExpr> Product::Copy() const {
+std::unique_ptr<IExpr> Product::CopyImpl() const {
     constexpr auto copy = [](const auto& val) { return val.Expression->Copy(); };
 
     auto res = math::multiply();
@@ -241,9 +369,7 @@ std::unique_ptr<IExpr> Product::Copy() const {
     return res;
 }
 
-void Product::ToString(std::string& res, const IExpr& add, bool isSingle) const {
-    auto str = add.ToString();
-
+void Product::ToString(std::string& res, const IExpr& add, std::string_view str, bool isSingle) const {
     bool needBrackets = add.Is<Sum>() && !isSingle;
     bool needDelimeter = !needBrackets && !str.empty() && !res.empty() && std::isdigit(str.front());
 
@@ -257,8 +383,9 @@ void Product::ToString(std::string& res, const IExpr& add, bool isSingle) const
 }
 
 std::string Product::ToString(const ValueType& expressions) const {
-    std::vector<std::reference_wrapper<IExpr>> dividend;
+    std::vector<std::pair<std::string, const IExpr*>> dividend;
     std::vector<std::unique_ptr<IExpr>> divisor;
+    std::vector<std::pair<std::string, const IExpr*>> divisorStrs;
 
     if (expressions.empty()) {
         return {};
@@ -269,7 +396,7 @@ std::string Product::ToString(const ValueType& expressions) const {
         decltype(auto) exp = GetExp(val);
 
         if (exp.Sign() == 1) {
-            dividend.emplace_back(*val.Expression);
+            dividend.emplace_back(val.Expression->ToString(), val.Expression.get());
             continue;
         }
 
@@ -278,11 +405,22 @@ std::string Product::ToString(const ValueType& expressions) const {
 
         auto& res = divisor.emplace_back(std::move(newExp));
         math::simplify(res);
+        divisorStrs.emplace_back(res->ToString(), res.get());
     }
 
+    // The order of the factors in the set depends on how it was filled, so equal products are
+    // printed in the order of their factors' text, bracketed sums last
+    const auto printOrder = [](const auto& factor) { return std::pair{factor.second->template Is<Sum>(), std::string_view{factor.first}}; };
+    std::ranges::sort(dividend, {}, printOrder);
+    std::ranges::sort(divisorStrs, {}, printOrder);
+
     std::string dividendStr, divisorStr;
-    std::for_each(dividend.begin(), dividend.end(), [this, &dividendStr, isSingle = (dividend.size() == 1)](const auto& expr){ ToString(dividendStr, expr.get(), isSingle); });
-    std::for_each(divisor.begin(), divisor.end(), [this, &divisorStr, isSingle = (divisor.size() == 1)](const auto& expr){ ToString(divisorStr, *expr, isSingle); });
+    for (const auto& [str, expr] : dividend) {
+        ToString(dividendStr, *expr, str, dividend.size() == 1);
+    }
+    for (const auto& [str, expr] : divisorStrs) {
+        ToString(divisorStr, *expr, str, divisorStrs.size() == 1);
+    }
 
     if (dividendStr.empty()) {
         dividendStr = "1";
@@ -295,7 +433,7 @@ std::string Product::ToString(const ValueType& expressions) const {
     return dividendStr;
 }
 
-std::string Product::ToString() const {
+std::string Product::ToStringImpl() const {
     if (m_constants.empty() && m_variables.empty()) {
         return m_coefficient.ToString();
     }
@@ -315,8 +453,8 @@ std::string Product::ToString() const {
     if (m_coefficient == -1) {
         coef = "-";
     }
-    const auto delimeter1 = !coef.empty() && std::isdigit(constStr.front()) ? " \\cdot " : "";
-    const auto delimeter2 = !(coef.empty() && !constStr.empty()) && std::isdigit(varsStr.front()) ? " \\cdot " : "";    
+    const auto delimeter1 = !coef.empty() && !constStr.empty() && std::isdigit(constStr.front()) ? " \\cdot " : "";
+    const auto delimeter2 = !(coef.empty() && constStr.empty()) && !varsStr.empty() && std::isdigit(varsStr.front()) ? " \\cdot " : "";
     
     return fmt::format("{}{}{}{}{}", coef, delimeter1, constStr, delimeter2, varsStr);
 }
@@ -0,0 +1,77 @@
+#include <tree/stats.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace ezmath::tree::stats {
+
+namespace {
+
+std::atomic<bool> enabled = false;
+
+std::mutex registryMutex;
+std::unordered_map<std::string_view, RuleStats> registry;
+
+} // namespace
+
+void Enable(const bool value) noexcept {
+    enabled.store(Available && value, std::memory_order_relaxed);
+}
+
+bool IsEnabled() noexcept {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+Snapshot TakeSnapshot() {
+    Snapshot res;
+    {
+        std::lock_guard lock{registryMutex};
+        res.reserve(registry.size());
+        for (const auto& [_, rule] : registry) {
+            res.emplace_back(rule);
+        }
+    }
+    std::sort(res.begin(), res.end(), [](const auto& a, const auto& b) { return a.Name < b.Name; });
+    return res;
+}
+
+void Reset() {
+    std::lock_guard lock{registryMutex};
+    registry.clear();
+}
+
+std::string ToJson(const Snapshot& snapshot) {
+    std::string res = "{\"rules\":[";
+    for (const auto& rule : snapshot) {
+        if (res.back() != '[') {
+            res.push_back(',');
+        }
+        res.append(fmt::format(
+            "{{\"name\":\"{}\",\"invocations\":{},\"fired\":{},\"time_ns\":{},\"nodes_allocated\":{},\"nodes_freed\":{}}}",
+            rule.Name, rule.Invocations, rule.Fired, rule.Time.count(), rule.NodesAllocated, rule.NodesFreed));
+    }
+    res.append("]}");
+    return res;
+}
+
+namespace detail {
+
+void Record(const std::string_view rule, const bool fired, const std::chrono::nanoseconds time, const NodeCounters& nodes) {
+    std::lock_guard lock{registryMutex};
+    auto [it, inserted] = registry.try_emplace(rule);
+    auto& stats = it->second;
+    if (inserted) {
+        stats.Name = rule;
+    }
+    ++stats.Invocations;
+    stats.Fired += fired;
+    stats.Time += time;
+    stats.NodesAllocated += nodes.Allocated;
+    stats.NodesFreed += nodes.Freed;
+}
+
+} // namespace detail
+
+} // namespace ezmath::tree::stats
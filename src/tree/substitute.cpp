@@ -0,0 +1,119 @@
+#include <tree/substitute.hpp>
+#include <tree/math.hpp>
+
+namespace ezmath::tree {
+
+namespace {
+
+class Substituter {
+public:
+    Substituter(const Substitution& values, const bool simplify)
+        : m_values{values}
+        , m_simplify{simplify}
+    {
+        for (const auto& [name, value] : m_values) {
+            m_mask |= Symbol::MaskBit(name);
+        }
+    }
+
+    void Apply(std::unique_ptr<IExpr>& expr) const {
+        if (!(expr->Meta().Symbols & m_mask)) {
+            return;
+        }
+
+        switch (expr->Kind()) {
+        case IExpr::EKind::Number:
+            return;
+
+        case IExpr::EKind::Symbol: {
+            const auto it = m_values.find(expr->As<Symbol>()->Name());
+            if (it == m_values.end()) {
+                return;
+            }
+            expr = it->second->Copy();
+            break;
+        }
+
+        case IExpr::EKind::Sum: {
+            auto* sum = expr->As<Sum>();
+            std::vector<std::unique_ptr<IExpr>> terms;
+            terms.emplace_back(math::number(sum->DetachConstant()));
+            auto detached = sum->DetachTerms();
+            while (!detached.empty()) {
+                auto term = std::move(detached.extract(detached.begin()).value().Expression);
+                Apply(term);
+                terms.emplace_back(std::move(term));
+            }
+            expr = math::add(std::move(terms));
+            break;
+        }
+
+        case IExpr::EKind::Product: {
+            auto* product = expr->As<Product>();
+            std::vector<std::unique_ptr<IExpr>> muls;
+            muls.emplace_back(math::number(product->DetachCoefficient()));
+            // Constant factors contain no symbols
+            auto constants = product->DetachConstants();
+            while (!constants.empty()) {
+                muls.emplace_back(std::move(constants.extract(constants.begin()).value().Expression));
+            }
+            auto variables = product->DetachVariables();
+            while (!variables.empty()) {
+                auto mul = std::move(variables.extract(variables.begin()).value().Expression);
+                Apply(mul);
+                muls.emplace_back(std::move(mul));
+            }
+            expr = math::multiply(std::move(muls));
+            break;
+        }
+
+        case IExpr::EKind::Power: {
+            auto* power = expr->As<Power>();
+            auto base = power->DetachBase();
+            auto exp = power->DetachExp();
+            Apply(base);
+            Apply(exp);
+            expr = math::exp(std::move(base), std::move(exp));
+            break;
+        }
+
+        case IExpr::EKind::Log: {
+            auto arg = expr->As<Log>()->DetachArgument();
+            Apply(arg);
+            expr = math::log(std::move(arg));
+            break;
+        }
+
+        case IExpr::EKind::Matrix: {
+            const auto* matrix = expr->As<Matrix>();
+            Matrix::Entries entries;
+            entries.reserve(matrix->Rows() * matrix->Cols());
+            for (size_t row = 0; row < matrix->Rows(); ++row) {
+                for (size_t col = 0; col < matrix->Cols(); ++col) {
+                    entries.emplace_back(matrix->Entry(row, col));
+                    Apply(entries.back());
+                }
+            }
+            expr = math::matrix(matrix->Rows(), matrix->Cols(), std::move(entries));
+            break;
+        }
+        }
+
+        if (m_simplify) {
+            math::simplify(expr);
+        }
+    }
+
+private:
+    const Substitution& m_values;
+    bool m_simplify;
+    uint64_t m_mask = 0;
+};
+
+}
+
+void Substitute(std::unique_ptr<IExpr>& expr, const Substitution& values, const bool simplify) {
+    Substituter{values, simplify}.Apply(expr);
+}
+
+}
@@ -1,11 +1,14 @@
 #include <tree/math.hpp>
 #include <tree/hash_utils.hpp>
+#include <tree/polynomial.hpp>
+#include <tree/rules.hpp>
+#include <algorithm>
 #include <unordered_set>
 #include <ranges>
 
 namespace ezmath::tree {
 
-std::tuple<Number::bigint, std::unique_ptr<Product>, std::unique_ptr<Product>> DecomposeTerm(Term& term) {
+std::tuple<Number::bigint, std::unique_ptr<Product>, std::unique_ptr<Product>> DecomposeTerm(Term&& term) {
     if (!term.Expression->Is<Product>()) {
         if (term.Expression->IsConstant()) {
             return {1, math::multiply(std::move(term.Expression)), math::multiply()};
@@ -39,12 +42,31 @@ std::tuple<Number::bigint, std::unique_ptr<Product>, std::unique_ptr<Product>> D
 Term::Term(std::unique_ptr<IExpr>&& expr) 
     : Expression{std::move(expr)}
 {
+    // A product of a single variable hashes as the variable and one without variables as any
+    // constant, so that a and -a are alike
+    constexpr size_t RANDOM_BASE = 3906861806704847745u;
     if (Expression->Is<Product>()) {
-        constexpr size_t RANDOM_BASE = 3906861806704847745u;
-        Hash = hash::asymmetric_hash(RANDOM_BASE, Expression->As<Product>()->GetVariables());
+        const auto& variables = Expression->As<Product>()->GetVariables();
+        Hash = variables.size() == 1 ? variables.begin()->Expression->Hash() : hash::asymmetric_hash(RANDOM_BASE, variables);
+        Rank = Expression->As<Product>()->MonomialHash();
         return;
     }
-    Hash = Expression->Hash();
+    Rank = Expression->Hash();
+    Hash = Expression->IsConstant() ? RANDOM_BASE : Rank;
+}
+
+// Lower in the order in which the leading term is chosen. Terms of the same rank go by sign,
+// so that the leading term of a negated sum is the negated leading term, and by hash
+bool RanksBelow(const Term& lhs, const Term& rhs) {
+    if (lhs.Rank != rhs.Rank) {
+        return lhs.Rank < rhs.Rank;
+    }
+    const auto lhsSign = lhs.Expression->Sign();
+    const auto rhsSign = rhs.Expression->Sign();
+    if (lhsSign != rhsSign) {
+        return lhsSign < rhsSign;
+    }
+    return lhs.Hash < rhs.Hash;
 }
 
 bool operator==(const Term& lhs, const Term& rhs) { 
@@ -53,11 +75,25 @@ bool operator==(const Term& lhs, const Term& rhs) {
     }
 
     if (lhs.Expression->Is<Product>() != rhs.Expression->Is<Product>()) {
-        return false;
+        // A product is alike with its only variable, or without variables with its only constant
+        const auto& product = *(lhs.Expression->Is<Product>() ? lhs : rhs).Expression->As<Product>();
+        const auto& other = *(lhs.Expression->Is<Product>() ? rhs : lhs).Expression;
+        if (other.IsConstant() && !product.GetVariables().empty()) {
+            return false;
+        }
+        const auto& factors = other.IsConstant() ? product.GetConstants() : product.GetVariables();
+        return factors.size() == 1 && factors.begin()->Expression->IsEqualTo(other);
     }
 
     if (lhs.Expression->Is<Product>()) {
-        return lhs.Expression->As<Product>()->GetVariables() == rhs.Expression->As<Product>()->GetVariables();
+        const auto& lhsProduct = *lhs.Expression->As<Product>();
+        const auto& rhsProduct = *rhs.Expression->As<Product>();
+        if (lhsProduct.GetVariables() != rhsProduct.GetVariables()) {
+            return false;
+        }
+        // Constant terms are alike only with equal constant factors: adding up -2\ln(3) and -\sqrt{2}
+        // as like terms gives back the same sum as their coefficient
+        return !lhsProduct.GetVariables().empty() || lhsProduct.GetConstants() == rhsProduct.GetConstants();
     }
 
     return lhs.Expression->IsEqualTo(*rhs.Expression);
@@ -68,13 +104,20 @@ size_t TermHash::operator()(const Term& term) const {
 }
 
 Sum::Sum(std::vector<std::unique_ptr<IExpr>>&& values) 
-    : m_constant{0}
+    : BaseExpression{KIND}
+    , m_constant{0}
 {
     for (auto& val : values) {
         Add(std::move(val));
     }
 }
 
+Sum::~Sum() {
+    while (!m_terms.empty()) {
+        Release(std::move(m_terms.extract(m_terms.begin()).value().Expression));
+    }
+}
+
 void Sum::Add(std::unique_ptr<IExpr>&& subExpr) {
     if (!subExpr) {
         return;
@@ -88,11 +131,48 @@ void Sum::Add(std::unique_ptr<IExpr>&& subExpr) {
     if (subExpr->Is<Sum>()) {
         auto subSum = subExpr->As<Sum>();
         m_constant += subSum->m_constant;
+
+        // merge moves the nodes, so pointers to them stay valid
+        const auto* leading = subSum->Leading();
+        if (m_terms.empty() || (m_leading && leading && RanksBelow(*m_leading.load(), *leading))) {
+            m_leading = leading;
+        }
         m_terms.merge(subSum->m_terms);
+        subSum->m_leading = nullptr;
         return;
     }
 
-    m_terms.emplace(std::move(subExpr));
+    Insert(std::move(subExpr));
+}
+
+void Sum::Insert(Term&& term) {
+    InvalidateMetadata();
+    const bool first = m_terms.empty();
+    const auto& res = *m_terms.insert(std::move(term));
+    if (first || (m_leading && RanksBelow(*m_leading.load(), res))) {
+        m_leading = &res;
+    }
+}
+
+Term Sum::Extract(const ValueType::const_iterator it) {
+    InvalidateMetadata();
+    if (&*it == m_leading) {
+        m_leading = nullptr;
+    }
+    return std::move(m_terms.extract(it).value());
+}
+
+const Term* Sum::Leading() const {
+    if (m_terms.empty()) {
+        return nullptr;
+    }
+    // concurrent readers of a frozen sum may both compute it, they store the same term
+    const auto* res = m_leading.load(std::memory_order_acquire);
+    if (!res) {
+        res = &*std::ranges::max_element(m_terms, RanksBelow);
+        m_leading.store(res, std::memory_order_release);
+    }
+    return res;
 }
 
 const Sum::ConstantType& Sum::GetConstant() const noexcept {
@@ -108,36 +188,23 @@ Sum::ConstantType&& Sum::DetachConstant() noexcept {
 }
 
 Sum::ValueType&& Sum::DetachTerms() noexcept {
+    InvalidateMetadata();
+    m_leading = nullptr;
     return std::move(m_terms);
 }
 
-bool Sum::IsConstant() const {
-    return std::all_of(m_terms.begin(), m_terms.end(), 
-        [](const auto& val){ return val.Expression->IsConstant(); });
-}
-
 int Sum::Sign() const {
-    const static auto extractHash = [](const std::unique_ptr<IExpr>& exp){
-        if (!exp->Is<Product>()) {
-            return exp->Hash();
-        }
-        auto term = Term{exp->As<Product>()->Copy()};
-        auto [_, l, r] = DecomposeTerm(term);
-        std::unique_ptr<IExpr> tmp = math::multiply(std::move(l), std::move(r));
-        math::simplify(tmp);
-        return tmp->Hash();
-    };
-
-    auto result = std::max_element(m_terms.begin(), m_terms.end(), [](const auto& a, const auto& b) {
-        const size_t aHash = extractHash(a.Expression);
-        const size_t bHash = extractHash(b.Expression);
-        return aHash < bHash;
-    });
+    if (const auto* leading = Leading()) {
+        return leading->Expression->Sign();
+    }
+    return m_constant.Sign();
+}
 
-    return result->Expression->Sign();
+bool Sum::HasDirtyChildren() const {
+    return std::ranges::any_of(m_terms, [](const auto& term) { return !term.Expression->IsSimplified(); });
 }
 
-bool Sum::IsEqualTo(const IExpr& other) const {
+bool Sum::IsEqualToImpl(const IExpr& other) const {
     if (Hash() != other.Hash()) {
         return false;
     }
@@ -147,43 +214,95 @@ bool Sum::IsEqualTo(const IExpr& other) const {
     }
 
     const auto otherSum = other.As<Sum>();
-    return (m_terms == otherSum->m_terms) && (m_constant == otherSum->m_constant);
+    return m_constant == otherSum->m_constant && hash::same_elements(m_terms, otherSum->m_terms);
 }
 
-auto TermToMap(Term& term) {
-    std::unordered_map<Multiplier, Number::bigint, MultiplierHash> res;
-    auto [coef, constPart, varPart] = DecomposeTerm(term);
+using Factors = std::vector<std::pair<const IExpr*, Number::bigint>>;
 
-    auto constPartTmp = constPart->As<Product>()->DetachConstants();
-    while (!constPartTmp.empty()) {
-        auto val = std::move(constPartTmp.extract(constPartTmp.begin()).value());
-        if (GetExp(val).Is<Number>()) {
-            auto [base, exp] = DecomposePower(val);
-            res.emplace(std::move(base), exp->As<Number>()->DetachValue());
-            continue;
+// Base and numeric exponent of a multiplier; powers with non-numeric exponents are opaque bases
+std::pair<const IExpr*, Number::bigint> SplitPower(const IExpr& expr) {
+    if (expr.Is<Power>() && expr.As<Power>()->GetExp().Is<Number>()) {
+        return {&expr.As<Power>()->GetBase(), expr.As<Power>()->GetExp().As<Number>()->Value()};
+    }
+    return {&expr, 1};
+}
+
+Factors TermFactors(const IExpr& term) {
+    Factors res;
+    if (!term.Is<Product>()) {
+        res.emplace_back(SplitPower(term));
+        return res;
+    }
+
+    auto product = term.As<Product>();
+    res.reserve(product->GetConstants().size() + product->GetVariables().size());
+    for (const auto* part : {&product->GetConstants(), &product->GetVariables()}) {
+        for (const auto& mul : *part) {
+            res.emplace_back(SplitPower(*mul.Expression));
         }
-        res.emplace(std::move(val.Expression), 1);
+    }
+    return res;
+}
+
+// Monomial common to all terms, referencing bases inside the terms
+Factors CommonFactors(const Sum::ValueType& terms) {
+    if (terms.empty()) {
+        return {};
+    }
+
+    auto it = terms.begin();
+    auto res = TermFactors(*it->Expression);
+
+    for (++it; it != terms.end() && !res.empty(); ++it) {
+        const auto factors = TermFactors(*it->Expression);
+        std::erase_if(res, [&factors](auto& common) {
+            auto fnd = std::ranges::find_if(factors, [&common](const auto& val) { return val.first->IsEqualTo(*common.first); });
+            if (fnd == factors.end()) {
+                return true;
+            }
+            common.second = std::min(common.second, fnd->second);
+            return common.second == 0;
+        });
+    }
+    return res;
+}
+
+// Non-monomial common factors, e.g. x^2-1 in x^2a-a+x^2b-b
+std::unique_ptr<IExpr> FactorOutPolynomialContent(const Sum& sum) {
+    // A non-constant factor times a polynomial in another variable has degree 2 at least
+    if (sum.Meta().Degree < 2) {
+        return nullptr;
+    }
+    PolynomialRing ring;
+    auto poly = ring.FromExpr(sum);
+    if (!poly || ring.Variables() < 2) {
+        return nullptr;
     }
 
-    auto varPartTmp = varPart->As<Product>()->DetachVariables();
-    while (!varPartTmp.empty()) {
-        auto val = std::move(varPartTmp.extract(varPartTmp.begin()).value());
-        if (GetExp(val).Is<Number>()) {
-            auto [base, exp] = DecomposePower(val);
-            res.emplace(std::move(base), exp->As<Number>()->DetachValue());
+    std::vector<std::unique_ptr<IExpr>> factors;
+    for (size_t var = 0; var < ring.Variables(); ++var) {
+        if (poly->Degree(var) == 0) {
             continue;
         }
-        res.emplace(std::move(val.Expression), 1);
+        auto content = poly->ContentIn(var);
+        if (content.IsConstant()) {
+            continue;
+        }
+        poly = poly->DivideExact(content);
+        factors.emplace_back(ring.ToExpr(content));
     }
 
-    if (coef != 1 && coef != -1) {
-        res.emplace(math::number(coef), 1);
+    if (factors.empty()) {
+        return nullptr;
     }
 
+    factors.emplace_back(ring.ToExpr(*poly));
+    std::unique_ptr<IExpr> res = math::multiply(std::move(factors));
+    math::simplify(res);
     return res;
 }
 
-std::unique_ptr<IExpr> applyFactorOutTerms(std::unique_ptr<IExpr>&& exprOut, Sum::ValueType& terms) {
+std::unique_ptr<IExpr> applyFactorOutTerms(std::unique_ptr<IExpr>&& exprOut, Sum::ValueType&& terms) {
     if (exprOut->Is<Number>() && (exprOut->As<Number>()->Value() == 1)) {
         return nullptr;
     }
@@ -205,14 +324,7 @@ std::unique_ptr<IExpr> applyFactorOutTerms(std::unique_ptr<IExpr>&& exprOut, Sum
 }
 
 BigNum gcd(const std::vector<BigNum>& values) {
-    auto [resnum, resden] = values.front().Decompose();
-
-    for (auto it = ++values.begin(); it != values.end(); ++it) {
-        auto [num, den] = it->Decompose();
-        resnum = boost::multiprecision::gcd(resnum, num);
-        resden = boost::multiprecision::lcm(resden, den);
-    }
-    return BigNum::Rational{std::move(resnum), std::move(resden)};
+    return std::accumulate(++values.begin(), values.end(), values.front(), BigNum::Gcd);
 }
 
 std::unique_ptr<IExpr> Sum::simplify_FactorOutCoeffs() {
@@ -228,7 +340,12 @@ std::unique_ptr<IExpr> Sum::simplify_FactorOutCoeffs() {
     if (m_constant != 0) {
         coeffs.emplace_back(m_constant);
     }
-    auto gcdNumeric = gcd(coeffs) * Sign();
+    // Only a sum whose leading term is still unsimplified can have sign 0, nothing to factor out then
+    const auto sign = Sign();
+    if (sign == 0) {
+        return nullptr;
+    }
+    auto gcdNumeric = gcd(coeffs) * sign;
 
     if (gcdNumeric == 1) {
         return nullptr;
@@ -244,7 +361,7 @@ std::unique_ptr<IExpr> Sum::simplify_FactorOutCoeffs() {
     newSum.Add(std::move(val));
 
     while (!m_terms.empty()) {
-        val = std::move(m_terms.extract(m_terms.begin()).value().Expression);
+        val = std::move(Extract(m_terms.begin()).Expression);
         val = math::multiply(gcdInv->Copy(), std::move(val));
         math::simplify(val);
         newSum.Add(std::move(val));
@@ -255,43 +372,22 @@ std::unique_ptr<IExpr> Sum::simplify_FactorOutCoeffs() {
 }
 
 std::unique_ptr<IExpr> Sum::simplify_FactorOutTerms() {
-    auto gcdNumeric = simplify_FactorOutCoeffs();
-
-    std::vector<Term> terms;
-    for (const auto& term : m_terms) {
-        terms.emplace_back(term.Expression->Copy());
-    }
-
-    if (m_constant != 0) {
-        terms.emplace_back(math::number(m_constant));
+    // Like terms among children left unsimplified are not added up yet, the next pass factors out
+    if (HasDirtyChildren()) {
+        return nullptr;
     }
+    auto gcdNumeric = simplify_FactorOutCoeffs();
 
-    auto res = TermToMap(terms.back());
-    terms.pop_back();
-
-    for (auto& term : terms) {
-        auto map = TermToMap(term);
-
-        for (auto it = res.begin(); it != res.end();) {
-            auto fndIt = map.find(it->first);
+    auto common = (m_constant == 0) ? CommonFactors(m_terms) : Factors{};
 
-            if (fndIt == map.end()) {
-                it = res.erase(it);
-                continue;
+    if (common.empty()) {
+        if (auto res = FactorOutPolynomialContent(*this)) {
+            if (gcdNumeric) {
+                res = math::multiply(std::move(res), std::move(gcdNumeric));
+                math::simplify(res);
             }
-            
-            it->second = std::min(it->second, fndIt->second);
-    
-            if (it->second == 0) {
-                it = res.erase(it);
-                continue;
-            }
-
-            ++it;
+            return res;
         }
-    }
-
-    if (res.empty()) {
         if (gcdNumeric) {
             auto newSum = math::add();
             *newSum = std::move(*this);
@@ -301,15 +397,13 @@ std::unique_ptr<IExpr> Sum::simplify_FactorOutTerms() {
     }
 
     std::vector<std::unique_ptr<IExpr>> multipliersOut;
-    multipliersOut.reserve(res.size());
+    multipliersOut.reserve(common.size());
 
-    while (!res.empty()) {
-        auto it = res.extract(res.begin());
-        auto [base, power] = std::make_pair(std::move(it.key()), std::move(it.mapped()));
-        multipliersOut.emplace_back(math::exp(std::move(base.Expression), math::number(std::move(power))));
+    for (auto& [base, power] : common) {
+        multipliersOut.emplace_back(math::exp(base->Copy(), math::number(std::move(power))));
     }
 
-    auto applied = applyFactorOutTerms(math::multiply(std::move(multipliersOut)), m_terms);
+    auto applied = applyFactorOutTerms(math::multiply(std::move(multipliersOut)), DetachTerms());
 
     if (gcdNumeric) {
         if (applied) {
@@ -326,32 +420,50 @@ std::unique_ptr<IExpr> Sum::simplify_FactorOutTerms() {
 }
 
 std::unique_ptr<IExpr> Sum::simplify_AddLikeTerms() {
-    if (m_terms.size() <= 1) {
+    // Like terms are adjacent in the multiset
+    if (std::adjacent_find(m_terms.begin(), m_terms.end()) == m_terms.end()) {
         return nullptr;
     }
 
     Sum res{{}};
+    res.m_constant = std::move(m_constant);
 
     while (!m_terms.empty()) {
         auto [begin, end] = m_terms.equal_range(*m_terms.begin());
 
         if (std::next(begin) == end) {
-            res.m_terms.emplace(std::move(m_terms.extract(begin).value().Expression));
+            res.Insert(Extract(begin));
+            continue;
+        }
+
+        auto [coef1, constPart1, varPart] = DecomposeTerm(Extract(begin++));
+        // Terms without variables are alike only with equal constant factors, so only the
+        // coefficients are added up; adding the whole terms would give back the same sum
+        if (varPart->IsConstant()) {
+            for (auto it = begin; it != end;) {
+                coef1 += std::get<0>(DecomposeTerm(Extract(it++)));
+            }
+            // Terms that cancel out are dropped, a zero term would be taken for the leading one
+            if (coef1 != 0) {
+                res.Insert(Term{math::multiply(math::number(std::move(coef1)), std::move(constPart1))});
+            }
             continue;
         }
 
         std::vector<std::unique_ptr<IExpr>> coefs;
-        auto [coef1, constPart1, varPart] = DecomposeTerm(m_terms.extract(begin++).value());
         coefs.emplace_back(math::multiply(math::number(std::move(coef1)), std::move(constPart1)));
 
         for (auto it = begin; it != end;) {
-            auto [coef1, constPart1, _] = DecomposeTerm(m_terms.extract(it++).value());
+            auto [coef1, constPart1, _] = DecomposeTerm(Extract(it++));
             coefs.emplace_back(math::multiply(math::number(std::move(coef1)), std::move(constPart1)));
         }
 
         std::unique_ptr<IExpr> newCoef = math::add(std::move(coefs));
         math::simplify(newCoef);
-        res.m_terms.emplace(math::multiply(std::move(newCoef), std::move(varPart)));
+        if (newCoef->Is<Number>() && newCoef->As<Number>()->Value() == 0) {
+            continue;
+        }
+        res.Insert(Term{math::multiply(std::move(newCoef), std::move(varPart))});
     }
 
     *this = std::move(res);
@@ -359,12 +471,16 @@ std::unique_ptr<IExpr> Sum::simplify_AddLikeTerms() {
 }
 
 std::unique_ptr<IExpr> Sum::simplify_SimplifyChildren() {
+    if (!HasDirtyChildren()) {
+        return nullptr;
+    }
+
     Sum res{{}};
     res.m_constant = std::move(m_constant);
     res.m_terms.reserve(m_terms.size());
 
     while (!m_terms.empty()) {
-        auto val = std::move(m_terms.extract(m_terms.begin()).value().Expression);
+        auto val = std::move(Extract(m_terms.begin()).Expression);
 
         math::simplify(val);
         res.Add(std::move(val));
@@ -374,32 +490,50 @@ std::unique_ptr<IExpr> Sum::simplify_SimplifyChildren() {
     return nullptr;
 }
 
+// Scaled matrices are matrices once simplified, so a sum of matrices has only matrix terms
+std::unique_ptr<IExpr> Sum::simplify_AddMatrices() {
+    const auto isMatrix = [](const Term& term) { return term.Expression->Is<Matrix>(); };
+    if (std::ranges::none_of(m_terms, isMatrix)) {
+        return nullptr;
+    }
+    if (m_constant != 0 || !std::ranges::all_of(m_terms, isMatrix)) {
+        throw exception::CalcException{"cannot add a matrix and a scalar"};
+    }
+
+    std::unique_ptr<Matrix> res;
+    while (!m_terms.empty()) {
+        auto val = std::move(Extract(m_terms.begin()).Expression);
+        res = res ? res->Add(*val->As<Matrix>()) : std::unique_ptr<Matrix>{val.release()->As<Matrix>()};
+    }
+    return res;
+}
+
 std::unique_ptr<IExpr> Sum::simplify_DegenerateCases() {
     if (m_terms.empty()) {
         return math::number(std::move(m_constant));
     }
     if ((m_terms.size() == 1) && (m_constant == 0)) {
-        return std::move(m_terms.extract(m_terms.begin()).value().Expression);
+        return std::move(Extract(m_terms.begin()).Expression);
     }
     return nullptr;
 }
 
+std::span<const Rule<Sum>> Sum::Rules() {
+    static constexpr std::array<Rule<Sum>, 7> rules = {{
+        {"Sum::SimplifyChildren", &Sum::simplify_SimplifyChildren, true},
+        {"Sum::AddMatrices", &Sum::simplify_AddMatrices},
+        {"Sum::DegenerateCases", &Sum::simplify_DegenerateCases},
+        {"Sum::AddLikeTerms", &Sum::simplify_AddLikeTerms},
+        {"Sum::DegenerateCases", &Sum::simplify_DegenerateCases},
+        {"Sum::FactorOutTerms", &Sum::simplify_FactorOutTerms},
+        {"Sum::DegenerateCases", &Sum::simplify_DegenerateCases}
+    }};
+
+    return rules;
+}
+
 std::unique_ptr<IExpr> Sum::SimplifyImpl() {
-    decltype(&Sum::SimplifyImpl) simplifyRules[] = {
-        &Sum::simplify_SimplifyChildren,
-        &Sum::simplify_DegenerateCases,
-        &Sum::simplify_AddLikeTerms,
-        &Sum::simplify_DegenerateCases,
-        &Sum::simplify_FactorOutTerms,
-        &Sum::simplify_DegenerateCases
-    };
-
-    for (auto rule : simplifyRules) {
-        if (auto res = (*this.*rule)()) {
-            return res;
-        }
-    }
-    return nullptr;
+    return ApplyRules(*this, Rules());
 }
 
 size_t Sum::HashImpl() const {
@@ -407,16 +541,33 @@ size_t Sum::HashImpl() const {
     return hash::asymmetric_hash(RANDOM_BASE, m_terms);
 }
 
-std::unique_ptr<IExpr> Sum::Copy() const {
-    constexpr auto copy = [](const auto& val) { return val.Expression->Copy(); };
+hash::Fingerprint Sum::FingerprintImpl() const {
+    constexpr hash::Fingerprint RANDOM_BASE = {5324826590421870953u, 14932090417466925517u};
+    auto res = hash::absorb(RANDOM_BASE, m_constant.Fingerprint());
+    return hash::finalize(hash::absorb(res, hash::unordered_fingerprint(m_terms)));
+}
+
+Metadata Sum::MetadataImpl() const {
+    Metadata res;
+    for (const auto& term : m_terms) {
+        const auto meta = term.Expression->Meta();
+        res.AddChild(meta);
+        res.Degree = std::max(res.Degree, meta.Degree);
+    }
+    return res;
+}
 
+std::unique_ptr<IExpr> Sum::CopyImpl() const {
     auto newSum = math::add();
     newSum->m_constant = m_constant;
-    std::transform(m_terms.begin(), m_terms.end(), std::inserter(newSum->m_terms, newSum->m_terms.end()), copy);
+    newSum->m_terms.reserve(m_terms.size());
+    for (const auto& term : m_terms) {
+        newSum->Insert(term.Expression->Copy());
+    }
     return newSum;
 }
 
-std::string Sum::ToString() const {
+std::string Sum::ToStringImpl() const {
     std::string res;
     res.reserve(256);
 
@@ -428,8 +579,19 @@ std::string Sum::ToString() const {
         res.append(m_constant.ToString());
     }
 
+    // The order of the terms in the set depends on how it was filled, so equal sums are printed
+    // in the order of their terms' text, signs aside
+    std::vector<std::string> termStrs;
+    termStrs.reserve(m_terms.size());
     for (const auto& term : m_terms) {
-        auto termStr = term.Expression->ToString();
+        termStrs.push_back(term.Expression->ToString());
+    }
+    const auto magnitude = [](std::string_view str) { return str.starts_with('-') ? str.substr(1) : str; };
+    std::ranges::sort(termStrs, [&](std::string_view lhs, std::string_view rhs) {
+        return std::pair{magnitude(lhs), lhs} < std::pair{magnitude(rhs), rhs};
+    });
+
+    for (const auto& termStr : termStrs) {
         if (!termStr.starts_with('-') && !res.empty()) {
             res.push_back('+');
         }
@@ -1,14 +1,60 @@
 #include <tree/math.hpp>
 #include <tree/hash_utils.hpp>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
 
 namespace ezmath::tree {
 
 Symbol::Symbol(const std::string_view val) 
-    : m_value{val} 
+    : BaseExpression{KIND}
+    , m_value{val}
 {}
 
 std::string_view Symbol::Name() const noexcept { return m_value; }
 
+namespace {
+
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(const std::string_view str) const noexcept { return std::hash<std::string_view>()(str); }
+};
+
+struct SymbolTable {
+    std::shared_mutex Mutex;
+    std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> Ids;
+};
+
+}
+
+uint32_t Symbol::Id(const std::string_view name) {
+    static SymbolTable table;
+    const auto shared = [&] { return static_cast<uint32_t>(StringHash{}(name) % MAX_INTERNED); };
+    {
+        std::shared_lock lock{table.Mutex};
+        if (const auto it = table.Ids.find(name); it != table.Ids.end()) {
+            return it->second;
+        }
+        if (table.Ids.size() >= MAX_INTERNED) {
+            return shared();
+        }
+    }
+    std::unique_lock lock{table.Mutex};
+    // Another thread may have interned the name or filled the table in the meantime
+    if (const auto it = table.Ids.find(name); it != table.Ids.end()) {
+        return it->second;
+    }
+    if (table.Ids.size() >= MAX_INTERNED) {
+        return shared();
+    }
+    return table.Ids.emplace(std::string{name}, static_cast<uint32_t>(table.Ids.size())).first->second;
+}
+
+uint64_t Symbol::MaskBit(const std::string_view name) {
+    return uint64_t{1} << Id(name);
+}
+
 std::unique_ptr<IExpr> Symbol::SimplifyImpl() {
     return nullptr;
 }
@@ -18,15 +64,24 @@ size_t Symbol::HashImpl() const {
     return hash::combine(RANDOM_BASE, std::hash<std::string_view>()(m_value));
 }
 
-bool Symbol::IsEqualTo(const IExpr& other) const {
+hash::Fingerprint Symbol::FingerprintImpl() const {
+    constexpr uint64_t RANDOM_BASE = 11436170563574011519u;
+    return hash::fingerprint(RANDOM_BASE, m_value);
+}
+
+Metadata Symbol::MetadataImpl() const {
+    return {.Symbols = MaskBit(m_value), .Degree = 1, .IsConstant = false};
+}
+
+bool Symbol::IsEqualToImpl(const IExpr& other) const {
     return other.Is<Symbol>() && (m_value == other.As<Symbol>()->m_value);
 }
 
-std::unique_ptr<IExpr> Symbol::Copy() const {
+std::unique_ptr<IExpr> Symbol::CopyImpl() const {
     return math::symbol(m_value);
 }
 
-std::string Symbol::ToString() const {
+std::string Symbol::ToStringImpl() const {
     return std::string{m_value};
 }
 
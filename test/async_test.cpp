@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <tree/async.hpp>
+#include <tree/math.hpp>
+#include <parsing/parser.hpp>
+
+namespace ezmath::test {
+
+using namespace tree;
+
+class AsyncTest : public ::testing::Test {
+protected:
+    static constexpr std::string_view EXPR = "(a+b)(a-b)+\\frac{x^2-1}{x-1}-(a^2+x)+2(c+d)^2-(d+c)^2";
+
+    std::unique_ptr<IExpr> simplified(std::string_view str) {
+        auto tree = parsing::ParseTree(str);
+        math::simplify(tree);
+        return tree;
+    }
+};
+
+TEST_F(AsyncTest, TestSimplifyStep) {
+    const auto expected = simplified(EXPR);
+    auto tree = parsing::ParseTree(EXPR);
+
+    size_t steps = 1;
+    while (!SimplifyStep(tree, 1)) {
+        ++steps;
+        ASSERT_LT(steps, 1000u);
+    }
+    EXPECT_GT(steps, 1u);
+    EXPECT_TRUE(tree->IsSimplified());
+    EXPECT_TRUE(tree->IsEqualTo(*expected)) << tree->ToString() << " vs " << expected->ToString();
+}
+
+TEST_F(AsyncTest, TestPinnedRulesFinish) {
+    const auto expected = simplified(EXPR);
+    const yield::Quantum limit{0};
+    yield::Consume();
+    ASSERT_TRUE(yield::Stop());
+
+    auto tree = parsing::ParseTree(EXPR);
+    {
+        // Nested simplifications of a pinned rule run to the end even after the step was interrupted
+        const yield::Pin pin;
+        EXPECT_FALSE(yield::Stop());
+        EXPECT_FALSE(yield::Interrupted());
+        math::simplify(tree);
+    }
+    EXPECT_TRUE(tree->IsSimplified());
+    EXPECT_TRUE(tree->IsEqualTo(*expected)) << tree->ToString();
+    EXPECT_TRUE(yield::Stop());
+    EXPECT_TRUE(limit.Exhausted());
+}
+
+TEST_F(AsyncTest, TestQueueExecutorInterleaves) {
+    QueueExecutor executor;
+    std::vector<Task<std::unique_ptr<IExpr>>> tasks;
+    for (int i = 0; i < 4; ++i) {
+        tasks.emplace_back(SimplifyAsync(parsing::ParseTree(EXPR), executor, 2));
+        tasks.back().Start();
+    }
+
+    // every task gets one quantum per round
+    size_t rounds = 0;
+    while (executor.RunPending() == tasks.size()) {
+        ++rounds;
+    }
+    EXPECT_GT(rounds, 1u);
+    while (executor.RunOne()) {}
+
+    const auto expected = simplified(EXPR);
+    for (auto& task : tasks) {
+        ASSERT_TRUE(task.IsReady());
+        EXPECT_TRUE(task.Result()->IsEqualTo(*expected));
+    }
+}
+
+TEST_F(AsyncTest, TestAwaitOnThreadPool) {
+    ThreadPoolExecutor executor{4};
+    const auto expected = simplified(EXPR);
+
+    auto both = [](Executor& executor) -> Task<std::unique_ptr<IExpr>> {
+        auto lhs = co_await SimplifyAsync(parsing::ParseTree("(x+1)^2-x^2"), executor, 4);
+        auto rhs = co_await SimplifyAsync(parsing::ParseTree(EXPR), executor, 4);
+        co_return std::unique_ptr<IExpr>{math::add(std::move(lhs), std::move(rhs))};
+    };
+
+    std::vector<Task<std::unique_ptr<IExpr>>> tasks;
+    for (int i = 0; i < 16; ++i) {
+        tasks.emplace_back(both(executor));
+        tasks.back().Start();
+    }
+    for (auto& task : tasks) {
+        task.Wait();
+        auto res = task.Result();
+        math::simplify(res);
+        std::unique_ptr<IExpr> sum = math::add(parsing::ParseTree("(x+1)^2-x^2"), expected->Copy());
+        math::simplify(sum);
+        EXPECT_TRUE(res->IsEqualTo(*sum)) << res->ToString();
+    }
+}
+
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <tree/math.hpp>
+#include <parsing/parser.hpp>
+#include <limits>
+#include <string>
+
+namespace ezmath::test {
+
+using namespace tree;
+
+class CalculusTest : public ::testing::Test {
+protected:
+    std::unique_ptr<IExpr> simplified(std::string_view str) {
+        auto tree = parsing::ParseTree(str);
+        math::simplify(tree);
+        return tree;
+    }
+
+    void expectDerivative(std::string_view expr, std::string_view expected, size_t order = 1) {
+        auto tree = parsing::ParseTree(expr);
+        math::diff(tree, "x", order);
+        const auto rhs = simplified(expected);
+        EXPECT_TRUE(tree->IsEqualTo(*rhs)) << expr << ": " << tree->ToString() << " != " << rhs->ToString();
+    }
+};
+
+TEST_F(CalculusTest, TestRules) {
+    expectDerivative("x^3+2x+y", "3x^2+2");
+    expectDerivative("x^2y", "2xy");
+    expectDerivative("\\frac{1}{x}", "-\\frac{1}{x^2}");
+    expectDerivative("y^2", "0");
+    expectDerivative("\\ln(x^2+1)", "\\frac{2x}{x^2+1}");
+    expectDerivative("x^x", "x^x(\\ln(x)+1)");
+    expectDerivative("2^x", "2^x\\ln(2)");
+    expectDerivative("\\begin{pmatrix}x^2&1\\\\y&xy\\end{pmatrix}", "\\begin{pmatrix}2x&0\\\\0&y\\end{pmatrix}");
+}
+
+TEST_F(CalculusTest, TestHigherOrder) {
+    expectDerivative("x^{12}", "239500800x^2", 10);
+    expectDerivative("\\ln(x)", "-\\frac{362880}{x^{10}}", 10);
+    expectDerivative("(x+1)^5", "0", 6);
+}
+
+// Products of many factors are differentiated logarithmically; the result must still agree
+// with the derivative of the expanded polynomial
+TEST_F(CalculusTest, TestLongProduct) {
+    if (std::numeric_limits<BigNum::Integer>::is_bounded) {
+        GTEST_SKIP() << "values exceed the " << BigNum::Backend::NAME << " backend";
+    }
+    std::string str;
+    for (int i = 1; i <= 6; ++i) {
+        str += fmt::format("(x+{})", i);
+    }
+    auto product = parsing::ParseTree(str);
+    auto expanded = product->Copy();
+    math::expand(expanded);
+    math::diff(product, "x", 3);
+    math::diff(expanded, "x", 3);
+    math::cancel(product);
+    math::expand(product);
+    math::expand(expanded);
+    EXPECT_TRUE(product->IsEqualTo(*expanded)) << product->ToString() << " != " << expanded->ToString();
+}
+
+TEST_F(CalculusTest, TestParse) {
+    const auto tree = simplified("\\ln(xy)^2");
+    ASSERT_TRUE(tree->Is<Power>());
+    EXPECT_TRUE(tree->As<Power>()->GetBase().Is<Log>());
+    EXPECT_TRUE(simplified("\\ln 1")->IsEqualTo(Number{0}));
+    EXPECT_TRUE(simplified(tree->ToString())->IsEqualTo(*tree));
+}
+
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <codegen/codegen.hpp>
+#include <tree/math.hpp>
+#include <parsing/parser.hpp>
+#include <array>
+#include <cmath>
+
+#ifdef EZMATH_CODEGEN_JIT
+#include <codegen/jit.hpp>
+#endif
+
+namespace ezmath::test {
+
+using namespace tree;
+
+class CodegenTest : public ::testing::Test {
+protected:
+    codegen::Code generate(std::string_view str, codegen::Options options = {}) {
+        auto tree = parsing::ParseTree(str);
+        math::simplify(tree);
+        return codegen::Generate(*tree, options);
+    }
+
+    size_t count(std::string_view source, std::string_view what) {
+        size_t res = 0;
+        for (auto pos = source.find(what); pos != std::string_view::npos; pos = source.find(what, pos + what.size())) {
+            ++res;
+        }
+        return res;
+    }
+
+    // Source of the scalar function alone
+    std::string scalar(std::string_view str) {
+        codegen::Options options;
+        options.Batch = false;
+        return generate(str, options).Source;
+    }
+
+    size_t multiplications(std::string_view str) {
+        return count(scalar(str), " * ");
+    }
+
+    codegen::CompileOptions flags(std::vector<std::string> flags) {
+        codegen::CompileOptions options;
+        options.Flags = std::move(flags);
+        return options;
+    }
+};
+
+TEST_F(CodegenTest, TestSignature) {
+    const auto code = generate("y\\ln(x)");
+    EXPECT_EQ(code.Scalar, "ezmath_eval");
+    EXPECT_EQ(code.Batch, "ezmath_eval_batch");
+    EXPECT_EQ(code.Arguments, (std::vector<std::string>{"x", "y"}));
+    EXPECT_NE(code.Source.find("extern \"C\""), std::string::npos);
+
+    const auto named = generate("y\\ln(x)", {.Name = "f", .Arguments = {"y", "x", "z"}, .Batch = false});
+    EXPECT_EQ(named.Scalar, "f");
+    EXPECT_EQ(named.Batch, "");
+    EXPECT_EQ(named.Arguments, (std::vector<std::string>{"y", "x", "z"}));
+    EXPECT_EQ(named.Source.find("f_batch"), std::string::npos);
+}
+
+TEST_F(CodegenTest, TestAdditionChains) {
+    EXPECT_EQ(multiplications("x^{2}"), 1);
+    EXPECT_EQ(multiplications("x^{15}"), 5);
+    EXPECT_EQ(multiplications("x^{31}"), 7);
+    // x^5 reuses x^2 and x^3
+    EXPECT_EQ(multiplications("x^{3}+x^{5}"), 3);
+}
+
+TEST_F(CodegenTest, TestCommonSubexpressions) {
+    const auto source = scalar("\\ln(x+1)^{2}+\\ln(x+1)");
+    EXPECT_EQ(count(source, "std::log"), 1);
+    EXPECT_EQ(count(source, "std::pow"), 0);
+    EXPECT_EQ(count(scalar("x^{\\frac{5}{2}}"), "std::sqrt"), 1);
+}
+
+TEST_F(CodegenTest, TestErrors) {
+    EXPECT_THROW(generate("x+y", {.Name = "f", .Arguments = {"x"}, .Batch = true}), exception::CalcException);
+    EXPECT_THROW(generate("\\begin{pmatrix}x&1\\end{pmatrix}"), exception::CalcException);
+}
+
+#ifdef EZMATH_CODEGEN_JIT
+
+TEST_F(CodegenTest, TestCompiled) {
+    const auto function = codegen::CompiledFunction::Compile(
+        generate("\\frac{x^{3}}{y^{2}}+\\ln(x)+2^{\\frac{1}{2}}x+x^{\\frac{5}{2}}-\\frac{1}{x}"), flags({"-O2"}));
+    const auto expected = [](double x, double y) {
+        return x * x * x / (y * y) + std::log(x) + std::sqrt(2.0) * x + std::pow(x, 2.5) - 1 / x;
+    };
+
+    EXPECT_DOUBLE_EQ(function(std::vector{1.5, 2.0}), expected(1.5, 2.0));
+    EXPECT_THROW(function(std::vector{1.5}), std::invalid_argument);
+
+    const std::vector xs{0.5, 1.0, 2.0, 3.0, 7.5};
+    const std::vector ys{1.0, -2.0, 0.25, 4.0, 3.0};
+    std::vector<double> out(xs.size());
+    function(std::vector<std::span<const double>>{xs, ys}, out);
+    for (size_t i = 0; i < xs.size(); ++i) {
+        EXPECT_DOUBLE_EQ(out[i], expected(xs[i], ys[i])) << i;
+    }
+}
+
+// Values at exact rational points, computed by the numeric evaluator rather than by hand
+TEST_F(CodegenTest, TestCompiledSigns) {
+    constexpr std::array TESTS = {"-2x", "-\\frac{3}{x}+y", "-\\frac{3}{2}xy^{2}", "x-\\frac{5y}{x^{3}}", "-x^{\\frac{1}{2}}-2\\ln(y)"};
+    constexpr std::array<std::pair<std::string_view, double>, 3> POINTS = {{{"\\frac{3}{2}", 1.5}, {"\\frac{1}{4}", 0.25}, {"3", 3.0}}};
+    for (const auto* test : TESTS) {
+        const auto function = codegen::CompiledFunction::Compile(
+            generate(test, {.Name = "f", .Arguments = {"x", "y"}, .Batch = false}), flags({"-O2"}));
+        for (const auto& [x, xValue] : POINTS) {
+            for (const auto& [y, yValue] : POINTS) {
+                auto tree = parsing::ParseTree(test);
+                math::substitute(tree, {{"x", math::freeze(parsing::ParseTree(x))}, {"y", math::freeze(parsing::ParseTree(y))}});
+                const auto expected = Evalf(*tree, 17);
+                ASSERT_TRUE(expected) << test;
+                EXPECT_DOUBLE_EQ(function(std::vector{xValue, yValue}), std::stod(*expected)) << test << " at " << x << ", " << y;
+            }
+        }
+    }
+}
+
+TEST_F(CodegenTest, TestCompileError) {
+    EXPECT_THROW(codegen::CompiledFunction::Compile(generate("x"), flags({"-DEZMATH_VECTORIZE=error"})), std::runtime_error);
+}
+
+#endif
+
+}
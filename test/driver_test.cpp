@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "input.hpp"
+#include "pipeline.hpp"
+#include <fmt/format.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ezmath::test {
+
+using namespace driver;
+
+class DriverTest : public ::testing::Test {
+protected:
+    static std::FILE* temporary(std::string_view content) {
+        auto* file = std::tmpfile();
+        std::fwrite(content.data(), 1, content.size(), file);
+        std::fflush(file);
+        std::rewind(file);
+        return file;
+    }
+
+    static std::vector<std::string> readAll(LineReader& reader, const size_t maxLines) {
+        std::vector<std::string> lines;
+        // Lines of every batch stay valid until the batch is refilled, so keep them all
+        std::vector<Batch> batches(1);
+        while (reader.Read(batches.back(), maxLines)) {
+            EXPECT_LE(batches.back().Lines.size(), maxLines);
+            batches.emplace_back();
+        }
+        for (const auto& batch : batches) {
+            lines.insert(lines.end(), batch.Lines.begin(), batch.Lines.end());
+        }
+        return lines;
+    }
+
+    static std::vector<std::string> streamed(std::string_view content, const size_t maxLines, const size_t blockSize) {
+        StreamReader reader{temporary(content), blockSize};
+        auto lines = readAll(reader, maxLines);
+        EXPECT_EQ(reader.Consumed(), content.size());
+        return lines;
+    }
+
+    static std::vector<std::string> mapped(std::string_view content, const size_t maxLines) {
+        auto* file = temporary(content);
+        auto reader = MappedReader::Map(fileno(file));
+        std::fclose(file);
+        EXPECT_TRUE(reader);
+        if (!reader) {
+            return {};
+        }
+        auto lines = readAll(*reader, maxLines);
+        EXPECT_EQ(reader->Consumed(), content.size());
+        return lines;
+    }
+};
+
+TEST_F(DriverTest, TestReadersSplitLines) {
+    const std::vector<std::pair<std::string, std::vector<std::string>>> TESTS = {
+        {"", {}},
+        {"a\nb\n", {"a", "b"}},
+        {"a\r\nb\r\n", {"a", "b"}},
+        {"a\nb", {"a", "b"}},
+        {"a\n\n\nb\r", {"a", "", "", "b"}},
+        {"x+1\n2y\r\n\\frac{1}{2}\n(a+b)^{10}\nlast", {"x+1", "2y", "\\frac{1}{2}", "(a+b)^{10}", "last"}}
+    };
+    for (const auto& [content, expected] : TESTS) {
+        for (const size_t maxLines : {1, 2, 64}) {
+            EXPECT_EQ(mapped(content, maxLines), expected) << content;
+            // Blocks of 1 and 3 bytes cut every line, and \r\n, across blocks
+            for (const size_t blockSize : {1, 3, 1 << 16}) {
+                EXPECT_EQ(streamed(content, maxLines, blockSize), expected) << content << " in blocks of " << blockSize;
+            }
+        }
+    }
+}
+
+TEST_F(DriverTest, TestStreamReaderLongLines) {
+    std::string content;
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < 50; ++i) {
+        expected.emplace_back(i * 37 % 300, static_cast<char>('a' + i % 26));
+        content += expected.back() + (i % 3 ? "\n" : "\r\n");
+    }
+    EXPECT_EQ(streamed(content, 7, 16), expected);
+    EXPECT_EQ(mapped(content, 7), expected);
+}
+
+TEST_F(DriverTest, TestResultsInInputOrder) {
+    std::string content;
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < 200; ++i) {
+        // Slower lines now and then, so that workers finish out of order
+        lines.push_back(i % 7 ? fmt::format("{}+x", i) : fmt::format("\\frac{{x^{{{}}}-1}}{{x-1}}", 10 + i % 13));
+        content += lines.back() + "\n";
+    }
+    content += "\\frac{1}{\n";
+    lines.emplace_back("\\frac{1}{");
+
+    std::string expected;
+    Summary sequential;
+    for (const auto& line : lines) {
+        expected += ProcessLine(line, sequential) + "\n";
+    }
+
+    StreamReader input{temporary(content), 64};
+    auto* output = std::tmpfile();
+    const auto summary = driver::Run(input, output, {.Threads = 4, .BatchLines = 3, .MaxBatches = 2});
+    EXPECT_EQ(summary.Lines, lines.size());
+    EXPECT_EQ(summary.ParseErrors, 1u);
+    EXPECT_EQ(summary.Bytes, content.size());
+
+    std::rewind(output);
+    std::string actual(expected.size() + 1, '\0');
+    actual.resize(std::fread(actual.data(), 1, actual.size(), output));
+    std::fclose(output);
+    EXPECT_EQ(actual, expected);
+}
+
+}
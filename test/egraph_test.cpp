@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <tree/egraph.hpp>
+#include <tree/math.hpp>
+#include <parsing/parser.hpp>
+
+namespace ezmath::test {
+
+using namespace tree;
+
+class EGraphTest : public ::testing::Test {
+protected:
+    std::unique_ptr<IExpr> parse(std::string_view str) {
+        auto tree = parsing::ParseTree(str);
+        math::simplify(tree);
+        return tree;
+    }
+
+    void expectEquivalent(std::unique_ptr<IExpr> res, std::string_view expected) {
+        math::simplify(res);
+        EXPECT_TRUE(res->IsEqualTo(*parse(expected))) << res->ToString();
+    }
+};
+
+TEST_F(EGraphTest, TestHashCons) {
+    egraph::EGraph graph;
+    const auto id = graph.Add(*parse("ab+c"));
+    EXPECT_EQ(graph.Add(*parse("c+ba")), id);
+    EXPECT_NE(graph.Add(*parse("ab+d")), id);
+    EXPECT_EQ(graph.Nodes(), graph.Classes());
+}
+
+TEST_F(EGraphTest, TestCongruence) {
+    egraph::EGraph graph;
+    const auto a = graph.Add(*parse("a"));
+    const auto b = graph.Add(*parse("b"));
+    const auto lhs = graph.Add(*parse("(a+c)^2"));
+    const auto rhs = graph.Add(*parse("(b+c)^2"));
+    EXPECT_NE(graph.Find(lhs), graph.Find(rhs));
+
+    EXPECT_TRUE(graph.Merge(a, b));
+    graph.Rebuild();
+    EXPECT_EQ(graph.Find(lhs), graph.Find(rhs));
+    EXPECT_FALSE(graph.Merge(lhs, rhs));
+}
+
+TEST_F(EGraphTest, TestRebuildDeduplicates) {
+    egraph::EGraph graph;
+    const auto a = graph.Add(*parse("a"));
+    const auto b = graph.Add(*parse("b"));
+    const auto c = graph.Add(*parse("c"));
+    const auto logs = {graph.Add(*parse("\\ln(a)^2")), graph.Add(*parse("\\ln(b)^2")), graph.Add(*parse("\\ln(c)^2"))};
+    EXPECT_TRUE(graph.Merge(a, b));
+    EXPECT_TRUE(graph.Merge(c, b));
+    graph.Rebuild();
+
+    for (const auto id : logs) {
+        EXPECT_EQ(graph.Find(id), graph.Find(*logs.begin()));
+    }
+    // a, b and c share a class; every other class is left with one node
+    EXPECT_EQ(graph.Nodes(), graph.Classes() + 2);
+}
+
+TEST_F(EGraphTest, TestSaturateExpands) {
+    const auto res = egraph::Saturate(*parse("(x+1)^2-x^2"));
+    expectEquivalent(res->Copy(), "2x+1");
+}
+
+TEST_F(EGraphTest, TestSaturateKeepsFactoredForm) {
+    const auto expr = parse("(x+y)^5");
+    const auto res = egraph::Saturate(*expr);
+    EXPECT_TRUE(res->IsEqualTo(*expr)) << res->ToString();
+}
+
+TEST_F(EGraphTest, TestSaturateCancels) {
+    const egraph::PrintLength cost;
+    egraph::Options options;
+    options.Cost = &cost;
+    const auto res = egraph::Saturate(*parsing::ParseTree("\\frac{x^2-1}{x-1}"), options);
+    expectEquivalent(res->Copy(), "x+1");
+}
+
+TEST_F(EGraphTest, TestNodeRewriters) {
+    egraph::Options options;
+    options.Rewriters = egraph::NodeRewriters();
+    const auto expectSaturated = [&](std::string_view str, std::string_view expected) {
+        const auto res = egraph::Saturate(*parsing::ParseTree(str), options);
+        EXPECT_TRUE(res->IsEqualTo(*parse(expected))) << str << ": " << res->ToString();
+    };
+    // Like terms, like factors, a power of one and the logarithm of one, one node at a time
+    expectSaturated("2a+3a", "5a");
+    expectSaturated("x\\cdot x\\cdot x", "x^3");
+    expectSaturated("x^{1}+\\ln(1)", "x");
+}
+
+TEST_F(EGraphTest, TestLimits) {
+    egraph::Options options;
+    options.MaxNodes = 1;
+    const auto expr = parse("(a+b)(a-b)");
+    EXPECT_TRUE(egraph::Saturate(*expr, options)->IsEqualTo(*expr));
+}
+
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <tree/math.hpp>
+#include <parsing/parser.hpp>
+#include <limits>
+
+namespace ezmath::test {
+
+using namespace tree;
+
+class EvalfTest : public ::testing::Test {
+protected:
+    std::unique_ptr<IExpr> simplified(std::string_view str) {
+        auto tree = parsing::ParseTree(str);
+        math::simplify(tree);
+        return tree;
+    }
+
+    void expectSign(std::string_view expr, std::optional<int> expected) {
+        EXPECT_EQ(NumericSign(*simplified(expr)), expected) << expr;
+    }
+};
+
+TEST_F(EvalfTest, TestSign) {
+    expectSign("2^{\\frac{1}{2}}-3^{\\frac{1}{3}}", -1);
+    expectSign("3^{\\frac{1}{3}}-2^{\\frac{1}{2}}", 1);
+    expectSign("\\ln(3)-1", 1);
+    expectSign("2^{\\frac{1}{2}}+3^{\\frac{1}{2}}-10^{\\frac{1}{2}}", -1);
+    expectSign("(1-2^{\\frac{1}{2}})^3", -1);
+    expectSign("(-2)^{\\frac{1}{3}}", -1);
+    expectSign("2-2", 0);
+    expectSign("-\\frac{1}{7}", -1);
+}
+
+TEST_F(EvalfTest, TestUndecided) {
+    expectSign("x-1", std::nullopt);
+    expectSign("(-2)^{\\frac{1}{2}}", std::nullopt);
+    // Undefined values and exact zeros of irrational unsimplified trees are left open
+    EXPECT_EQ(NumericSign(*parsing::ParseTree("\\ln(-2)")), std::nullopt);
+    EXPECT_EQ(NumericSign(*parsing::ParseTree("\\frac{1}{1-1}")), std::nullopt);
+    EXPECT_EQ(NumericSign(*parsing::ParseTree("2^{\\frac{1}{2}}2^{\\frac{1}{2}}-2")), std::nullopt);
+}
+
+// Unsimplified integers are exact: sums of them may be exactly 0, and they are integer exponents
+TEST_F(EvalfTest, TestUnsimplifiedIntegers) {
+    EXPECT_EQ(NumericSign(*parsing::ParseTree("1-1")), 0);
+    EXPECT_EQ(NumericSign(*parsing::ParseTree("2\\cdot3-6")), 0);
+    EXPECT_EQ(NumericSign(*parsing::ParseTree("(-1)^{3}")), -1);
+    EXPECT_EQ(NumericSign(*parsing::ParseTree("(-3)^{-3}")), -1);
+    EXPECT_EQ(NumericSign(*parsing::ParseTree("(-3)^{1+1}")), 1);
+    EXPECT_EQ(Evalf(*parsing::ParseTree("(-3)^{-3}"), 5), "-0.037037");
+    EXPECT_EQ(NumericSign(*parsing::ParseTree("0^{1-2}")), std::nullopt);
+}
+
+// The rational agrees with \sqrt{2} to 60 digits, far beyond the first precision
+TEST_F(EvalfTest, TestRefinement) {
+    if (std::numeric_limits<BigNum::Integer>::is_bounded) {
+        GTEST_SKIP() << "values exceed the " << BigNum::Backend::NAME << " backend";
+    }
+    expectSign("2^{\\frac{1}{2}}-\\frac{1414213562373095048801688724209698078569671875376948073176679}{10^{60}}", 1);
+    expectSign("2^{\\frac{1}{2}}-\\frac{1414213562373095048801688724209698078569671875376948073176680}{10^{60}}", -1);
+}
+
+TEST_F(EvalfTest, TestCompare) {
+    Evaluator evaluator;
+    const auto sqrt2 = simplified("2^{\\frac{1}{2}}");
+    const auto cbrt3 = simplified("3^{\\frac{1}{3}}");
+    EXPECT_EQ(evaluator.Compare(*sqrt2, *cbrt3), std::strong_ordering::less);
+    EXPECT_EQ(evaluator.Compare(*cbrt3, *sqrt2), std::strong_ordering::greater);
+    EXPECT_EQ(evaluator.Compare(*sqrt2, *sqrt2->Copy()), std::strong_ordering::equal);
+    EXPECT_EQ(evaluator.Compare(*sqrt2, *simplified("x")), std::nullopt);
+}
+
+TEST_F(EvalfTest, TestDigits) {
+    Evaluator evaluator;
+    EXPECT_EQ(evaluator.Evalf(*simplified("2^{\\frac{1}{2}}"), 20), "1.4142135623730950488");
+    EXPECT_EQ(evaluator.Evalf(*simplified("\\ln(2)"), 10), "0.6931471806");
+    EXPECT_EQ(evaluator.Evalf(*simplified("2^{\\frac{1}{3}}"), 100),
+        "1.259921049894873164767210607278228350570251464701507980081975112155299676513959483729396562436255094");
+    EXPECT_EQ(evaluator.Evalf(*simplified("\\frac{1}{8}"), 5), "0.125");
+    EXPECT_EQ(evaluator.Evalf(*simplified("2-2"), 5), "0");
+    EXPECT_EQ(evaluator.Evalf(*simplified("x"), 5), std::nullopt);
+    EXPECT_EQ(Evalf(*simplified("2^{\\frac{1}{2}}"), 5000), std::nullopt);
+}
+
+}
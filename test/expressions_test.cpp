@@ -1,7 +1,13 @@
 #include <gtest/gtest.h>
 #include <tree/math.hpp>
+#include <tree/hash_utils.hpp>
+#include <tree/stats.hpp>
+#include <tree/traverse.hpp>
+#include <tree/visit.hpp>
 #include <parsing/parser.hpp>
+#include <limits>
 #include <ranges>
+#include <thread>
 
 namespace ezmath::test {
 
@@ -45,12 +51,126 @@ TEST_F(ExpressionsTest, TestSumFactorOut) {
 
 TEST_F(ExpressionsTest, TestSumFactorOut2) {
     auto TEST = "2^4a^{10}+2a^3";
-    auto ANSW = "2\\left(1+8a^{7}\\right)a^{3}";
+    auto ANSW = "2a^{3}\\left(1+8a^{7}\\right)";
     EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
     EXPECT_NO_THROW(math::simplify(res));
     EXPECT_EQ(res->ToString(), ANSW);
 }
 
+TEST_F(ExpressionsTest, TestSumFactorOutPolynomial) {
+    auto TEST = "x^2a-a+x^2b-b";
+    auto ANSW = "(x^2-1)(a+b)";
+    EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
+    EXPECT_NO_THROW(math::simplify(res));
+    auto expected = parsing::ParseTree(ANSW);
+    math::simplify(expected);
+    EXPECT_TRUE(res->IsEqualTo(*expected)) << res->ToString();
+    ASSERT_TRUE(res->Is<Product>());
+    EXPECT_EQ(res->As<Product>()->GetVariables().size(), 2u);
+}
+
+TEST_F(ExpressionsTest, TestSumKeepsConstant) {
+    auto TEST = "x-y-2";
+    auto ANSW = "-2+x-y";
+    EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
+    EXPECT_NO_THROW(math::simplify(res));
+    EXPECT_EQ(res->ToString(), ANSW);
+}
+
+// Terms with different constant factors and no variables used to be added up forever
+TEST_F(ExpressionsTest, TestSumOfConstantTerms) {
+    for (const auto* test : {"\\ln(8)-3\\ln(2)", "-3^{\\frac{1}{2}}-2\\ln(3)", "-2^{\\frac{1}{2}}-3^{\\frac{1}{2}}"}) {
+        EXPECT_NO_THROW(res = parsing::ParseTree(test));
+        EXPECT_NO_THROW(math::simplify(res)) << test;
+    }
+    EXPECT_NO_THROW(res = parsing::ParseTree("5\\ln(3)-2\\ln(3)"));
+    EXPECT_NO_THROW(math::simplify(res));
+    EXPECT_EQ(res->ToString(), "3\\ln\\left(3\\right)");
+    EXPECT_NO_THROW(res = parsing::ParseTree("2\\ln(3)-2\\ln(3)"));
+    EXPECT_NO_THROW(math::simplify(res));
+    EXPECT_EQ(res->ToString(), "0");
+}
+
+TEST_F(ExpressionsTest, TestProductCancelFractions) {
+    auto TEST = "\\frac{x^2-1}{x-1}";
+    auto ANSW = "x+1";
+    EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
+    EXPECT_NO_THROW(math::simplify(res));
+    auto expected = parsing::ParseTree(ANSW);
+    math::simplify(expected);
+    EXPECT_TRUE(res->IsEqualTo(*expected)) << res->ToString();
+}
+
+// A power of a sum is not part of any product, so its fractions are brought together on their own
+TEST_F(ExpressionsTest, TestPowerCancelFractions) {
+    const std::pair<std::string_view, std::string_view> TESTS[] = {
+        {"\\frac{1}{\\frac{1}{x}+\\frac{1}{y}}", "\\frac{xy}{x+y}"},
+        {"\\frac{1}{\\frac{a}{b}+\\frac{c}{d}}", "\\frac{bd}{ad+bc}"},
+        {"\\left(1+\\frac{1}{x}\\right)^{-2}", "\\frac{x^2}{x^2+2x+1}"}};
+    for (const auto& [test, answer] : TESTS) {
+        EXPECT_NO_THROW(res = parsing::ParseTree(test));
+        EXPECT_NO_THROW(math::simplify(res));
+        auto expected = parsing::ParseTree(answer);
+        math::simplify(expected);
+        EXPECT_TRUE(res->IsEqualTo(*expected)) << test << ": " << res->ToString();
+    }
+
+    // Sums without fractions are left alone
+    EXPECT_NO_THROW(res = parsing::ParseTree("\\frac{1}{x+y}"));
+    EXPECT_NO_THROW(math::simplify(res));
+    EXPECT_EQ(res->ToString(), "\\frac{1}{x+y}");
+}
+
+TEST_F(ExpressionsTest, TestCancelTogether) {
+    auto TEST = "\\frac{1}{x}+\\frac{1}{y}-\\frac{x+y}{xy}+\\frac{a^2-b^2}{a+b}";
+    auto ANSW = "a-b";
+    EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
+    EXPECT_NO_THROW(math::cancel(res));
+    auto expected = parsing::ParseTree(ANSW);
+    math::simplify(expected);
+    EXPECT_TRUE(res->IsEqualTo(*expected)) << res->ToString();
+}
+
+TEST_F(ExpressionsTest, TestSimplifyFixedPoint) {
+    auto TEST = "(a-b)(c-d)-(b-a)(d-c)";
+    auto ANSW = "0";
+    EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
+    EXPECT_NO_THROW(math::simplify(res));
+    EXPECT_EQ(res->ToString(), ANSW);
+}
+
+// Like terms that cancel out used to leave a zero term behind, whose sign 0 was factored out
+TEST_F(ExpressionsTest, TestLikeTermsCancelOut) {
+    constexpr auto TEST = "x^4-10x^2+1-(x^4-10x^2+1)";
+    EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
+    EXPECT_NO_THROW(math::simplify(res));
+    EXPECT_EQ(res->ToString(), "0");
+    EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
+    EXPECT_NO_THROW(math::factor(res));
+    EXPECT_EQ(res->ToString(), "0");
+    EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
+    EXPECT_NO_THROW(math::expand(res));
+    EXPECT_EQ(res->ToString(), "0");
+}
+
+// A symbol and its negation were not alike and tied for the leading term, so the sign factored
+// out flipped the leading term back and forth
+TEST_F(ExpressionsTest, TestSumSignIsStable) {
+    const std::vector<std::pair<std::string_view, std::string_view>> cases = {
+        {"y+a-a", "y"},
+        {"\\frac{1}{2}+a-a", "\\frac{1}{2}"},
+        {"-a-b", "-(a+b)"},
+        {"-\\left(a+b\\right)", "-(a+b)"},
+        {"b-a", "-(a-b)"},
+        {"-\\left(a-b\\right)", "-(a-b)"}
+    };
+    for (const auto& [input, expected] : cases) {
+        EXPECT_NO_THROW(res = parsing::ParseTree(input));
+        EXPECT_NO_THROW(math::simplify(res));
+        EXPECT_EQ(res->ToString(), expected) << input;
+    }
+}
+
 TEST_F(ExpressionsTest, TestSumNumbersSymbol) {
     auto TEST = "1+2+a+4+5";
     auto ANSW = "12+a";
@@ -59,6 +179,17 @@ TEST_F(ExpressionsTest, TestSumNumbersSymbol) {
     EXPECT_EQ(res->ToString(), ANSW);
 }
 
+TEST_F(ExpressionsTest, TestNumberRoots) {
+    const std::pair<std::string_view, std::string_view> TESTS[] = {
+        {"4^{\\frac{1}{2}}", "2"}, {"27^{\\frac{2}{3}}", "9"}, {"\\left(\\frac{9}{4}\\right)^{\\frac{1}{2}}", "\\frac{3}{2}"},
+        {"\\left(\\frac{1}{4}\\right)^{\\frac{1}{2}}", "\\frac{1}{2}"}, {"1024^{\\frac{1}{10}}", "2"}};
+    for (const auto& [test, answer] : TESTS) {
+        EXPECT_NO_THROW(res = parsing::ParseTree(test));
+        EXPECT_NO_THROW(math::simplify(res));
+        EXPECT_EQ(res->ToString(), answer) << test;
+    }
+}
+
 TEST_F(ExpressionsTest, TestPowProdBase) {
     auto TEST = "(ab)^2";
     auto ANSW = "a^{2}b^{2}";
@@ -106,6 +237,48 @@ TEST_F(ExpressionsTest, TestEqSumNoOrder) {
     } while (std::next_permutation(std::begin(values), std::end(values)));
 }
 
+TEST_F(ExpressionsTest, TestFingerprint) {
+    const auto fp = [](std::string_view str) { return parsing::ParseTree(str)->Fingerprint(); };
+    EXPECT_EQ(fp("a+2b+c^{d}"), fp("c^{d}+a+2b"));
+    EXPECT_EQ(fp("ab\\cdot3"), fp("3ba"));
+    EXPECT_NE(fp("a+b"), fp("a-b"));
+    EXPECT_NE(fp("a^b"), fp("b^a"));
+    EXPECT_NE(fp("a+a"), fp("a"));
+    EXPECT_NE(fp("\\frac{1}{2}"), fp("2"));
+
+    hash::FingerprintIndex<int> index;
+    EXPECT_TRUE(index.Insert(*parsing::ParseTree("x+y"), 1).second);
+    EXPECT_FALSE(index.Insert(*parsing::ParseTree("y+x"), 2).second);
+    ASSERT_NE(index.Find(*parsing::ParseTree("y+x")), nullptr);
+    EXPECT_EQ(*index.Find(*parsing::ParseTree("y+x")), 1);
+    EXPECT_EQ(index.Find(*parsing::ParseTree("y-x")), nullptr);
+}
+
+TEST_F(ExpressionsTest, TestKindDispatch) {
+    const auto tree = parsing::ParseTree("x^2+3y");
+    ASSERT_TRUE(tree->Is<Sum>());
+    EXPECT_EQ(tree->Kind(), IExpr::EKind::Sum);
+    EXPECT_FALSE(tree->Is<Product>());
+
+    const auto countSymbols = [](const auto& self, const IExpr& expr) -> size_t {
+        return Match(expr,
+            [](const Symbol&) -> size_t { return 1; },
+            [&](const Power& power) { return self(self, power.GetBase()) + self(self, power.GetExp()); },
+            [&](const Sum& sum) {
+                size_t res = 0;
+                for (const auto& term : sum.GetTerms()) res += self(self, *term.Expression);
+                return res;
+            },
+            [&](const Product& product) {
+                size_t res = 0;
+                for (const auto& mul : product.GetVariables()) res += self(self, *mul.Expression);
+                return res;
+            },
+            [](const auto&) -> size_t { return 0; });
+    };
+    EXPECT_EQ(countSymbols(countSymbols, *tree), 2u);
+}
+
 TEST_F(ExpressionsTest, TestSumNumbers) {
     auto TEST = "1+2+3+4+5";
     auto ANSW = "15";
@@ -114,9 +287,47 @@ TEST_F(ExpressionsTest, TestSumNumbers) {
     EXPECT_EQ(res->ToString(), ANSW);
 }
 
+TEST_F(ExpressionsTest, TestBigNumDecimal) {
+    if (std::numeric_limits<BigNum::Integer>::is_bounded) {
+        GTEST_SKIP() << "values exceed the " << BigNum::Backend::NAME << " backend";
+    }
+    for (const auto& val : {BigNum{3}.Pow(200000), -BigNum{7}.Pow(12345), BigNum{10}.Pow(5000)}) {
+        const auto str = val.ToString();
+        EXPECT_EQ(str, val.Decompose().first.convert_to<std::string>());
+        EXPECT_EQ(BigNum{str}, val);
+    }
+    EXPECT_EQ(BigNum{"0.25"}, BigNum{1} / BigNum{4});
+    EXPECT_EQ(BigNum{"123456789012345678901234567890.5"} * BigNum{2}, BigNum{"246913578024691357802469135781"});
+    EXPECT_EQ(BigNum{std::string(3000, '9') + ".9"} + BigNum{"0.1"}, BigNum{10}.Pow(3000));
+}
+
+TEST_F(ExpressionsTest, TestBigNumFraction) {
+    EXPECT_EQ(BigNum{"4/7"}, BigNum{4} / BigNum{7});
+    EXPECT_EQ(BigNum{"-4/14"}, BigNum{-2} / BigNum{7});
+    EXPECT_EQ(BigNum{"6/-3"}, BigNum{-2});
+    EXPECT_EQ(BigNum{"0/5"}, BigNum{0});
+    EXPECT_THROW(BigNum{"1/0"}, exception::CalcException);
+}
+
+TEST_F(ExpressionsTest, TestNumberFormat) {
+    const auto big = BigNum{2}.Pow(100);
+    EXPECT_EQ(big.ToString({NumberFormat::EStyle::Scientific, 5}), "1.2676\\cdot10^{30}");
+    EXPECT_EQ((-big).ToString({NumberFormat::EStyle::Truncated, 6}), "-126\\ldots376");
+    EXPECT_EQ(big.ToString({NumberFormat::EStyle::Truncated, 40}), "1267650600228229401496703205376");
+    // One digit or none leaves no fraction, and no point
+    EXPECT_EQ(big.ToString({NumberFormat::EStyle::Scientific, 1}), "1\\cdot10^{30}");
+    EXPECT_EQ((-big).ToString({NumberFormat::EStyle::Scientific, 0}), "-1\\cdot10^{30}");
+    EXPECT_EQ(big.ToString({NumberFormat::EStyle::Truncated, 0}), "1\\ldots6");
+
+    EXPECT_NO_THROW(res = parsing::ParseTree("2^{100}x"));
+    EXPECT_NO_THROW(math::simplify(res));
+    NumberFormatScope scope{{NumberFormat::EStyle::Scientific, 3}};
+    EXPECT_EQ(res->ToString(), "1.26\\cdot10^{30}x");
+}
+
 TEST_F(ExpressionsTest, TestHard) {
     auto TEST = "\\left(\\frac{2a}{2a+b}-\\frac{4a^2}{4a^2+4ab+b^2}\\right)\\div\\left(\\frac{2a}{4a^2-b^2}+\\frac{1}{b-2a}\\right)+\\frac{8a^2}{2a+b}";
-    auto ANSW = "15";
+    auto ANSW = "2a";
     EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
     EXPECT_NO_THROW(math::simplify(res));
     EXPECT_EQ(res->ToString(), ANSW);
@@ -124,10 +335,199 @@ TEST_F(ExpressionsTest, TestHard) {
 
 TEST_F(ExpressionsTest, TestHard2) {
     auto TEST = "\\frac{1}{\\frac{1}{x^2}-\\frac{2}{xy}+\\frac{1}{y^2}}";
-    auto ANSW = "15";
+    auto ANSW = "\\frac{x^2y^2}{x^2-2xy+y^2}";
     EXPECT_NO_THROW(res = parsing::ParseTree(TEST));
     EXPECT_NO_THROW(math::simplify(res));
-    EXPECT_EQ(res->ToString(), ANSW);
+    auto expected = parsing::ParseTree(ANSW);
+    math::simplify(expected);
+    EXPECT_TRUE(res->IsEqualTo(*expected)) << res->ToString();
 }
 
-}
\ No newline at end of file
+TEST_F(ExpressionsTest, TestSimplifyStats) {
+    stats::Reset();
+    stats::Enable(true);
+    EXPECT_NO_THROW(res = parsing::ParseTree("a^{10}+a"));
+    EXPECT_NO_THROW(math::simplify(res));
+    stats::Enable(false);
+
+    const auto snapshot = stats::TakeSnapshot();
+    if constexpr (!stats::Available) {
+        EXPECT_TRUE(snapshot.empty());
+        return;
+    }
+
+    const auto it = std::ranges::find(snapshot, "Sum::FactorOutTerms", &stats::RuleStats::Name);
+    ASSERT_NE(it, snapshot.end());
+    EXPECT_GE(it->Invocations, it->Fired);
+    EXPECT_GE(it->Fired, 1u);
+    EXPECT_GT(it->NodesAllocated, 0u);
+    EXPECT_NE(stats::ToJson(snapshot).find("\"name\":\"Sum::FactorOutTerms\""), std::string::npos);
+
+    // Rules that rewrite the node in place fire too
+    stats::Reset();
+    stats::Enable(true);
+    EXPECT_NO_THROW(res = parsing::ParseTree("2x+3x"));
+    EXPECT_NO_THROW(math::simplify(res));
+    EXPECT_NO_THROW(res = parsing::ParseTree("x\\cdot x"));
+    EXPECT_NO_THROW(math::simplify(res));
+    stats::Enable(false);
+    const auto inPlace = stats::TakeSnapshot();
+    for (const auto* name : {"Sum::AddLikeTerms", "Product::MultiplyLikeTerms"}) {
+        const auto rule = std::ranges::find(inPlace, name, &stats::RuleStats::Name);
+        ASSERT_NE(rule, inPlace.end()) << name;
+        EXPECT_GE(rule->Fired, 1u) << name;
+    }
+
+    stats::Reset();
+    EXPECT_TRUE(stats::TakeSnapshot().empty());
+}
+
+TEST_F(ExpressionsTest, TestFrozenConcurrentReaders) {
+    EXPECT_NO_THROW(res = parsing::ParseTree("(a+b)^3+\\frac{x}{y}c-2(x+1)^2"));
+    EXPECT_NO_THROW(math::simplify(res));
+    const auto copy = res->Copy();
+    const SharedExpr frozen = math::freeze(std::move(res));
+    const auto str = frozen->ToString();
+    const auto fingerprint = copy->Fingerprint();
+
+    constexpr size_t THREADS = 8;
+    std::vector<int> ok(THREADS, 0);
+    {
+        std::vector<std::jthread> threads;
+        for (size_t i = 0; i < THREADS; ++i) {
+            threads.emplace_back([&, i, shared = frozen] {
+                bool same = true;
+                for (int iter = 0; iter < 100; ++iter) {
+                    same &= shared->ToString() == str;
+                    same &= shared->Hash() == copy->Hash();
+                    same &= shared->Fingerprint() == fingerprint;
+                    same &= shared->IsEqualTo(*copy) && shared->Copy()->IsEqualTo(*shared);
+                }
+                ok[i] = same;
+            });
+        }
+    }
+    EXPECT_EQ(std::ranges::count(ok, 1), THREADS);
+    EXPECT_EQ(frozen.use_count(), 1);
+}
+
+TEST_F(ExpressionsTest, TestSubstitute) {
+    const Substitution values{{"x", math::freeze(num(1))}, {"y", math::freeze(num(2))}};
+    res = parsing::ParseTree("x^2+2xy+y^2+\\frac{x}{y}");
+    math::substitute(res, values);
+    EXPECT_TRUE(res->IsEqualTo(Number{BigNum::Backend::Fraction(19, 2)})) << res->ToString();
+
+    // All symbols are replaced at once
+    const Substitution swap{{"x", math::freeze(var("y"))}, {"y", math::freeze(var("x"))}};
+    res = parsing::ParseTree("x-2y");
+    math::substitute(res, swap);
+    auto expected = parsing::ParseTree("y-2x");
+    math::simplify(expected);
+    EXPECT_TRUE(res->IsEqualTo(*expected)) << res->ToString();
+}
+
+TEST_F(ExpressionsTest, TestSubstituteKeepsUntouchedSubtrees) {
+    res = parsing::ParseTree("(a+b)^3+x");
+    math::simplify(res);
+    EXPECT_EQ(res->Meta().Symbols & Symbol::MaskBit("x"), Symbol::MaskBit("x"));
+
+    const auto power = [](const IExpr& expr) -> const IExpr* {
+        for (const auto& term : expr.As<Sum>()->GetTerms()) {
+            if (term.Expression->Is<Power>()) {
+                return term.Expression.get();
+            }
+        }
+        return nullptr;
+    };
+    const auto* before = power(*res);
+    ASSERT_NE(before, nullptr);
+    math::substitute(res, {{"x", math::freeze(var("c"))}}, false);
+    ASSERT_TRUE(res->Is<Sum>());
+    EXPECT_EQ(power(*res), before);
+    EXPECT_NE(res->Meta().Symbols & Symbol::MaskBit("c"), 0u);
+}
+
+TEST_F(ExpressionsTest, TestMetadata) {
+    res = parsing::ParseTree("(a+b)^3c+\\frac{x}{y}+2^{\\frac{1}{2}}a");
+    math::simplify(res);
+    auto meta = res->Meta();
+    for (const auto name : {"a", "b", "c", "x", "y"}) {
+        EXPECT_NE(meta.Symbols & Symbol::MaskBit(name), 0u) << name;
+    }
+    EXPECT_NE(Symbol::Id("a"), Symbol::Id("b"));
+    EXPECT_EQ(Symbol::Id("a"), Symbol::Id(std::string{"a"}));
+
+    // Past the cap names share ids instead of growing the table
+    for (size_t i = 0; i < 1000; ++i) {
+        const auto name = fmt::format("s_{{{}}}", i);
+        EXPECT_LT(Symbol::Id(name), Symbol::MAX_INTERNED);
+        EXPECT_EQ(Symbol::Id(name), Symbol::Id(name));
+    }
+    EXPECT_EQ(Symbol::Id("a"), Symbol::Id(std::string{"a"}));
+    EXPECT_EQ(meta.Degree, Metadata::NOT_POLYNOMIAL);
+    EXPECT_FALSE(meta.IsConstant);
+    EXPECT_GE(meta.Depth, 4u);
+    EXPECT_EQ(meta.Size, res->Copy()->Meta().Size);
+
+    res = parsing::ParseTree("(a+b)^3c+2^{\\frac{1}{2}}a");
+    math::simplify(res);
+    EXPECT_EQ(res->Meta().Degree, 4u);
+
+    meta = Number{5}.Meta();
+    EXPECT_EQ(meta.Symbols, 0u);
+    EXPECT_EQ(meta.Size, 1u);
+    EXPECT_TRUE(meta.IsConstant);
+    res = parsing::ParseTree("2^{\\frac{1}{2}}+3");
+    math::simplify(res);
+    EXPECT_TRUE(res->IsConstant());
+    EXPECT_EQ(res->Meta().Degree, 0u);
+}
+
+// Generated input may nest far deeper than the call stack allows recursing into
+TEST_F(ExpressionsTest, TestDeepTree) {
+    const auto chain = [](const size_t depth, const std::string_view leaf) {
+        std::unique_ptr<IExpr> tree = math::symbol(leaf);
+        for (size_t i = 0; i < depth; ++i) {
+            if (i % 2) {
+                tree = math::exp(math::symbol("a"), std::move(tree));
+            } else {
+                tree = math::log(math::add(math::symbol("b"), std::move(tree)));
+            }
+        }
+        return tree;
+    };
+
+    res = chain(100000, "x");
+    const auto copy = res->Copy();
+    EXPECT_EQ(copy->Hash(), res->Hash());
+    EXPECT_EQ(copy->Fingerprint(), res->Fingerprint());
+    EXPECT_EQ(res->Meta().Depth, 150001u);
+    EXPECT_TRUE(copy->IsEqualTo(*res));
+    EXPECT_FALSE(chain(100000, "y")->IsEqualTo(*res));
+
+    size_t nodes = 0;
+    traverse::PostOrder(*res, [&nodes](const IExpr&) { ++nodes; });
+    EXPECT_EQ(nodes, res->Meta().Size);
+    size_t symbols = 0;
+    traverse::PreOrder(*res, [&symbols](const IExpr& node) {
+        symbols += node.Is<Symbol>();
+        return !node.Is<Log>();
+    });
+    EXPECT_EQ(symbols, 1u);
+
+    // Every level copies the string of its child, so keep this one shorter
+    res = math::symbol("x");
+    std::string expected = "x";
+    for (size_t i = 0; i < 4000; ++i) {
+        if (i % 2) {
+            res = math::exp(math::symbol("a"), std::move(res));
+            expected = fmt::format("a^{{{}}}", expected);
+        } else {
+            res = math::log(std::move(res));
+            expected = fmt::format("\\ln\\left({}\\right)", expected);
+        }
+    }
+    EXPECT_EQ(res->ToString(), expected);
+}
+
+}
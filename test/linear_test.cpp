@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <tree/linear.hpp>
+#include <parsing/exception.hpp>
+#include <parsing/parser.hpp>
+
+namespace ezmath::test {
+
+using namespace tree;
+
+class LinearTest : public ::testing::Test {
+protected:
+    LinearSystem::Solution solve(std::string_view str) {
+        const auto equations = parsing::ParseSystem(str);
+        auto system = LinearSystem::FromEquations(equations);
+        EXPECT_TRUE(system.has_value());
+        return system ? system->Solve() : LinearSystem::Solution{};
+    }
+
+    void expectValue(const LinearSystem::Solution& solution, std::string_view unknown, std::string_view value) {
+        auto expected = parsing::ParseTree(value);
+        math::simplify(expected);
+        for (const auto& [var, val] : solution.Values) {
+            if (var->ToString() == unknown) {
+                EXPECT_TRUE(val->IsEqualTo(*expected)) << unknown << " = " << val->ToString();
+                return;
+            }
+        }
+        ADD_FAILURE() << "unknown " << unknown << " not found";
+    }
+};
+
+TEST_F(LinearTest, TestParseSystem) {
+    const auto equations = parsing::ParseSystem("x+y &= 3 \\\\ x-y &= 1 \\\\");
+    ASSERT_EQ(equations.size(), 2u);
+    EXPECT_EQ(equations[1].Lhs->ToString(), parsing::ParseTree("x-y")->ToString());
+
+    EXPECT_THROW(parsing::ParseSystem("x+y"), parsing::exception::ParserException);
+    EXPECT_THROW(parsing::ParseSystem("x=1=2"), parsing::exception::ParserException);
+}
+
+TEST_F(LinearTest, TestUnique) {
+    const auto solution = solve("x+y=3 \\\\ x-y=1");
+    ASSERT_EQ(solution.Kind, LinearSystem::ESolution::Unique);
+    expectValue(solution, "x", "2");
+    expectValue(solution, "y", "1");
+
+    const auto fractions = solve("\\frac{x}{2}+\\frac{y}{3}=\\frac{1}{2} \\\\ 2x-\\frac{y}{5}=\\frac{17}{20} \\\\ z=x+y");
+    ASSERT_EQ(fractions.Kind, LinearSystem::ESolution::Unique);
+    expectValue(fractions, "x", "\\frac{1}{2}");
+    expectValue(fractions, "y", "\\frac{3}{4}");
+    expectValue(fractions, "z", "\\frac{5}{4}");
+}
+
+TEST_F(LinearTest, TestDegenerate) {
+    const auto infinite = solve("x+y+z=1 \\\\ 2x+2y+2z=2");
+    ASSERT_EQ(infinite.Kind, LinearSystem::ESolution::Infinite);
+    expectValue(infinite, "x", "1-y-z");
+    expectValue(infinite, "y", "y");
+
+    EXPECT_EQ(solve("x+y=1 \\\\ 2x+2y=3").Kind, LinearSystem::ESolution::Inconsistent);
+    EXPECT_FALSE(LinearSystem::FromEquations(parsing::ParseSystem("xy=1")).has_value());
+    EXPECT_FALSE(LinearSystem::FromEquations(parsing::ParseSystem("x^2+y=1")).has_value());
+}
+
+// Hilbert matrix: naive rational elimination grows its entries quickly
+TEST_F(LinearTest, TestHilbert) {
+#ifdef EZMATH_BIGNUM_INT128
+    // Products of the minors of larger orders overflow 128 bits
+    constexpr int N = 11;
+#else
+    constexpr int N = 14;
+#endif
+    constexpr std::string_view NAMES = "abcdefghijklmn";
+    std::vector<Equation> equations;
+    for (int i = 0; i < N; ++i) {
+        std::vector<std::unique_ptr<IExpr>> terms;
+        BigNum sum = 0;
+        for (int j = 0; j < N; ++j) {
+            const auto coef = BigNum{1} / BigNum{i + j + 1};
+            terms.emplace_back(math::multiply(math::number(coef), math::symbol(NAMES.substr(j, 1))));
+            sum += coef;
+        }
+        equations.push_back({math::add(std::move(terms)), math::number(sum)});
+    }
+
+    const auto system = LinearSystem::FromEquations(equations);
+    ASSERT_TRUE(system.has_value());
+    EXPECT_EQ(system->Unknowns(), static_cast<size_t>(N));
+    const auto solution = system->Solve();
+    ASSERT_EQ(solution.Kind, LinearSystem::ESolution::Unique);
+    for (const auto& [var, val] : solution.Values) {
+        EXPECT_EQ(val->ToString(), "1") << var->ToString();
+    }
+}
+
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <tree/math.hpp>
+#include <parsing/exception.hpp>
+#include <parsing/parser.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <limits>
+
+namespace ezmath::test {
+
+using namespace tree;
+
+class MatrixTest : public ::testing::Test {
+protected:
+    std::unique_ptr<IExpr> simplified(std::string_view str) {
+        auto tree = parsing::ParseTree(str);
+        math::simplify(tree);
+        return tree;
+    }
+
+    void expectEqual(std::string_view actual, std::string_view expected) {
+        const auto lhs = simplified(actual);
+        const auto rhs = simplified(expected);
+        EXPECT_TRUE(lhs->IsEqualTo(*rhs)) << lhs->ToString() << " != " << rhs->ToString();
+    }
+};
+
+TEST_F(MatrixTest, TestParse) {
+    const auto tree = simplified("\\begin{pmatrix}1&2\\\\3&4\\end{pmatrix}");
+    ASSERT_TRUE(tree->Is<Matrix>());
+    const auto* matrix = tree->As<Matrix>();
+    EXPECT_EQ(matrix->Rows(), 2u);
+    EXPECT_EQ(matrix->Cols(), 2u);
+    EXPECT_TRUE(matrix->IsNumeric());
+    EXPECT_EQ(tree->ToString(), "\\begin{pmatrix}1&2\\\\3&4\\end{pmatrix}");
+
+    EXPECT_FALSE(simplified("\\begin{bmatrix}x&1\\\\\\end{bmatrix}")->As<Matrix>()->IsNumeric());
+    EXPECT_THROW(parsing::ParseTree("\\begin{matrix}1&2\\\\3\\end{matrix}"), parsing::exception::ParserException);
+    EXPECT_THROW(parsing::ParseTree("\\begin{matrix}1&2\\end{pmatrix}"), parsing::exception::ParserException);
+    EXPECT_THROW(parsing::ParseTree("\\begin{matrix}1&2"), parsing::exception::ParserException);
+}
+
+TEST_F(MatrixTest, TestArithmetic) {
+    expectEqual("\\begin{pmatrix}1&2\\\\3&4\\end{pmatrix}\\begin{pmatrix}0&1\\\\1&0\\end{pmatrix}",
+                "\\begin{pmatrix}2&1\\\\4&3\\end{pmatrix}");
+    expectEqual("\\begin{pmatrix}0&1\\\\1&0\\end{pmatrix}\\begin{pmatrix}1&2\\\\3&4\\end{pmatrix}",
+                "\\begin{pmatrix}3&4\\\\1&2\\end{pmatrix}");
+    expectEqual("\\begin{pmatrix}1&x\\\\0&1\\end{pmatrix}^3", "\\begin{pmatrix}1&3x\\\\0&1\\end{pmatrix}");
+    expectEqual("2x\\begin{pmatrix}1&\\frac{1}{2}\\end{pmatrix}+\\begin{pmatrix}y&0\\end{pmatrix}",
+                "\\begin{pmatrix}2x+y&x\\end{pmatrix}");
+
+    EXPECT_THROW(simplified("\\begin{pmatrix}1&2\\end{pmatrix}+1"), exception::CalcException);
+    EXPECT_THROW(simplified("\\begin{pmatrix}1&2\\end{pmatrix}\\begin{pmatrix}1&2\\end{pmatrix}"), exception::CalcException);
+}
+
+TEST_F(MatrixTest, TestBracketedProducts) {
+    constexpr auto A = "\\begin{pmatrix}1&2\\\\3&4\\end{pmatrix}";
+    constexpr auto B = "\\begin{pmatrix}0&1\\\\1&0\\end{pmatrix}";
+    const auto format = [&](std::string_view str) {
+        return fmt::format(fmt::runtime(str), fmt::arg("A", A), fmt::arg("B", B));
+    };
+    expectEqual(format("({A})({B})"), "\\begin{pmatrix}2&1\\\\4&3\\end{pmatrix}");
+    expectEqual(format("({B})({A})"), "\\begin{pmatrix}3&4\\\\1&2\\end{pmatrix}");
+    expectEqual(format("({A}+{B}){B}"), "\\begin{pmatrix}3&1\\\\4&4\\end{pmatrix}");
+    expectEqual(format("x({A})y\\cdot({B})"), "xy\\begin{pmatrix}2&1\\\\4&3\\end{pmatrix}");
+    expectEqual(format("\\frac{{{A}}}{{{B}}}"), "\\begin{pmatrix}2&1\\\\4&3\\end{pmatrix}");
+    expectEqual(format("({A})^{{-1}}{A}"), "\\begin{pmatrix}1&0\\\\0&1\\end{pmatrix}");
+}
+
+TEST_F(MatrixTest, TestDeterminant) {
+    expectEqual("\\begin{vmatrix}1&2\\\\3&4\\end{vmatrix}", "-2");
+    expectEqual("\\begin{vmatrix}x&1&0\\\\1&x&1\\\\0&1&x\\end{vmatrix}", "x^3-2x");
+    expectEqual("\\begin{vmatrix}\\frac{1}{2}&\\frac{1}{3}\\\\\\frac{1}{3}&\\frac{1}{4}\\end{vmatrix}", "\\frac{1}{72}");
+}
+
+TEST_F(MatrixTest, TestInverse) {
+    expectEqual("\\begin{pmatrix}2&1\\\\1&1\\end{pmatrix}^{-1}", "\\begin{pmatrix}1&-1\\\\-1&2\\end{pmatrix}");
+    expectEqual("\\begin{pmatrix}x&0\\\\0&1\\end{pmatrix}^{-1}", "\\begin{pmatrix}\\frac{1}{x}&0\\\\0&1\\end{pmatrix}");
+    expectEqual("\\begin{pmatrix}1&2\\\\3&4\\end{pmatrix}\\div\\begin{pmatrix}1&2\\\\3&4\\end{pmatrix}",
+                "\\begin{pmatrix}1&0\\\\0&1\\end{pmatrix}");
+    EXPECT_THROW(simplified("\\begin{pmatrix}1&2\\\\2&4\\end{pmatrix}^{-1}"), exception::CalcException);
+}
+
+// Hilbert matrix: its inverse has integer entries, and the product with it is exactly the identity
+TEST_F(MatrixTest, TestHilbert) {
+    if (std::numeric_limits<BigNum::Integer>::is_bounded) {
+        GTEST_SKIP() << "values exceed the " << BigNum::Backend::NAME << " backend";
+    }
+    constexpr size_t N = 40;
+    Matrix::Numbers numbers;
+    for (size_t i = 0; i < N; ++i) {
+        for (size_t j = 0; j < N; ++j) {
+            numbers.emplace_back(BigNum{1} / BigNum{static_cast<int64_t>(i + j + 1)});
+        }
+    }
+    const Matrix hilbert{N, N, std::move(numbers)};
+    const auto inverse = hilbert.Inverse();
+    EXPECT_TRUE(std::ranges::all_of(inverse->GetNumbers(), [](const auto& val) { return val.IsInteger(); }));
+    EXPECT_TRUE(hilbert.Multiply(*inverse)->IsEqualTo(*Matrix::Identity(N)));
+    EXPECT_TRUE(inverse->Multiply(hilbert)->IsEqualTo(*Matrix::Identity(N)));
+}
+
+}
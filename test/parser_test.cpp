@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
+#include <parsing/exception.hpp>
 #include <parsing/parser.hpp>
+#include <tree/exception.hpp>
+#include <array>
+#include <optional>
 #include <ranges>
+#include <string>
 
 namespace ezmath::test {
 
@@ -47,7 +52,7 @@ TEST_F(ParserTest, TestSymbol) {
 
 TEST_F(ParserTest, TestProd) {
     constexpr auto TEST = "2a\\cdot b\\cdot3";
-    constexpr auto ANSW = "6ba";
+    constexpr auto ANSW = "6ab";
     ASSERT_NO_THROW(res = ParseTree(TEST));
     ASSERT_NO_THROW(math::simplify(res));
     EXPECT_EQ(res->ToString(), ANSW);
@@ -79,7 +84,7 @@ TEST_F(ParserTest, TestPower) {
 
 TEST_F(ParserTest, TestPowerNoBrackets) {
     constexpr auto TEST = "5^ab";
-    constexpr auto ANSW = "b \\cdot 5^{a}";
+    constexpr auto ANSW = "5^{a}b";
     ASSERT_NO_THROW(res = ParseTree(TEST));
     ASSERT_NO_THROW(math::simplify(res));
     EXPECT_EQ(res->ToString(), ANSW);
@@ -127,10 +132,98 @@ TEST_F(ParserTest, TestExpression2) {
 
 TEST_F(ParserTest, TestExpression3) {
     constexpr auto TEST = "1\\div12\\cdot x\\div y\\cdot uio";
-    constexpr auto ANSW = "\\frac{1}{12}\\frac{ouxi}{y}";
+    constexpr auto ANSW = "\\frac{1}{12}\\frac{ioux}{y}";
     ASSERT_NO_THROW(res = ParseTree(TEST));
     ASSERT_NO_THROW(math::simplify(res));
     EXPECT_EQ(res->ToString(), ANSW);
 }
 
-}
\ No newline at end of file
+TEST_F(ParserTest, TestFolding) {
+    constexpr ParserOptions FOLD{.Fold = true};
+    const auto expectNumber = [&](std::string_view str, std::string_view value) {
+        ASSERT_NO_THROW(res = ParseTree(str, FOLD));
+        ASSERT_TRUE(res->Is<Number>()) << str;
+        EXPECT_EQ(res->ToString(), value) << str;
+    };
+    expectNumber("\\frac{1}{2}", "\\frac{1}{2}");
+    expectNumber("-3+2^{10}", "1021");
+    expectNumber("(1+2)\\cdot4\\div(-6)", "-2");
+    expectNumber("2^{-2}", "\\frac{1}{4}");
+
+    ASSERT_NO_THROW(res = ParseTree("((x))", FOLD));
+    EXPECT_TRUE(res->Is<Symbol>());
+    ASSERT_NO_THROW(res = ParseTree("1\\cdot\\ln(x+0)", FOLD));
+    EXPECT_TRUE(res->Is<Log>());
+    // Undefined numbers are not folded, 0^{0} is left to simplify
+    EXPECT_THROW(ParseTree("\\frac{1}{0}", FOLD), tree::exception::CalcException);
+    ASSERT_NO_THROW(res = ParseTree("0^{0}", FOLD));
+    EXPECT_TRUE(res->Is<Power>());
+}
+
+TEST_F(ParserTest, TestFoldingKeepsResults) {
+    constexpr std::array TESTS = {
+        "1+a", "2a\\cdot b\\cdot3", "\\frac{4}{2}", "2\\cdot2^x", "1\\div12\\cdot x\\div y\\cdot uio",
+        "\\frac{x^2-1}{x-1}", "-2+x-y", "1+2+a+4+5", "0\\cdot\\frac{1}{x}", "-(-(x))", "2^{100}x",
+        "\\frac{1}{x}+\\frac{1}{y}-\\frac{x+y}{xy}", "(x^2-1)(a+b)", "\\ln(2^{3})+\\ln(2)",
+        "2^{\\frac{1}{2}}\\cdot\\frac{3}{4}", "(x+y)(x+25)12(124)y",
+        "\\begin{pmatrix}1&2\\\\3&4\\end{pmatrix}\\cdot2"};
+    for (const auto* test : TESTS) {
+        auto folded = ParseTree(test, {.Fold = true});
+        ASSERT_NO_THROW(res = ParseTree(test));
+        ASSERT_NO_THROW(math::simplify(res));
+        ASSERT_NO_THROW(math::simplify(folded));
+        EXPECT_TRUE(folded->IsEqualTo(*res)) << test << ": " << folded->ToString() << " != " << res->ToString();
+        EXPECT_EQ(folded->ToString(), res->ToString()) << test;
+    }
+}
+
+// Folding must not drop a division by zero that simplify would find
+TEST_F(ParserTest, TestFoldingKeepsErrors) {
+    constexpr std::array TESTS = {
+        "\\frac{\\frac{0}{0}}{2}", "(\\frac{1}{0})^{0}", "\\frac{1}{0}", "0\\cdot\\frac{1}{0}", "\\frac{x}{0}",
+        "2^{\\frac{1}{0}}", "0^{-1}", "3\\cdot0^{-2}x", "1+\\frac{1}{1-1}", "\\frac{0}{2}\\cdot\\frac{1}{0}", "0^{0}",
+        "(0^{-1})^{0}", "(\\frac{x}{0})^{0}", "-\\frac{x}{0}"};
+    for (const auto* test : TESTS) {
+        std::optional<std::string> expected;
+        try {
+            res = ParseTree(test);
+            math::simplify(res);
+            expected = res->ToString();
+        } catch (const tree::exception::CalcException&) {
+        }
+
+        std::optional<std::string> folded;
+        try {
+            res = ParseTree(test, {.Fold = true});
+            math::simplify(res);
+            folded = res->ToString();
+        } catch (const tree::exception::CalcException&) {
+        }
+        EXPECT_EQ(folded, expected) << test;
+    }
+}
+
+TEST_F(ParserTest, TestNestingLimit) {
+    const auto nested = [](const size_t depth, std::string_view open, std::string_view close) {
+        std::string str;
+        for (size_t i = 0; i < depth; ++i) {
+            str += open;
+        }
+        str += "x";
+        for (size_t i = 0; i < depth; ++i) {
+            str += close;
+        }
+        return str;
+    };
+    // Symbols view into the input, so the tree is dropped before the string
+    const auto deep = nested(500, "a^{", "}");
+    TTree tree;
+    ASSERT_NO_THROW(tree = ParseTree(deep));
+    ASSERT_NO_THROW(math::simplify(tree));
+    EXPECT_THROW(ParseTree(nested(5000, "a^{", "}")), parsing::exception::ParserException);
+    EXPECT_THROW(ParseTree(nested(20000, "(", ")")), parsing::exception::ParserException);
+    EXPECT_THROW(ParseTree(nested(5000, "\\ln", "")), parsing::exception::ParserException);
+    EXPECT_THROW(ParseTree(nested(5000, "\\frac{1}{", "}")), parsing::exception::ParserException);
+}
+
+}
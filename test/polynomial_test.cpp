@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include <tree/dense_polynomial.hpp>
+#include <tree/factor.hpp>
+#include <tree/polynomial.hpp>
+#include <parsing/parser.hpp>
+#include <fmt/format.h>
+#include <initializer_list>
+#include <limits>
+#include <random>
+
+namespace ezmath::test {
+
+using namespace tree;
+
+class PolynomialTest : public ::testing::Test {
+protected:
+    PolynomialRing ring;
+
+    Polynomial poly(std::string_view str) {
+        auto tree = parsing::ParseTree(str);
+        math::simplify(tree);
+        auto res = ring.FromExpr(*tree);
+        EXPECT_TRUE(res.has_value());
+        return *res;
+    }
+
+    // Registers the generators in this order, so that leading terms, and with them the signs of
+    // contents and gcds, do not depend on the order in which trees list their symbols
+    void generators(std::initializer_list<std::string_view> names) {
+        for (const auto name : names) {
+            ASSERT_TRUE(ring.FromExpr(*parsing::ParseTree(name)).has_value());
+        }
+    }
+
+    size_t var(std::string_view name) {
+        for (size_t i = 0; i < ring.Variables(); ++i) {
+            if (ring.Generator(i).ToString() == name) return i;
+        }
+        ADD_FAILURE() << "unknown variable " << name;
+        return 0;
+    }
+};
+
+TEST_F(PolynomialTest, TestArithmetic) {
+    const auto a = poly("x+y");
+    const auto b = poly("x-y");
+    EXPECT_EQ(a * b, poly("x^2-y^2"));
+    EXPECT_EQ(a + b, poly("2x"));
+    EXPECT_EQ(a.Pow(3), poly("x^3+3x^2y+3xy^2+y^3"));
+    EXPECT_TRUE((a - a).IsZero());
+}
+
+TEST_F(PolynomialTest, TestDivideExact) {
+    const auto res = poly("x^3-y^3").DivideExact(poly("x-y"));
+    ASSERT_TRUE(res.has_value());
+    EXPECT_EQ(*res, poly("x^2+xy+y^2"));
+    EXPECT_FALSE(poly("x^2+1").DivideExact(poly("x+1")).has_value());
+}
+
+TEST_F(PolynomialTest, TestContent) {
+    generators({"x", "y"});
+    const auto p = poly("\\frac{4}{3}x^2-\\frac{2}{3}y");
+    EXPECT_EQ(p.Content(), BigNum::Rational(2, 3));
+    EXPECT_EQ(p.PrimitivePart(), poly("2x^2-y"));
+    EXPECT_EQ(poly("-6x+3").Content(), -3);
+    const auto q = poly("x^2a-a+x^2b-b");
+    EXPECT_EQ(q.ContentIn(var("a")), poly("x^2-1"));
+    EXPECT_EQ(q.ContentIn(var("x")), poly("a+b"));
+}
+
+TEST_F(PolynomialTest, TestGcdUnivariate) {
+    const auto a = poly("(x+1)(x+2)(x-5)");
+    const auto b = poly("(x+1)(x-5)^2(x+7)");
+    EXPECT_EQ(Polynomial::Gcd(a, b), poly("(x+1)(x-5)"));
+    EXPECT_TRUE(Polynomial::Gcd(poly("x^2+1"), poly("x+1")).IsConstant());
+}
+
+TEST_F(PolynomialTest, TestGcdMultivariate) {
+    generators({"x", "y", "z"});
+    const auto g = poly("3x^2y-2yz+7");
+    const auto a = poly("(3x^2y-2yz+7)(x+y+z)^2");
+    const auto b = poly("(3x^2y-2yz+7)(x-2y)(12345678901234567890z+1)");
+    EXPECT_EQ(Polynomial::Gcd(a, b), g);
+    EXPECT_EQ(Polynomial::Gcd(a * BigNum{6}, b * BigNum{4}), g);
+}
+
+TEST_F(PolynomialTest, TestToExpr) {
+    auto tree = ring.ToExpr(poly("(a+b)^2"));
+    math::simplify(tree);
+    auto expected = parsing::ParseTree("a^2+2ab+b^2");
+    math::simplify(expected);
+    EXPECT_TRUE(tree->IsEqualTo(*expected));
+}
+
+TEST_F(PolynomialTest, TestRationalCancel) {
+    auto tree = parsing::ParseTree("\\frac{2x^2-2y^2}{4x+4y}");
+    auto func = ring.FromRational(*tree);
+    ASSERT_TRUE(func.has_value());
+    EXPECT_TRUE(func->Cancel());
+    EXPECT_EQ(func->Numerator, poly("\\frac{x-y}{2}"));
+    EXPECT_EQ(func->Denominator, poly("1"));
+    EXPECT_FALSE(func->Cancel());
+}
+
+TEST_F(PolynomialTest, TestDenseMultiply) {
+    using Algorithm = DensePolynomial::EAlgorithm;
+    std::mt19937_64 rng{42};
+    const auto random = [&rng](const size_t size, const unsigned bits) {
+        std::vector<DensePolynomial::Integer> res;
+        for (size_t i = 0; i < size; ++i) {
+            DensePolynomial::Integer val = 0;
+            for (unsigned b = 0; b < bits; b += 16) {
+                val = (val << 16) + rng() % (1 << 16);
+            }
+            res.emplace_back(rng() % 2 ? -val : val);
+        }
+        return res;
+    };
+
+    const unsigned maxBits = std::numeric_limits<DensePolynomial::Integer>::is_bounded ? 32 : 200;
+    for (const auto& [n, m] : {std::pair<size_t, size_t>{1, 7}, {40, 33}, {300, 20}, {200, 257}}) {
+        for (const auto bits : {16u, maxBits}) {
+            const auto lhs = random(n, bits);
+            const auto rhs = random(m, bits);
+            const auto expected = DensePolynomial::Multiply(lhs, rhs, Algorithm::Schoolbook);
+            EXPECT_EQ(DensePolynomial::Multiply(lhs, rhs, Algorithm::Karatsuba), expected) << n << "x" << m;
+            EXPECT_EQ(DensePolynomial::Multiply(lhs, rhs, Algorithm::Ntt), expected) << n << "x" << m;
+        }
+    }
+}
+
+TEST_F(PolynomialTest, TestDensePolynomial) {
+    const auto p = DensePolynomial::FromSparse(poly("\\frac{x^2}{3}-\\frac{2}{9}"));
+    ASSERT_TRUE(p.has_value());
+    EXPECT_EQ(p->Scale(), BigNum::Rational(1, 9));
+    EXPECT_EQ(p->Coefficient(2), BigNum::Rational(1, 3));
+    EXPECT_EQ(p->ToSparse(), poly("\\frac{x^2}{3}-\\frac{2}{9}"));
+    EXPECT_TRUE((*p - *p).IsZero());
+
+    if (std::numeric_limits<DensePolynomial::Integer>::is_bounded) {
+        GTEST_SKIP() << "values exceed the " << BigNum::Backend::NAME << " backend";
+    }
+    constexpr uint32_t N = 500;
+    const auto power = (DensePolynomial::Variable() + DensePolynomial::Constant(1)).Pow(N);
+    ASSERT_EQ(power.Degree(), N);
+    BigNum binomial = 1;
+    for (uint32_t k = 0; k <= N; ++k) {
+        EXPECT_EQ(power.Coefficient(k), binomial) << k;
+        binomial = binomial * BigNum{N - k} / BigNum{k + 1};
+    }
+    EXPECT_EQ(poly("(x+1)^{500}"), power.ToSparse());
+    EXPECT_FALSE(DensePolynomial::FromSparse(poly("x+y")).has_value());
+}
+
+TEST_F(PolynomialTest, TestExpand) {
+    auto tree = parsing::ParseTree("(x+1)^3-(x-1)(x+2)");
+    math::expand(tree);
+    auto expected = parsing::ParseTree("x^3+2x^2+2x+3");
+    math::simplify(expected);
+    EXPECT_TRUE(tree->IsEqualTo(*expected)) << tree->ToString();
+
+    // Braced exponents, and content that simplify would factor out of the sum
+    const auto expectExpanded = [&](std::string_view str, std::string_view expanded, const size_t terms) {
+        auto res = parsing::ParseTree(str);
+        math::expand(res);
+        ASSERT_TRUE(res->Is<Sum>()) << str << ": " << res->ToString();
+        EXPECT_EQ(res->As<Sum>()->GetTerms().size() + (res->As<Sum>()->GetConstant() != 0), terms) << str;
+        const auto polynomial = ring.FromExpr(*res);
+        ASSERT_TRUE(polynomial.has_value());
+        EXPECT_EQ(*polynomial, poly(expanded)) << str << ": " << res->ToString();
+    };
+    expectExpanded("(x+1)^{3}", "x^3+3x^2+3x+1", 4);
+    expectExpanded("(2x+2)^2", "4x^2+8x+4", 3);
+    expectExpanded("x^{2}(x+1)", "x^3+x^2", 2);
+    if (!std::numeric_limits<BigNum::Integer>::is_bounded) {
+        expectExpanded("(x+1)^{500}-x^{500}", "(x+1)^{500}-x^{500}", 500);
+    }
+}
+
+TEST_F(PolynomialTest, TestFactor) {
+    auto tree = parsing::ParseTree("x^2+3x+2");
+    math::factor(tree);
+    auto expected = parsing::ParseTree("(x+1)(x+2)");
+    math::simplify(expected);
+    EXPECT_TRUE(tree->IsEqualTo(*expected)) << tree->ToString();
+
+    tree = parsing::ParseTree("x^{2}-1");
+    math::factor(tree);
+    expected = parsing::ParseTree("(x-1)(x+1)");
+    math::simplify(expected);
+    EXPECT_TRUE(tree->IsEqualTo(*expected)) << tree->ToString();
+
+    const auto res = Factor(poly("-2x^5+2x^4+2x^3-4x^2+4x-2"));
+    ASSERT_TRUE(res.has_value());
+    EXPECT_EQ(res->Content, -2);
+    ASSERT_EQ(res->Factors.size(), 2u);
+    EXPECT_EQ(res->Factors[0].first, poly("x-1"));
+    EXPECT_EQ(res->Factors[0].second, 2u);
+    EXPECT_EQ(res->Factors[1].first, poly("x^3+x^2+1")) << ring.ToExpr(res->Factors[1].first)->ToString();
+    EXPECT_EQ(res->Factors[1].second, 1u);
+
+    // irreducible over the integers, but split modulo every prime
+    for (const auto str : {"x^4+1", "x^4-10x^2+1"}) {
+        const auto irreducible = Factor(poly(str));
+        ASSERT_TRUE(irreducible.has_value());
+        ASSERT_EQ(irreducible->Factors.size(), 1u) << str;
+        EXPECT_EQ(irreducible->Factors[0].first, poly(str));
+    }
+    EXPECT_FALSE(Factor(poly("x+y")).has_value());
+}
+
+TEST_F(PolynomialTest, TestFactorProduct) {
+    if (std::numeric_limits<BigNum::Integer>::is_bounded) {
+        GTEST_SKIP() << "values exceed the " << BigNum::Backend::NAME << " backend";
+    }
+    // (x^10 + i x^3 - 7)^2 (3x^10 - i x + 5) for i = 1, 2 and x^10 + 1 = (x^2 + 1)(x^8 - x^6 + x^4 - x^2 + 1)
+    std::vector<Polynomial> factors;
+    Polynomial product = poly("x^{10}+1");
+    for (const auto i : {1, 2}) {
+        const auto first = poly(fmt::format("x^{{10}}+{}x^3-7", i));
+        const auto second = poly(fmt::format("3x^{{10}}-{}x+5", i));
+        product = product * first.Pow(2) * second;
+    }
+    ASSERT_EQ(product.Degree(0), 70u);
+
+    const auto res = Factor(product);
+    ASSERT_TRUE(res.has_value());
+    EXPECT_EQ(res->Content, 1);
+    ASSERT_EQ(res->Factors.size(), 6u);
+    EXPECT_EQ(res->Factors[0].first, poly("x^2+1"));
+    EXPECT_EQ(res->Factors[1].first, poly("x^8-x^6+x^4-x^2+1"));
+    Polynomial expanded = Polynomial::Constant(1, 1);
+    for (const auto& [factor, exp] : res->Factors) {
+        expanded = expanded * factor.Pow(exp);
+    }
+    EXPECT_EQ(expanded, product);
+}
+
+}
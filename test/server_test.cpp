@@ -0,0 +1,185 @@
+#include <gtest/gtest.h>
+#include "cache.hpp"
+#include "json.hpp"
+#include "server.hpp"
+#include <parsing/parser.hpp>
+#include <tree/math.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace ezmath::test {
+
+using namespace driver;
+
+class ServerTest : public ::testing::Test {
+protected:
+    static tree::SharedExpr parsed(std::string_view str) {
+        return tree::math::freeze(parsing::ParseTree(str, {.Fold = true}));
+    }
+
+    // Answers of a server to the lines of input, one per line, sorted since they may come out of order
+    static std::vector<std::string> serve(const ServerOptions& options, std::string_view input) {
+        auto* in = std::tmpfile();
+        auto* out = std::tmpfile();
+        std::fwrite(input.data(), 1, input.size(), in);
+        std::fflush(in);
+        std::rewind(in);
+        {
+            Server server{options};
+            server.ServeStream(fileno(in), fileno(out));
+        }
+        std::fclose(in);
+
+        std::rewind(out);
+        std::vector<std::string> answers;
+        std::string line;
+        for (int c = 0; (c = std::fgetc(out)) != EOF;) {
+            if (c == '\n') {
+                answers.push_back(std::move(line));
+                line.clear();
+            } else {
+                line.push_back(static_cast<char>(c));
+            }
+        }
+        std::fclose(out);
+        std::ranges::sort(answers);
+        return answers;
+    }
+};
+
+TEST_F(ServerTest, TestJsonObjects) {
+    auto object = json::ParseObject(R"( {"id": -1.5e+3, "expr": "\\frac{1}{2}\n\u00e9\ud83d\ude00", "a": true, "b": null} )");
+    ASSERT_TRUE(object.has_value());
+    EXPECT_EQ(object->at("id").Text, "-1.5e+3");
+    EXPECT_FALSE(object->at("id").IsString);
+    EXPECT_EQ(object->at("expr").Text, "\\frac{1}{2}\n\xc3\xa9\xf0\x9f\x98\x80");
+    EXPECT_TRUE(object->at("expr").IsString);
+    EXPECT_EQ(object->at("a").Text, "true");
+    EXPECT_EQ(object->at("b").Text, "null");
+    EXPECT_TRUE(json::ParseObject("{}").has_value());
+
+    for (const auto* number : {"0", "-0", "12", "0.5", "1e9", "1E-9", "-12.25e+2"}) {
+        EXPECT_TRUE(json::ParseObject(fmt::format(R"({{"id":{}}})", number)).has_value()) << number;
+    }
+    for (const auto* number : {"nan", "inf", "-inf", "NaN", "infinity", "01", "1.", ".5", "+1", "-", "1e", "1e+", "0x10", "1.5.2", "--1"}) {
+        EXPECT_FALSE(json::ParseObject(fmt::format(R"({{"id":{}}})", number)).has_value()) << number;
+    }
+    for (const auto* invalid : {"", "[]", "{", R"({"a":1,})", R"({"a":{}})", R"({"a":[1]})", R"({"a":"\x"})",
+                                R"({"a":"\ud83d"})", R"({"a":"\ud83d \ude00"})", "{\"a\":\"\t\"}", R"({"a":1} x)"}) {
+        EXPECT_FALSE(json::ParseObject(invalid).has_value()) << invalid;
+    }
+
+    std::string out;
+    json::AppendString(out, "a\"\\\n\x01");
+    EXPECT_EQ(out, R"("a\"\\\n\u0001")");
+}
+
+TEST_F(ServerTest, TestCacheEvictsLeastRecentlyUsed) {
+    // Room for two entries of this size
+    const std::string result(1000, 'r');
+    ResultCache cache{2500};
+    cache.Insert("a", false, {result});
+    cache.Insert("b", false, {result});
+    ASSERT_TRUE(cache.Find("a").has_value());
+    cache.Insert("c", false, {result});
+
+    EXPECT_TRUE(cache.Find("a").has_value());
+    EXPECT_FALSE(cache.Find("b").has_value());
+    EXPECT_TRUE(cache.Find("c").has_value());
+    auto counters = cache.GetCounters();
+    EXPECT_EQ(counters.Entries, 2u);
+    EXPECT_EQ(counters.Evictions, 1u);
+    EXPECT_LE(counters.Bytes, 2500u);
+
+    // A newer result under the same text replaces the entry
+    cache.Insert("a", false, {"x", true});
+    EXPECT_TRUE(cache.Find("a")->Failed);
+    EXPECT_EQ(cache.GetCounters().Entries, 2u);
+    // Entries larger than the whole cache are not kept
+    cache.Insert("d", false, {std::string(3000, 'r')});
+    EXPECT_FALSE(cache.Find("d").has_value());
+    EXPECT_EQ(cache.GetCounters().Entries, 2u);
+}
+
+TEST_F(ServerTest, TestCacheFindsStructure) {
+    ResultCache cache{1 << 20};
+    cache.Insert("x+y", true, {"x+y"});
+    EXPECT_EQ(cache.Find(*parsed("y+x"))->Text, "x+y");
+    EXPECT_FALSE(cache.Find(*parsed("x+z")).has_value());
+    EXPECT_FALSE(cache.Find(*parsed("x-y")).has_value());
+
+    // The key of an entry that was replaced under its text is dropped with it
+    cache.Insert("x+y", false, {"other"});
+    EXPECT_FALSE(cache.Find(*parsed("y+x")).has_value());
+}
+
+TEST_F(ServerTest, TestCacheOutlivesText) {
+    ResultCache cache{1 << 20};
+    {
+        std::string text = "xyzw+abcd";
+        cache.Insert(text, true, {"r"});
+        text.assign(text.size(), '?');
+    }
+    const std::string other = "abcd+xyzw";
+    EXPECT_EQ(cache.Find(*parsed(other))->Text, "r");
+}
+
+TEST_F(ServerTest, TestDispatch) {
+    const auto answers = serve({.Threads = 2, .MaxBatch = 2, .CacheBytes = 1 << 20, .MaxQueue = 1},
+        "{\"id\":1,\"expr\":\"\\\\frac{2}{4}x\"}\n"
+        "{\"id\":\"b\",\"expr\":\"x\\\\cdot\\\\frac{1}{2}\"}\n"
+        "{\"id\":3,\"op\":\"simplify\",\"expr\":\"\\\\frac{2}{4}x\"}\n"
+        "\n"
+        "{\"id\":4,\"expr\":\"\\\\frac{1}{\"}\n"
+        "{\"id\":5,\"op\":\"solve\",\"expr\":\"x\"}\n"
+        "{\"id\":6,\"expr\":7}\n"
+        "not json\n"
+        "{\"id\":7,\"expr\":\"1+1\"}");
+    const std::vector<std::string> expected = {
+        R"({"error":"invalid request: expected a JSON object per line"})",
+        R"({"id":"b","result":"\\frac{1}{2}x"})",
+        R"({"id":1,"result":"\\frac{1}{2}x"})",
+        R"({"id":3,"result":"\\frac{1}{2}x"})",
+        R"({"id":4,"error":"Parser error: '}' not found"})",
+        R"({"id":5,"error":"unknown op: solve"})",
+        R"({"id":6,"error":"expr must be a string"})",
+        R"({"id":7,"result":"2"})"
+    };
+    EXPECT_EQ(answers, expected);
+
+    const auto stats = serve({}, R"({"op":"stats","id":null})" "\n");
+    ASSERT_EQ(stats.size(), 1u);
+    EXPECT_TRUE(stats[0].starts_with(R"({"id":null,"stats":{"uptime_s":)")) << stats[0];
+}
+
+TEST_F(ServerTest, TestReuseAcrossBatches) {
+    // One request per batch, so that the text of a request is freed before the next one
+    // finds its entry by structure
+    std::string input;
+    for (size_t i = 0; i < 20; ++i) {
+        input += fmt::format("{{\"id\":{},\"expr\":\"{}\"}}\n", i, i % 2 == 0 ? "xyzw+abcd" : "abcd+xyzw");
+    }
+    const auto answers = serve({.Threads = 1, .MaxBatch = 1, .CacheBytes = 1 << 20, .MaxQueue = 1}, input);
+    ASSERT_EQ(answers.size(), 20u);
+    for (const auto& answer : answers) {
+        EXPECT_TRUE(answer.ends_with(R"(,"result":"abcd+wxyz"})")) << answer;
+    }
+}
+
+TEST_F(ServerTest, TestBackpressure) {
+    // Several reads of input, so that the reader waits for the full queue in between
+    constexpr size_t REQUESTS = 10000;
+    std::string input;
+    for (size_t i = 0; i < REQUESTS; ++i) {
+        input += fmt::format("{{\"id\":{},\"expr\":\"{}+x\"}}\n", i, i % 50);
+    }
+    ASSERT_GT(input.size(), size_t{1} << 17);
+    const auto answers = serve({.Threads = 1, .MaxBatch = 4, .CacheBytes = 1 << 20, .MaxQueue = 8}, input);
+    ASSERT_EQ(answers.size(), REQUESTS);
+    EXPECT_EQ(answers.front(), R"({"id":0,"result":"x"})");
+}
+
+}